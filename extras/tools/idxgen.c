@@ -0,0 +1,244 @@
+/*
+ *                 ___________________  _______________ ___
+ *                 \__    ___/\_____  \ \_   _____/    |   \
+ *                   |    |    /   |   \ |    __) |    |   /
+ *                   |    |   /    |    \|     \  |    |  /
+ *                   |____|   \_______  /\___  /  |______/
+ *                                    \/     \/
+ *         ___________ _______    ________.___ _______  ___________
+ *         \_   _____/ \      \  /  _____/|   |\      \ \_   _____/
+ *          |    __)_  /   |   \/   \  ___|   |/   |   \ |    __)_
+ *          |        \/    |    \    \_\  \   /    |    \|        \
+ *         /_______  /\____|__  /\______  /___\____|__  /_______  /
+ *                 \/         \/        \/            \/        \
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2019-2024 Marco Lizza
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+// Converts a PNG image to the engine's indexed image format (`.idx`), so that the color-matching is performed offline
+// rather than when the image is loaded.
+//
+// Build with:
+//
+//     cc -std=c99 -O2 -I../../external -o idxgen idxgen.c -lm
+//
+// The palette file lists one `RRGGBB` hexadecimal color per line (e.g. as the `.hex` format of the Lospec palettes),
+// and should match the palette the image is to be used with. The matching algorithm mirrors the engine's default
+// `COLOR_MATCH_WEIGHTED` one.
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#include <stb/stb_image.h>
+
+#define MAX_PALETTE_COLORS 256
+
+#define INDEXED_IMAGE_SIGNATURE "TOFUIDX!"
+#define INDEXED_IMAGE_VERSION   0
+
+#define INDEXED_IMAGE_FLAG_PALETTE_HASH       0x01
+#define INDEXED_IMAGE_FLAG_TRANSPARENT_INDEX  0x02
+
+typedef struct color_s {
+    uint8_t r, g, b, a;
+} color_t;
+
+static size_t load_palette(color_t palette[MAX_PALETTE_COLORS], const char *path)
+{
+    FILE *stream = fopen(path, "rt");
+    if (!stream) {
+        return 0;
+    }
+
+    size_t size = 0;
+    char line[256];
+    while (size < MAX_PALETTE_COLORS && fgets(line, sizeof(line), stream)) {
+        const char *ptr = line;
+        while (isspace(*ptr) || *ptr == '#') {
+            ++ptr;
+        }
+        if (*ptr == '\0' || *ptr == ';') { // Skip empty lines and comments.
+            continue;
+        }
+        unsigned long rgb = strtoul(ptr, NULL, 16);
+        palette[size++] = (color_t){ .r = (rgb >> 16) & 0xFF, .g = (rgb >> 8) & 0xFF, .b = rgb & 0xFF, .a = 255 };
+    }
+
+    fclose(stream);
+
+    for (size_t i = size; size > 0 && i < MAX_PALETTE_COLORS; ++i) { // Pad as the engine does when creating palettes.
+        palette[i] = palette[size - 1];
+    }
+
+    return size;
+}
+
+// Must be kept in sync with `GL_palette_hash()`.
+static uint32_t palette_hash(const color_t palette[MAX_PALETTE_COLORS])
+{
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < MAX_PALETTE_COLORS; ++i) {
+        const uint8_t bytes[4] = { palette[i].r, palette[i].g, palette[i].b, palette[i].a };
+        for (size_t j = 0; j < 4; ++j) {
+            hash = (hash ^ bytes[j]) * 16777619U;
+        }
+    }
+    return hash;
+}
+
+// Must be kept in sync with `GL_matcher_match()`.
+static uint8_t find_nearest_color(const color_t palette[MAX_PALETTE_COLORS], color_t color)
+{
+    uint8_t index = 0;
+    float minimum = __FLT_MAX__;
+    for (size_t i = 0; i < MAX_PALETTE_COLORS; ++i) {
+        const color_t *current = &palette[i];
+
+        const float delta_r = (float)(color.r - current->r);
+        const float delta_g = (float)(color.g - current->g);
+        const float delta_b = (float)(color.b - current->b);
+
+        const float r_mean = (float)(color.r + current->r) * 0.5f;
+
+        const float distance = (delta_r * delta_r) * (2.0f + (r_mean / 255.0f))
+            + (delta_g * delta_g) * 4.0f
+            + (delta_b * delta_b) * (2.0f + ((255.0f - r_mean) / 255.0f));
+
+        if (minimum > distance) {
+            minimum = distance;
+            index = (uint8_t)i;
+        }
+    }
+    return index;
+}
+
+static void write_u32(uint8_t *ptr, uint32_t value)
+{
+    ptr[0] = value & 0xFF;
+    ptr[1] = (value >> 8) & 0xFF;
+    ptr[2] = (value >> 16) & 0xFF;
+    ptr[3] = (value >> 24) & 0xFF;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [-t index] [-a threshold] <palette.hex> <input.png> <output.idx>\n", program);
+    fprintf(stderr, "  -t index      palette index for the transparent pixels (default: 0)\n");
+    fprintf(stderr, "  -a threshold  pixels with alpha not above this are transparent (default: 0)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int transparent = 0;
+    int threshold = 0;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc) {
+            transparent = atoi(argv[++arg]);
+        } else
+        if (strcmp(argv[arg], "-a") == 0 && arg + 1 < argc) {
+            threshold = atoi(argv[++arg]);
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (argc - arg != 3 || transparent < 0 || transparent >= MAX_PALETTE_COLORS) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    color_t palette[MAX_PALETTE_COLORS];
+    size_t size = load_palette(palette, argv[arg]);
+    if (size == 0) {
+        fprintf(stderr, "can't load palette `%s`\n", argv[arg]);
+        return EXIT_FAILURE;
+    }
+
+    int width, height, components;
+    stbi_uc *pixels = stbi_load(argv[arg + 1], &width, &height, &components, STBI_rgb_alpha);
+    if (!pixels) {
+        fprintf(stderr, "can't load image `%s`: %s\n", argv[arg + 1], stbi_failure_reason());
+        return EXIT_FAILURE;
+    }
+
+    const size_t count = (size_t)width * (size_t)height;
+    uint8_t *indexes = malloc(count);
+    if (!indexes) {
+        stbi_image_free(pixels);
+        return EXIT_FAILURE;
+    }
+
+    color_t last = { 0 };
+    uint8_t last_index = find_nearest_color(palette, last);
+    for (size_t i = 0; i < count; ++i) {
+        const stbi_uc *rgba = pixels + i * 4;
+        color_t color = (color_t){ .r = rgba[0], .g = rgba[1], .b = rgba[2], .a = rgba[3] };
+        if (color.a <= threshold) {
+            indexes[i] = (uint8_t)transparent;
+            continue;
+        }
+        if (memcmp(&color, &last, sizeof(color_t)) != 0) { // Runs of the same color are common, reuse the last match.
+            last = color;
+            last_index = find_nearest_color(palette, color);
+        }
+        indexes[i] = last_index;
+    }
+    stbi_image_free(pixels);
+
+    uint8_t header[24] = { 0 };
+    memcpy(header, INDEXED_IMAGE_SIGNATURE, 8);
+    header[8] = INDEXED_IMAGE_VERSION;
+    header[9] = INDEXED_IMAGE_FLAG_PALETTE_HASH | INDEXED_IMAGE_FLAG_TRANSPARENT_INDEX;
+    header[10] = (uint8_t)transparent;
+    write_u32(header + 12, (uint32_t)width);
+    write_u32(header + 16, (uint32_t)height);
+    write_u32(header + 20, palette_hash(palette));
+
+    FILE *stream = fopen(argv[arg + 2], "wb");
+    if (!stream) {
+        fprintf(stderr, "can't create file `%s`\n", argv[arg + 2]);
+        free(indexes);
+        return EXIT_FAILURE;
+    }
+    bool written = fwrite(header, sizeof(header), 1, stream) == 1 && fwrite(indexes, count, 1, stream) == 1;
+    fclose(stream);
+    free(indexes);
+
+    if (!written) {
+        fprintf(stderr, "can't write file `%s`\n", argv[arg + 2]);
+        return EXIT_FAILURE;
+    }
+
+    printf("image `%s` (%dx%d) converted against %zu color(s) palette\n", argv[arg + 1], width, height, size);
+
+    return EXIT_SUCCESS;
+}
@@ -41,6 +41,7 @@ SOFTWARE.
 --  1 argparse
 --  2 luafilesystem
 --  3 luazen
+--  4 lua-zlib (only when compressing)
 
 --[[
 +---------+
@@ -75,12 +76,21 @@ NOTE: `uint16_t` and `uint32_t` data are explicitly stored in little-endian.
 local argparse = require("argparse")
 local lfs = require("lfs")
 local luazen = require("luazen")
+local zlib = nil -- Lazily required, only when compressing.
 
 local HEADER_SIZE <const> = 8 + 1 + 1 + 2 + 4
-local ENTRY_HEADER_SIZE <const> = 16 + 4 + 4
+local ENTRY_HEADER_SIZE <const> = 16 + 4 + 4 + 4 + 1 + 3
 
-local VERSION <const> = 0x00
+local VERSION <const> = 0x01
 local RESERVED_16b <const> = 0xFFFF
+local RESERVED_24b <const> = 0xFFFFFF
+
+local COMPRESSION_NONE <const> = 0
+local COMPRESSION_DEFLATE <const> = 1
+
+-- Compression is kept only when it saves at least this fraction of the file size, otherwise the file is stored
+-- as-is and read w/o inflating it (which is faster).
+local COMPRESSION_THRESHOLD <const> = 0.9
 
 function string:at(index)
   return self:sub(index, index)
@@ -145,6 +155,75 @@ local function attrdir(path, name, files)
   return files
 end
 
+local function read_file(file)
+  if file.data then -- Generated, in memory.
+    return file.data
+  end
+
+  local reader = io.open(file.pathfile, "rb")
+  if not reader then
+    print(string.format("*** can't access file `%s`", file.pathfile))
+    return nil
+  end
+  local data = reader:read("a")
+  reader:close()
+  return data
+end
+
+local function compress_file(file)
+  local data = read_file(file)
+  if not data then
+    return false
+  end
+
+  if not zlib then
+    zlib = require("zlib")
+  end
+
+  local deflated = zlib.deflate(zlib.BEST_COMPRESSION)(data, "finish")
+  if #deflated < file.size * COMPRESSION_THRESHOLD then
+    file.compression = COMPRESSION_DEFLATE
+    file.stored_size = #deflated
+    file.payload = deflated
+  end
+
+  return true
+end
+
+-- Lua sources are compiled to (stripped) bytecode, which is stored alongside the source with the `.luac` extension.
+-- The engine loads the bytecode in place of the source when compatible with its VM, that is when the same Lua version
+-- of this script has been used.
+local function compile_files(flags, files)
+  if not flags.quiet then
+    print(string.format("Compiling w/ %s...", _VERSION))
+  end
+
+  local compiled = {}
+  for _, file in ipairs(files) do
+    if file.name:ends_with(".lua") then
+      local source = read_file(file)
+      if not source then
+        return false
+      end
+
+      local chunk, message = load(source, "@" .. file.name, "t")
+      if not chunk then
+        print(string.format("*** can't compile file `%s`: %s", file.pathfile, message))
+        return false
+      end
+
+      local bytecode = string.dump(chunk, true)
+      table.insert(compiled, { pathfile = file.pathfile, name = file.name .. "c", size = #bytecode, data = bytecode })
+    end
+  end
+
+  for _, file in ipairs(compiled) do
+    table.insert(files, file)
+  end
+
+  return true
+end
+
 local function optimize_files(flags, files)
   local hash = {}
 
@@ -166,8 +245,17 @@ local function optimize_files(flags, files)
 
     file.id = luazen.md5(file.name)
     file.offset = offset
+    file.compression = COMPRESSION_NONE
+    file.stored_size = file.size
 
-    offset = offset + file.size
+    if flags.compressed and file.size > 0 then
+      local done = compress_file(file)
+      if not done then
+        return false
+      end
+    end
+
+    offset = offset + file.stored_size
   end
 
   return true
@@ -238,16 +326,21 @@ follower by its content, as a sequence of bytes.
 Note that the offset of the entry in the file is not stored, as it is automatically
 calculated during the indexing process.
 
-+--------+--------+----------+-----------------------------------------------------------+
-+ OFFSET |  SIZE  | NAME     | DESCRIPTION                                               |
-+--------+--------+----------+-----------------------------------------------------------+
-+    0   |   16   | id       | entry ID (MD5 of the filename)                            |
-+   16   |    4   | offset   | absolute position of the entry within the archive         |
-+   20   |    4   | size     | length (in bytes) of the entry                            |
-+--------+--------+----------+-----------------------------------------------------------+
-         |   24   |
++--------+--------+-------------+--------------------------------------------------------+
++ OFFSET |  SIZE  | NAME        | DESCRIPTION                                            |
++--------+--------+-------------+--------------------------------------------------------+
++    0   |   16   | id          | entry ID (MD5 of the filename)                         |
++   16   |    4   | offset      | absolute position of the entry within the archive      |
++   20   |    4   | size        | length (in bytes) of the entry, once uncompressed      |
++   24   |    4   | stored_size | length (in bytes) of the entry within the archive      |
++   28   |    1   | compression | `0` for none, `1` for deflate (w/ zlib wrapper)        |
++   29   |    3   | padding     | reserved for future uses                               |
++--------+--------+-------------+--------------------------------------------------------+
+         |   32   |
          +--------+
 
+When both compressed and encrypted, the entry is compressed first.
+
 ]]
 local function emit_directory(writer, flags, files)
   -- Create a copy, we don't want to sort the files table so that we don't mess
@@ -271,21 +364,32 @@ local function emit_directory(writer, flags, files)
     writer:write(string.pack("c16", entry.id))
     writer:write(string.pack("<I4", entry.offset))
     writer:write(string.pack("<I4", entry.size))
+    writer:write(string.pack("<I4", entry.stored_size))
+    writer:write(string.pack("I1", entry.compression))
+    writer:write(string.pack("<I3", RESERVED_24b))
   end
 
   return true
 end
 
 local function emit_entry(writer, flags, file)
+  local key <const> = luazen.md5(file.id)
+  local cipher = flags.encrypted and xor_cipher(key) or null_cipher(key)
+
+  local payload = file.payload or file.data -- Either compressed or generated, in memory.
+  if payload then
+    for i = 1, #payload, 8196 do
+      writer:write(cipher(payload:sub(i, i + 8195)))
+    end
+    return true
+  end
+
   local reader = io.open(file.pathfile, "rb")
   if not reader then
     print(string.format("*** can't access file `%s`", file.pathfile))
     return false
   end
 
-  local key <const> = luazen.md5(file.id)
-  local cipher = flags.encrypted and xor_cipher(key) or null_cipher(key)
-
   while true do
     local block = reader:read(8196)
     if not block then
@@ -313,8 +417,8 @@ local function emit_entries(writer, flags, files)
 
     if not flags.quiet then
       if flags.detailed then
-        print(string.format("> file `%s`\n  name: `%s`\n  id: `%s`\n  offset: %d\n  size: %d",
-          file.pathfile, file.name, string.to_hex(file.id), offset, file.size))
+        print(string.format("> file `%s`\n  name: `%s`\n  id: `%s`\n  offset: %d\n  size: %d\n  stored: %d",
+          file.pathfile, file.name, string.to_hex(file.id), offset, file.size, file.stored_size))
       else
         print(string.format("[%04x] `%s` -> `%s`",
           index, string.to_hex(file.id), file.name))
@@ -326,6 +430,13 @@ local function emit_entries(writer, flags, files)
 end
 
 local function emit(output, flags, files)
+  if flags.bytecode then
+    local compiled = compile_files(flags, files)
+    if not compiled then
+      return false
+    end
+  end
+
   local optimized = optimize_files(flags, files)
   if not optimized then
     return false
@@ -384,15 +495,19 @@ local function main(arg)
     :description("Tells whether the package should be encrypted.")
   parser:flag("-s --sorted")
     :description("Tells whether the package should be sorted.")
+  parser:flag("-c --compressed")
+    :description("Tells whether the package entries should be compressed (when worth it).")
+  parser:flag("-b --bytecode")
+    :description("Tells whether the Lua sources should be also stored as precompiled bytecode.")
   local args = parser:parse(arg)
 
   local flags = {}
-  for _, flag in ipairs({ "quiet", "detailed", "encrypted", "sorted" }) do
+  for _, flag in ipairs({ "quiet", "detailed", "encrypted", "sorted", "compressed", "bytecode" }) do
     flags[flag] = args[flag] and true or false
   end
 
   if not flags.quiet then
-    print("PakGen v0.7.0")
+    print("PakGen v0.9.0")
     print("=============")
   end
 
@@ -84,6 +84,33 @@
 //       some sound data is to be played.
 #define TOFU_AUDIO_AUTOSTART_GRACE_PERIOD 30.0
 
+// The game and the audio device threads don't share any lock. The changes to
+// the set of the active sources (and to the mixing groups) are posted by the
+// game as commands in a lock-free queue, applied by the audio device on its
+// next callback. This macro sets the amount of commands the queue can hold;
+// should the queue be full the game waits for the device to catch up.
+#define TOFU_AUDIO_COMMANDS_CAPACITY 256
+
+// The streamed sources (i.e. musics and modules) are decoded by a dedicated
+// thread, that keeps their buffers filled regardless of the game-loop pace.
+// This macro sets the period (in seconds) the decoder thread checks the
+// buffers to refill them.
+#define TOFU_AUDIO_DECODER_PERIOD 0.01
+
+// Samples are fully decoded when created, and the decoded data is shared among
+// all the samples created from the same file. The data is kept cached even
+// when no longer used, so that the next sample can be created w/o decoding
+// it again. This macro sets the amount of time (in seconds) an unused data is
+// kept in the cache before being released.
+#define TOFU_AUDIO_SAMPLES_CACHE_TIMEOUT 30.0f
+
+// Playing a sample (on a cache hit) doesn't require any allocation, as the
+// sample structures are taken from a pool and put back into it once the
+// sample is destroyed. This macro sets the amount of samples the pool holds,
+// all of them allocated upfront. Should the pool be depleted, new samples are
+// allocated (and eventually recycled, as long as the pool has room).
+#define TOFU_AUDIO_SAMPLES_POOL_SIZE 32
+
 // ###############
 // ### Display ###
 // ###############
@@ -203,6 +230,17 @@
 // override/redefine its implementation.
 #define TOFU_FILE_SUPPORT_MOUNT_OVERRIDE
 
+// When defined, the folders attached to the `File` sub-system are watched for
+// changes (currently, only on Linux by means of `inotify`). The cached copies
+// of the changed files are discarded, so that the next load will fetch the
+// updated content, and the game is notified with the `reload()` entry-point
+// method, receiving the list of the changed file names. This enables the
+// assets to be edited while the game is running.
+//
+// Note: the feature is meant for development only, and it's disabled in the
+//       `RELEASE` build.
+#define TOFU_FILE_HOT_RELOAD
+
 // ################
 // ### Graphics ###
 // ################
@@ -249,6 +287,32 @@
 // performances.
 #define TOFU_GRAPHICS_OPTIMIZED_ROTATIONS
 
+// Rotated blits rasterize the destination area in small square tiles, using
+// fixed-point arithmetic. Tiles that are completely outside the (rotated)
+// source rectangle are skipped, and the ones completely inside are drawn with
+// no bounds check. This keeps the source access local, and it's much more
+// cache friendly for large sprites.
+#define TOFU_GRAPHICS_TILED_ROTATIONS
+
+// Enables the vectorized (SSE2 or NEON, according to the target architecture)
+// code-path of the (non-scaled, non-rotated) blitting function. It is used when
+// the shifting table is the identity and only few colors are transparent (the
+// usual case). When the target doesn't support any of the instruction-sets the
+// plain scalar implementation is used.
+#define TOFU_GRAPHICS_VECTORIZED_BLIT
+
+// Enables the vectorized (SSE2) code-path of the palette color matcher, that
+// compares a color against four palette entries at once. The outcome is the
+// very same of the scalar implementation, which is used when the target
+// doesn't support the instruction-set.
+#define TOFU_GRAPHICS_VECTORIZED_MATCH
+
+// When enabled, the display canvas keeps track of the areas modified by the
+// drawing operations, in order to convert and upload to the GPU only those
+// areas. It greatly helps when the screen is mostly static (e.g. menus and
+// tools), and it's ineffective when a (copper) program is in use.
+#define TOFU_GRAPHICS_DIRTY_TRACKING
+
 // During the loading process, a PNG image is "palettized", that is for every
 // pixel is determined the index of the palette color that best matches it. To
 // speed the process up a *memoization* (hash) table can ben used so that for
@@ -356,13 +420,12 @@
 // as additional checks are introduced as a side-effect.
 #undef  TOFU_INTERPRETER_PARTIAL_OBJECT
 
-// As the game-engine uses a Lua custom reader we have to freedom to set the
-// the I/O buffer with any size we like. If not defined, a default value of
-// 1024 bytes is used.
-//
-// Note: the buffer is used to read Lua code, which typically is not that
-//       large. Using huge buffers is pointless.
-#define TOFU_INTERPRETER_READER_BUFFER_SIZE 1024U
+// When enabled, the interpreter looks for a precompiled (`.luac`) version of
+// each module before the source one, and loads it if it's compatible with the
+// VM (otherwise the source is used). Outside archives the precompiled module
+// is ignored when its source is newer. The precompiled modules can be generated
+// with the `--bytecode` option of the `pakgen` tool.
+#define TOFU_INTERPRETER_PRECOMPILED_MODULES
 
 // #############
 // ### Input ###
@@ -424,6 +487,12 @@
 // leave this disabled.
 #undef  TOFU_SOUND_MUSIC_PRELOAD
 
+// Enables the vectorized (SSE2 or NEON, according to the target architecture)
+// code-path of the mixing functions, that process eight frames at once. When
+// the target doesn't support any of the instruction-sets the plain scalar
+// implementation is used.
+#define TOFU_SOUND_VECTORIZED_MIX
+
 // ##############
 // ### Script ###
 // ##############
@@ -439,12 +508,13 @@
 
 // When the storage sub-system loads a resource into memory, it is put into a
 // cache in order to speed-up further accesses. This value controls the total
-// number of entries that can coexist in the cache; when a new resource is
-// loaded *but* the threshold is exceeded the older entry is discarded.
+// amount of memory (in bytes) that the cached entries can occupy; when a new
+// resource is loaded *but* the budget is exceeded the least recently used
+// entries are discarded. A zero value disables the limit.
 //
-// There's generally no need for a large cache as the resources are typically
-// accessed only once and processed according to their respective format.
-#define TOFU_STORAGE_CACHE_ENTRIES_LIMIT 32U
+// The value can be overridden with the `storage-cache-budget` configuration
+// entry.
+#define TOFU_STORAGE_CACHE_BUDGET (16U * 1024U * 1024U)
 
 // When a resource is loaded and stored in the cache, unless the cache reaches
 // its limit and the resource freed to make room for another one, it will
@@ -474,6 +544,11 @@
 // resources are to be freed with the `Storage.flush()` API.
 #define TOFU_STORAGE_AUTO_COLLECT
 
+// Resources can be preloaded in background, in order to keep the game running
+// (e.g. animating a loading screen) in the meanwhile. This macro controls the
+// amount of threads dedicated to reading and decoding the resources.
+#define TOFU_STORAGE_PRELOAD_THREADS 2
+
 // In release build, disable VM calls debug and periodic collection for better
 // performance.
 #if defined(NDEBUG)
@@ -482,6 +557,7 @@
   #undef TOFU_ENGINE_PERFORMANCE_STATISTICS
   #undef TOFU_ENGINE_HEAP_STATISTICS
   #undef TOFU_FILE_DEBUG_ENABLED
+  #undef TOFU_FILE_HOT_RELOAD
   #undef TOFU_GRAPHICS_REPORT_SHADERS_ERRORS
   #undef TOFU_INTERPRETER_PROTECTED_CALLS
   #undef TOFU_INTERPRETER_GC_MODE GC_MODE_MANUAL
@@ -39,6 +39,7 @@
 
 #include "resolution.h"
 
+#include <core/config.h>
 #include <core/version.h>
 #include <libs/imath.h>
 #define _LOG_TAG "configuration"
@@ -116,12 +117,31 @@ static void _on_parameter(Configuration_t *configuration, const char *context, c
     if (strcmp(fqn, "display-effect") == 0) {
         strncpy(configuration->display.effect, value, CONFIGURATION_MAX_VALUE_LENGTH - 1);
     } else
+    if (strcmp(fqn, "display-pixel-buffers") == 0) {
+        configuration->display.pixel_buffers = (size_t)strtoul(value, NULL, 0);
+    } else
     if (strcmp(fqn, "audio-device-index") == 0) {
         configuration->audio.device_index = (int)strtol(value, NULL, 0);
     } else
     if (strcmp(fqn, "audio-master-volume") == 0) {
         configuration->audio.master_volume = (float)strtod(value, NULL);
     } else
+    if (strcmp(fqn, "audio-voices") == 0) {
+        size_t voices = (size_t)strtoul(value, NULL, 0);
+        if (voices > 0) {
+            configuration->audio.voices = voices;
+        } else {
+            LOG_W("invalid voices amount `%s`, keeping %d", value, configuration->audio.voices);
+        }
+    } else
+    if (strcmp(fqn, "audio-sources") == 0) {
+        size_t sources = (size_t)strtoul(value, NULL, 0);
+        if (sources > 0) {
+            configuration->audio.sources = sources;
+        } else {
+            LOG_W("invalid sources amount `%s`, keeping %d", value, configuration->audio.sources);
+        }
+    } else
     if (strcmp(fqn, "keyboard-exit-key") == 0) {
         configuration->keyboard.exit_key = strcmp(value, "true") == 0;
     } else
@@ -151,6 +171,12 @@ static void _on_parameter(Configuration_t *configuration, const char *context, c
     } else
     if (strcmp(fqn, "engine-low-priority-frames-per-seconds") == 0) {
         configuration->engine.low_priority_frames_per_seconds = (size_t)strtoul(value, NULL, 0);
+    } else
+    if (strcmp(fqn, "engine-workers") == 0) {
+        configuration->engine.workers = (size_t)strtoul(value, NULL, 0);
+    } else
+    if (strcmp(fqn, "storage-cache-budget") == 0) {
+        configuration->storage.cache_budget = (size_t)strtoul(value, NULL, 0);
     }
 }
 
@@ -272,11 +298,14 @@ Configuration_t *Configuration_create(const char *data)
                 .scale = 0,
                 .fullscreen = false,
                 .vertical_sync = false,
-                .effect = "assets/glsl/passthru.glsl"
+                .effect = "assets/glsl/passthru.glsl",
+                .pixel_buffers = 0 // Synchronous upload.
             },
             .audio = {
                 .device_index = -1, // Pick the default device.
-                .master_volume = 1.0f
+                .master_volume = 1.0f,
+                .voices = 32,
+                .sources = 128
             },
             .keyboard = {
                 .exit_key = true
@@ -294,7 +323,11 @@ Configuration_t *Configuration_create(const char *data)
                 .frames_per_seconds = 60,
                 .low_priority_frames_per_seconds = 120, // Twice the engine FPS count.
                 .skippable_frames = 3, // About 5% of the FPS amount.
-                .frames_limit = 60
+                .frames_limit = 60,
+                .workers = 0 // Use every available CPU core.
+            },
+            .storage = {
+                .cache_budget = TOFU_STORAGE_CACHE_BUDGET
             }
         };
 
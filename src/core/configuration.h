@@ -66,10 +66,13 @@ typedef struct Configuration_s {
         bool fullscreen;
         bool vertical_sync;
         char effect[CONFIGURATION_MAX_VALUE_LENGTH];
+        size_t pixel_buffers;
     } display;
     struct {
         int device_index;
         float master_volume;
+        size_t voices; // Sources mixed at once, the exceeding ones are virtualized.
+        size_t sources; // Sources tracked at once, the lowest ranked ones are dropped when exceeding.
     } audio;
     struct {
         bool exit_key; // TODO: enum type with disabled/notify/autoclose?
@@ -88,7 +91,11 @@ typedef struct Configuration_s {
         size_t low_priority_frames_per_seconds;
         size_t skippable_frames;
         size_t frames_limit;
+        size_t workers;
     } engine;
+    struct {
+        size_t cache_budget;
+    } storage;
 } Configuration_t;
 
 extern Configuration_t *Configuration_create(const char *data);
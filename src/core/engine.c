@@ -214,6 +214,8 @@ Engine_t *Engine_create(const Engine_Options_t *options)
     }
     LOG_D("identity set to `%s`", engine->configuration->system.identity);
 
+    Storage_set_cache_budget(engine->storage, engine->configuration->storage.cache_budget);
+
     const Storage_Resource_t *icon = Storage_load(engine->storage, engine->configuration->system.icon, STORAGE_RESOURCE_IMAGE);
     if (!icon) {
         LOG_F("can't load icon");
@@ -250,7 +252,9 @@ Engine_t *Engine_create(const Engine_Options_t *options)
             .fullscreen = engine->configuration->display.fullscreen,
             .vertical_sync = engine->configuration->display.vertical_sync,
             .quit_on_close = engine->configuration->system.quit_on_close,
-            .effect = SR_SCHARS(effect)
+            .effect = SR_SCHARS(effect),
+            .pixel_buffers = engine->configuration->display.pixel_buffers,
+            .workers = engine->configuration->engine.workers
         });
     if (!engine->display) {
         LOG_F("can't create display");
@@ -297,7 +301,9 @@ Engine_t *Engine_create(const Engine_Options_t *options)
 
     engine->audio = Audio_create(&(const Audio_Configuration_t){
             .device_index = engine->configuration->audio.device_index,
-            .master_volume = engine->configuration->audio.master_volume
+            .master_volume = engine->configuration->audio.master_volume,
+            .voices = engine->configuration->audio.voices,
+            .sources = engine->configuration->audio.sources
         });
     if (!engine->audio) {
         LOG_F("can't initialize audio");
@@ -385,12 +391,29 @@ static inline bool _high_priority_update(Engine_t *engine, float delta_time)
             ;
 }
 
+#if defined(TOFU_FILE_HOT_RELOAD)
+static inline bool _reload(Engine_t *engine)
+{
+    size_t count;
+    bool lost;
+    const char **names = Storage_get_changes(engine->storage, &count, &lost);
+    if (lost) {
+        Audio_forget_pcm(engine->audio, NULL); // Anything could have changed.
+    }
+    for (size_t i = 0; i < count; ++i) {
+        Audio_forget_pcm(engine->audio, names[i]); // Decode again on next use, samples still playing keep the old data.
+    }
+    return (count == 0 && !lost) || Interpreter_reload(engine->interpreter, names, count, lost); // Notify only when something changed.
+}
+#endif  /* TOFU_FILE_HOT_RELOAD */
+
 static inline bool _low_priority_update(Engine_t *engine, float delta_time)
 {
     return Audio_update(engine->audio, delta_time)
-#if defined(TOFU_STORAGE_AUTO_COLLECT)
             && Storage_update(engine->storage, delta_time)
-#endif  /* TOFU_STORAGE_AUTO_COLLECT */
+#if defined(TOFU_FILE_HOT_RELOAD)
+            && _reload(engine) // Right after the storage update, which detects the changed files.
+#endif  /* TOFU_FILE_HOT_RELOAD */
             ;
 }
 
@@ -415,7 +438,7 @@ void Engine_run(Engine_t *engine)
     LOG_I("now running, update-time is %.6fs w/ %d skippable frames, reference-time is %.6fs", delta_time, skippable_frames, reference_time);
 
 #if defined(TOFU_ENGINE_PERFORMANCE_STATISTICS)
-    float deltas[5] = { 0 };
+    float deltas[6] = { 0 };
 #endif  /* TOFU_ENGINE_PERFORMANCE_STATISTICS */
     StopWatch_t marker = stopwatch_init();
     float lag = 0.0f;
@@ -487,6 +510,7 @@ void Engine_run(Engine_t *engine)
 
 #if defined(TOFU_ENGINE_PERFORMANCE_STATISTICS)
         deltas[2] = stopwatch_partial(&stats_marker);
+        deltas[5] = engine->display->conversion_time; // Already included in the rendering time.
 #endif  /* TOFU_ENGINE_PERFORMANCE_STATISTICS */
 
         const float busy_time = stopwatch_elapsed(&marker);
@@ -66,6 +66,15 @@
     #define PLATFORM_LITTLE_ENDIAN
 #endif
 
+// Vector instruction-sets availability is detected from the compiler predefined
+// macros, so that it follows the target architecture and the compiler flags
+// (e.g. `-mfpu=neon` on 32-bit ARM builds).
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PLATFORM_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define PLATFORM_SIMD_NEON
+#endif
+
 #if defined(_WIN32) || defined(_WIN64)
     #define PLATFORM_ID PLATFORM_WINDOWS // Windows
     #define PLATFORM_NAME "Windows"
@@ -70,6 +70,11 @@ function Boot:__ctor()
         end,
       render = function(me, ratio)
           me.main:render(ratio)
+        end,
+      reload = function(me, names, lost)
+          if me.main.reload then -- Optional, the game could ignore the changes.
+            me.main:reload(names, lost) -- When `lost` is `true` anything could have changed, reload everything.
+          end
         end
     },
     ["error"] = {
@@ -159,6 +164,14 @@ function Boot:render(ratio)
   self:call(me.render, me, ratio)
 end
 
+function Boot:reload(names, lost)
+  local me = self.state
+  if not me or not me.reload then -- The error state doesn't reload anything.
+    return
+  end
+  self:call(me.reload, me, names, lost)
+end
+
 function Boot:switch_if_needed()
   if not next(self.queue) then
     return
@@ -35,10 +35,36 @@
 #include <libs/path.h>
 #include <libs/stb.h>
 
+#include <pthread.h>
+
+// Maps a name to the mount it has been found into, or to `NULL` when no mount contains it.
+typedef struct FS_Location_s {
+    char *key;
+    const FS_Mount_t *value;
+} FS_Location_t;
+
 struct FS_Context_s {
     FS_Mount_t **mounts;
+    struct {
+        FS_Location_t *map;
+        size_t generation;
+        pthread_mutex_t lock; // Handles can be opened from the storage loader threads.
+    } locations;
 };
 
+static void _forget(FS_Context_t *context, const char *name)
+{
+    pthread_mutex_lock(&context->locations.lock);
+    if (name) {
+        (void)shdel(context->locations.map, name);
+    } else {
+        shfree(context->locations.map);
+        sh_new_strdup(context->locations.map); // Names are transient, the map needs to own a copy of them.
+    }
+    context->locations.generation += 1;
+    pthread_mutex_unlock(&context->locations.lock);
+}
+
 FS_Context_t *FS_create(void)
 {
     FS_Context_t *context = malloc(sizeof(FS_Context_t));
@@ -49,6 +75,9 @@ FS_Context_t *FS_create(void)
 
     *context = (FS_Context_t){ 0 };
 
+    sh_new_strdup(context->locations.map); // Names are transient, the map needs to own a copy of them.
+    pthread_mutex_init(&context->locations.lock, NULL);
+
     return context;
 }
 
@@ -64,6 +93,10 @@ void FS_destroy(FS_Context_t *context)
     arrfree(context->mounts);
     LOG_D("context mount(s) freed");
 
+    shfree(context->locations.map);
+    pthread_mutex_destroy(&context->locations.lock);
+    LOG_D("context locations freed");
+
     free(context);
     LOG_D("context freed");
 }
@@ -71,7 +104,7 @@ void FS_destroy(FS_Context_t *context)
 bool FS_attach_folder_or_archive(FS_Context_t *context, const char *path)
 {
     if (FS_std_is_valid(path)) {
-        return FS_attach_folder(context, path);
+        return FS_attach_folder(context, path, true);
     } else 
     if (FS_pak_is_valid(path)) {
         return FS_attach_archive(context, path);
@@ -81,14 +114,14 @@ bool FS_attach_folder_or_archive(FS_Context_t *context, const char *path)
     }
 }
 
-bool FS_attach_folder(FS_Context_t *context, const char *path)
+bool FS_attach_folder(FS_Context_t *context, const char *path, bool watched)
 {
     if (!FS_std_is_valid(path)) {
         LOG_D("path `%s` is not a folder", path);
         return false;
     }
 
-    FS_Mount_t *mount = FS_std_mount(path); // Path need to be already resolved.
+    FS_Mount_t *mount = FS_std_mount(path, watched); // Path need to be already resolved.
     if (!mount) {
         LOG_E("can't attach archive `%s`", path);
         return false;
@@ -96,6 +129,8 @@ bool FS_attach_folder(FS_Context_t *context, const char *path)
 
     arrpush(context->mounts, mount);
 
+    _forget(context, NULL); // The new mount could contain (or override) any name.
+
     return true;
 }
 
@@ -114,6 +149,8 @@ bool FS_attach_archive(FS_Context_t *context, const char *path)
 
     arrpush(context->mounts, mount);
 
+    _forget(context, NULL); // The new mount could contain (or override) any name.
+
     return true;
 }
 
@@ -127,10 +164,51 @@ bool FS_attach_from_callbacks(FS_Context_t *context, FS_Callbacks_t callbacks, v
 
     arrpush(context->mounts, mount);
 
+    _forget(context, NULL); // The new mount could contain (or override) any name.
+
     return true;
 }
 
-static const FS_Mount_t *_locate(const FS_Context_t *context, const char *name)
+// To be called when the content of a mount changes after it has been attached (e.g. a file is written).
+void FS_invalidate(FS_Context_t *context, const char *name)
+{
+    _forget(context, name);
+}
+
+typedef struct Poll_Closure_s {
+    FS_Context_t *context;
+    FS_Poll_Callback_t callback;
+    void *user_data;
+} Poll_Closure_t;
+
+static void _changed(void *user_data, const char *name)
+{
+    const Poll_Closure_t *closure = (const Poll_Closure_t *)user_data;
+
+    _forget(closure->context, name); // The file could have been created or deleted, refresh its location.
+
+    closure->callback(closure->user_data, name);
+}
+
+// Collects the changes reported by the mounts that support it (i.e. the watched folders) since the previous call.
+void FS_poll(FS_Context_t *context, FS_Poll_Callback_t callback, void *user_data)
+{
+    Poll_Closure_t closure = (Poll_Closure_t){
+            .context = context,
+            .callback = callback,
+            .user_data = user_data
+        };
+
+    FS_Mount_t **current = context->mounts;
+    for (size_t count = arrlenu(context->mounts); count; --count) {
+        FS_Mount_t *mount = *(current++);
+        if (mount->vtable.poll) {
+            mount->vtable.poll(mount, _changed, &closure);
+        }
+    }
+}
+
+static const FS_Mount_t *_scan(const FS_Context_t *context, const char *name)
 {
 #if defined(TOFU_FILE_SUPPORT_MOUNT_OVERRIDE)
     // Backward scan, later mounts gain priority over existing ones.
@@ -147,12 +225,54 @@ static const FS_Mount_t *_locate(const FS_Context_t *context, const char *name)
     return NULL;
 }
 
-bool FS_exists(const FS_Context_t *context, const char *name)
+// Probing the mounts means hitting the file-system for each of them (and often failing, as `require()` does), so the
+// outcome of each scan is memoized. Misses are memoized too, as a `NULL` mount.
+static const FS_Mount_t *_locate(FS_Context_t *context, const char *name)
+{
+    pthread_mutex_lock(&context->locations.lock);
+    ptrdiff_t index = shgeti(context->locations.map, name);
+    if (index != -1) {
+        const FS_Mount_t *mount = context->locations.map[index].value;
+        pthread_mutex_unlock(&context->locations.lock);
+        return mount;
+    }
+    size_t generation = context->locations.generation;
+    pthread_mutex_unlock(&context->locations.lock);
+
+    const FS_Mount_t *mount = _scan(context, name); // Don't hold the lock while probing, it could take a while.
+
+    pthread_mutex_lock(&context->locations.lock);
+    if (generation == context->locations.generation) { // Discard the outcome if invalidated in the meanwhile.
+        shput(context->locations.map, name, mount);
+    }
+    pthread_mutex_unlock(&context->locations.lock);
+
+    return mount;
+}
+
+bool FS_exists(FS_Context_t *context, const char *name)
 {
     return _locate(context, name) != NULL;
 }
 
-FS_Handle_t *FS_open(const FS_Context_t *context, const char *name)
+// Retrieves the last modification time of the file. Files from immutable mounts (i.e. archives) have a `0` stamp.
+bool FS_stamp(FS_Context_t *context, const char *name, time_t *stamp)
+{
+    const FS_Mount_t *mount = _locate(context, name);
+
+    if (!mount) {
+        return false;
+    }
+
+    if (!mount->vtable.stamp) {
+        *stamp = 0;
+        return true;
+    }
+
+    return mount->vtable.stamp(mount, name, stamp);
+}
+
+FS_Handle_t *FS_open(FS_Context_t *context, const char *name)
 {
     const FS_Mount_t *mount = _locate(context, name);
 
@@ -193,3 +313,10 @@ bool FS_eof(FS_Handle_t *handle)
 {
     return handle->vtable.eof(handle);
 }
+
+// Returns the whole (`FS_size()` bytes long) content of the handle, if it is available in memory as-is (e.g. a plain
+// entry of a memory-mapped archive). The pointer is valid as long as the handle is open.
+const void *FS_map(FS_Handle_t *handle)
+{
+    return handle->vtable.map ? handle->vtable.map(handle) : NULL;
+}
@@ -40,6 +40,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <time.h>
 
 #define FS_PATH_SEPARATOR    '/'
 #define FS_PATH_SEPARATOR_SZ "/"
@@ -60,23 +61,29 @@ typedef struct FS_Callbacks_s {
     bool   (*eof)     (void *stream);
 } FS_Callbacks_t;
 
+typedef void (*FS_Poll_Callback_t)(void *user_data, const char *name); // A `NULL` name means "anything could have changed".
+
 typedef struct FS_Context_s FS_Context_t;
 
 extern FS_Context_t *FS_create(void);
 extern void FS_destroy(FS_Context_t *context);
 
 extern bool FS_attach_folder_or_archive(FS_Context_t *context, const char *path);
-extern bool FS_attach_folder(FS_Context_t *context, const char *path);
+extern bool FS_attach_folder(FS_Context_t *context, const char *path, bool watched);
 extern bool FS_attach_archive(FS_Context_t *context, const char *path);
 extern bool FS_attach_from_callbacks(FS_Context_t *context, FS_Callbacks_t callbacks, void *user_data);
+extern void FS_invalidate(FS_Context_t *context, const char *name);
+extern void FS_poll(FS_Context_t *context, FS_Poll_Callback_t callback, void *user_data);
 
-extern bool FS_exists(const FS_Context_t *context, const char *name);
-extern FS_Handle_t *FS_open(const FS_Context_t *context, const char *name);
+extern bool FS_exists(FS_Context_t *context, const char *name);
+extern bool FS_stamp(FS_Context_t *context, const char *name, time_t *stamp);
+extern FS_Handle_t *FS_open(FS_Context_t *context, const char *name);
 extern void FS_close(FS_Handle_t *handle);
 extern size_t FS_size(FS_Handle_t *handle);
 extern size_t FS_read(FS_Handle_t *handle, void *buffer, size_t bytes_requested);
 extern bool FS_seek(FS_Handle_t *handle, long offset, int whence);
 extern long FS_tell(FS_Handle_t *handle);
 extern bool FS_eof(FS_Handle_t *handle);
+extern const void *FS_map(FS_Handle_t *handle);
 
 #endif /* TOFU_LIBS_FS_H */
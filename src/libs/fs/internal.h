@@ -44,6 +44,8 @@ typedef struct Mount_VTable_s {
     void         (*dtor)    (FS_Mount_t *mount);
     bool         (*contains)(const FS_Mount_t *mount, const char *name);
     FS_Handle_t *(*open)    (const FS_Mount_t *mount, const char *name);
+    bool         (*stamp)   (const FS_Mount_t *mount, const char *name, time_t *stamp); // Optional, `NULL` when the content is immutable.
+    void         (*poll)    (FS_Mount_t *mount, FS_Poll_Callback_t callback, void *user_data); // Optional, `NULL` when changes can't be detected.
 } Mount_VTable_t;
 
 typedef struct Handle_VTable_s {
@@ -53,6 +55,7 @@ typedef struct Handle_VTable_s {
     bool   (*seek)(FS_Handle_t *handle, long offset, int whence);
     long   (*tell)(FS_Handle_t *handle);
     bool   (*eof) (FS_Handle_t *handle);
+    const void *(*map)(FS_Handle_t *handle); // Optional, `NULL` when the content can't be directly accessed.
 } Handle_VTable_t;
 
 struct FS_Mount_s {
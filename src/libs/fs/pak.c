@@ -35,8 +35,21 @@
 #include <libs/path.h>
 #include <libs/stb.h>
 #include <libs/xor.h>
+#include <miniz/miniz.h>
 
 #include <ctype.h>
+#if PLATFORM_ID == PLATFORM_WINDOWS
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Compressed entries are inflated straight from the mapping, unless encrypted: in that case they are deciphered in
+// chunks of this size prior being inflated.
+#define PAK_CHUNK_SIZE 4096
 
 #pragma pack(push, 1)
 typedef struct Pak_Header_s {
@@ -62,52 +75,201 @@ typedef struct Pak_Header_s {
 typedef struct Pak_Entry_Header_s {
     uint8_t id[PAK_ID_LENGTH];
     uint32_t offset;
-    uint32_t size;
+    uint32_t size; // Uncompressed size.
+    uint32_t stored_size; // Size within the archive (the same as `size` when not compressed).
+    uint8_t compression;
+    uint8_t __reserved[3];
 //    uint32_t checksum;
 } Pak_Entry_Header_t;
 #pragma pack(pop)
 
+typedef struct Pak_Id_s {
+    uint8_t bytes[PAK_ID_LENGTH];
+} Pak_Id_t;
+
 typedef struct Pak_Entry_s {
-    uint8_t id[PAK_ID_LENGTH];
-    long offset;
+    size_t offset;
     size_t size;
+    size_t stored_size;
+    bool compressed;
 } Pak_Entry_t;
 
-typedef bool (*Pak_Search_Function_t)(FILE *stream, size_t entries, const uint8_t id[PAK_ID_LENGTH], Pak_Entry_Header_t *header);
+typedef struct Pak_Directory_s {
+    Pak_Id_t key;
+    Pak_Entry_t value;
+} Pak_Directory_t;
 
 typedef struct Pak_Mount_s {
     Mount_VTable_t vtable; // Matches `FS_Mount_t` structure.
     char path[PLATFORM_PATH_MAX];
-    size_t entries;
-    Pak_Search_Function_t search;
+    const uint8_t *data; // The whole archive is memory-mapped (read-only) for the entire lifetime of the mount.
+    size_t size;
+    Pak_Directory_t *directory; // Hash-map of the entries, keyed by id.
     struct {
         bool encrypted;
         bool sorted;
     } flags;
 } Pak_Mount_t;
 
+typedef struct Pak_Inflater_s {
+    mz_stream stream;
+    size_t consumed; // Amount of stored (compressed) bytes already fed to the stream.
+    uint8_t chunk[PAK_CHUNK_SIZE];
+} Pak_Inflater_t;
+
 typedef struct Pak_Handle_s {
     Handle_VTable_t vtable; // Matches `FS_Handle_t` structure.
-    FILE *stream;
-    size_t stream_size;
-    long begin_of_stream; // Both begin and end markers are *inclusive*.
-    long end_of_stream;
+    const uint8_t *data; // View over the mount's mapping, no data is owned (nor copied) by the handle.
+    size_t stored_size;
+    size_t size;
+    size_t position;
     bool encrypted;
     xor_context_t cipher_context;
+    Pak_Inflater_t *inflater; // Only for compressed entries, `NULL` otherwise.
 } Pak_Handle_t;
 
-static void _pak_mount_ctor(FS_Mount_t *mount, const char *path, size_t entries, bool encrypted, bool sorted);
+static void _pak_mount_ctor(FS_Mount_t *mount, const char *path, const uint8_t *data, size_t size, Pak_Directory_t *directory, bool encrypted, bool sorted);
 static void _pak_mount_dtor(FS_Mount_t *mount);
 static bool _pak_mount_contains(const FS_Mount_t *mount, const char *name);
 static FS_Handle_t *_pak_mount_open(const FS_Mount_t *mount, const char *name);
 
-static void _pak_handle_ctor(FS_Handle_t *handle, FILE *stream, long begin_of_stream, size_t size, bool encrypted, const uint8_t id[PAK_ID_LENGTH]);
+static void _pak_handle_ctor(FS_Handle_t *handle, const uint8_t *data, const Pak_Entry_t *entry, Pak_Inflater_t *inflater, bool encrypted, const uint8_t id[PAK_ID_LENGTH]);
 static void _pak_handle_dtor(FS_Handle_t *handle);
 static size_t _pak_handle_size(FS_Handle_t *handle);
+// Inflates the entry, feeding the stream w/ the stored data as needed. Returns the amount of bytes produced, which
+// is less than requested only at the end of the entry (or on error).
+static size_t _inflate(Pak_Handle_t *pak_handle, void *buffer, size_t bytes_requested)
+{
+    Pak_Inflater_t *inflater = pak_handle->inflater;
+    mz_stream *stream = &inflater->stream;
+
+    stream->next_out = buffer;
+    stream->avail_out = (unsigned int)bytes_requested;
+
+    while (stream->avail_out > 0) {
+        size_t bytes_remaining = pak_handle->stored_size - inflater->consumed;
+        if (stream->avail_in == 0 && bytes_remaining > 0) {
+            const uint8_t *data = pak_handle->data + inflater->consumed;
+            if (pak_handle->encrypted) {
+                size_t bytes_to_decrypt = bytes_remaining < PAK_CHUNK_SIZE ? bytes_remaining : PAK_CHUNK_SIZE;
+                xor_process(&pak_handle->cipher_context, inflater->chunk, data, bytes_to_decrypt);
+                stream->next_in = inflater->chunk;
+                stream->avail_in = (unsigned int)bytes_to_decrypt;
+            } else {
+                stream->next_in = data;
+                stream->avail_in = (unsigned int)bytes_remaining;
+            }
+            inflater->consumed += stream->avail_in;
+        }
+
+        int result = mz_inflate(stream, MZ_SYNC_FLUSH); // Pending (already inflated) data is flushed first.
+        if (result == MZ_STREAM_END) {
+            break;
+        } else
+        if (result == MZ_BUF_ERROR && stream->avail_in == 0 && inflater->consumed < pak_handle->stored_size) {
+            continue; // Need more input, refill on next iteration.
+        } else
+        if (result != MZ_OK) {
+            LOG_E("can't inflate data for handle %p (%s)", pak_handle, mz_error(result));
+            break;
+        }
+    }
+
+    size_t bytes_read = bytes_requested - stream->avail_out;
+    pak_handle->position += bytes_read;
+    return bytes_read;
+}
+
+// Rewinds the stream to the beginning of the entry, so that it can be inflated again from scratch.
+static bool _rewind(Pak_Handle_t *pak_handle)
+{
+    Pak_Inflater_t *inflater = pak_handle->inflater;
+
+    int result = mz_inflateReset(&inflater->stream);
+    if (result != MZ_OK) {
+        LOG_E("can't reset inflater for handle %p (%s)", pak_handle, mz_error(result));
+        return false;
+    }
+    inflater->stream.avail_in = 0;
+    inflater->consumed = 0;
+
+    if (pak_handle->encrypted) {
+        xor_seek(&pak_handle->cipher_context, 0);
+    }
+
+    pak_handle->position = 0;
+
+    return true;
+}
+
+// Compressed entries can't be randomly accessed, we need to inflate (and discard) the data up to the position. When
+// seeking backward, the entry is inflated from the start.
+static bool _skip_to(Pak_Handle_t *pak_handle, size_t position)
+{
+    if (position < pak_handle->position) {
+        bool rewound = _rewind(pak_handle);
+        if (!rewound) {
+            return false;
+        }
+    }
+
+    uint8_t discard[PAK_CHUNK_SIZE];
+    while (pak_handle->position < position) {
+        size_t bytes_to_skip = position - pak_handle->position;
+        if (bytes_to_skip > PAK_CHUNK_SIZE) {
+            bytes_to_skip = PAK_CHUNK_SIZE;
+        }
+        size_t bytes_skipped = _inflate(pak_handle, discard, bytes_to_skip);
+        if (bytes_skipped < bytes_to_skip) {
+            LOG_E("can't skip to position %d for handle %p", position, pak_handle);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 static size_t _pak_handle_read(FS_Handle_t *handle, void *buffer, size_t bytes_requested);
+static size_t _pak_handle_read_encrypted(FS_Handle_t *handle, void *buffer, size_t bytes_requested);
+static size_t _pak_handle_read_compressed(FS_Handle_t *handle, void *buffer, size_t bytes_requested);
 static bool _pak_handle_seek(FS_Handle_t *handle, long offset, int whence);
+static bool _pak_handle_seek_encrypted(FS_Handle_t *handle, long offset, int whence);
+static bool _pak_handle_seek_compressed(FS_Handle_t *handle, long offset, int whence);
 static long _pak_handle_tell(FS_Handle_t *handle);
 static bool _pak_handle_eof(FS_Handle_t *handle);
+static const void *_pak_handle_map(FS_Handle_t *handle);
+
+// Each entry kind (plain, encrypted, or compressed) has its own handle operations, so that the reads don't need to
+// branch on the entry flags. Compressed entries handle the (optional) encryption on their own, a chunk at a time.
+static const Handle_VTable_t _pak_handle_vtable = {
+    .dtor = _pak_handle_dtor,
+    .size = _pak_handle_size,
+    .read = _pak_handle_read,
+    .seek = _pak_handle_seek,
+    .tell = _pak_handle_tell,
+    .eof = _pak_handle_eof,
+    .map = _pak_handle_map
+};
+
+static const Handle_VTable_t _pak_handle_vtable_encrypted = {
+    .dtor = _pak_handle_dtor,
+    .size = _pak_handle_size,
+    .read = _pak_handle_read_encrypted,
+    .seek = _pak_handle_seek_encrypted,
+    .tell = _pak_handle_tell,
+    .eof = _pak_handle_eof,
+    .map = NULL // The mapping holds the ciphered data.
+};
+
+static const Handle_VTable_t _pak_handle_vtable_compressed = {
+    .dtor = _pak_handle_dtor,
+    .size = _pak_handle_size,
+    .read = _pak_handle_read_compressed,
+    .seek = _pak_handle_seek_compressed,
+    .tell = _pak_handle_tell,
+    .eof = _pak_handle_eof,
+    .map = NULL // The mapping holds the deflated data.
+};
 
 static bool _pak_validate_archive(FILE *stream, const char *path)
 {
@@ -160,148 +322,162 @@ static inline void _hash_file(const char *name, uint8_t id[PAK_ID_LENGTH], char
     _to_hex(sz, id);
 }
 
-// FIXME: cache some entries into memory in order to avoid repeated seeks?
-static bool _peek_entry(FILE *stream, size_t index, Pak_Entry_Header_t *header)
+static const uint8_t *_map_file(const char *path, size_t *size)
 {
-    long offset = sizeof(Pak_Header_t) + index * sizeof(Pak_Entry_Header_t);
-
-    bool sought = fseek(stream, offset, SEEK_SET) != -1;
-    if (!sought) {
-        return false;
+#if PLATFORM_ID == PLATFORM_WINDOWS
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_E("can't access file `%s`", path);
+        return NULL;
     }
 
-    size_t entries_read = fread(header, sizeof(Pak_Entry_Header_t), 1, stream);
-    if (entries_read != 1) {
-        return false;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        LOG_E("can't get size of file `%s`", path);
+        CloseHandle(file);
+        return NULL;
     }
 
-    return true;
-}
-
-static bool _linear_search(FILE *stream, size_t entries, const uint8_t id[PAK_ID_LENGTH], Pak_Entry_Header_t *header)
-{
-    for (size_t i = 0; i < entries; ++i) {
-        bool read = _peek_entry(stream, i, header);
-        if (!read) {
-            LOG_E("can't read header #%d", i);
-            return false;
-        }
-
-        int ordering = memcmp(header->id, id, PAK_ID_LENGTH);
-        if (ordering == 0) {
-            return true;
-        }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file); // The mapping object keeps its own reference to the file.
+    if (!mapping) {
+        LOG_E("can't create mapping for file `%s`", path);
+        return NULL;
     }
 
-    return false;
-}
-
-static bool _binary_search(FILE *stream, size_t entries, const uint8_t id[PAK_ID_LENGTH], Pak_Entry_Header_t *header)
-{
-    if (entries == 0) {
-        return false;
+    const uint8_t *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // Ditto, the view keeps the mapping alive.
+    if (!data) {
+        LOG_E("can't map file `%s`", path);
+        return NULL;
     }
 
-    size_t l = 0;
-    size_t u = entries - 1;
+    *size = (size_t)file_size.QuadPart;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        LOG_E("can't access file `%s`", path);
+        return NULL;
+    }
 
-    while (l <= u) {
-        size_t m = (l + u) / 2;
-        bool read = _peek_entry(stream, m, header);
-        if (!read) {
-            LOG_E("can't read header #%d", m);
-            return false;
-        }
+    struct stat info;
+    if (fstat(fd, &info) == -1 || info.st_size == 0) {
+        LOG_E("can't get size of file `%s`", path);
+        close(fd);
+        return NULL;
+    }
 
-        int ordering = memcmp(header->id, id, PAK_ID_LENGTH);
-        if (l == u) { // Corner-case, leaf node so we have the result! (make the algorithm work with `size_t`).
-            return ordering == 0;
-        } else
-        if (ordering < 0) {
-            l = m + 1;
-        } else
-        if (ordering > 0) {
-            u = m - 1;
-        } else {
-            return true;
-        }
+    void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping is still valid once the descriptor is closed.
+    if (data == MAP_FAILED) {
+        LOG_E("can't map file `%s`", path);
+        return NULL;
     }
 
-    return false;
+    *size = (size_t)info.st_size;
+    return (const uint8_t *)data;
+#endif
 }
 
-static FILE *_find_entry(const Pak_Mount_t *pak_mount, const char *name, Pak_Entry_t *entry)
+static void _unmap_file(const uint8_t *data, size_t size)
 {
-    FILE *stream = fopen(pak_mount->path, "rb"); // Always in binary mode, line-terminators aren't an issue.
-    if (!stream) {
-        LOG_E("can't access entry `%s`", pak_mount->path);
-        goto error_exit;
-    }
-
-    char id_hex[PAK_ID_LENGTH_SZ];
-    _hash_file(name, entry->id, id_hex);
-    LOG_T("entry `%s` has id `%s`", name, id_hex);
+#if PLATFORM_ID == PLATFORM_WINDOWS
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap((void *)data, size);
+#endif
+}
 
-    Pak_Entry_Header_t header = { 0 };
-    bool found = pak_mount->search(stream,  pak_mount->entries, entry->id, &header);
-    if (!found) {
-        goto error_close_stream;
+// Scans the entries' table once, and stores it into a hash-map indexed by the entries' ids. Endian-ness is fixed
+// and data expanded to the architecture size at the same time, so that look-ups are mere in-memory probes.
+static Pak_Directory_t *_load_directory(const uint8_t *data, size_t size, size_t entries, const char *path)
+{
+    if (sizeof(Pak_Header_t) + entries * sizeof(Pak_Entry_Header_t) > size) {
+        LOG_E("archive `%s` is truncated (%d entries, %d bytes)", path, entries, size);
+        return NULL;
     }
 
-    // Once read we need to marshal the serialized entry to conform the data size
-    // of the architecture we are running into. Endian-ness need to be fixed, and
-    // data need to expanded (32- to 64-bit).
-    entry->offset = bytes_ui32le(header.offset);
-    entry->size = bytes_ui32le(header.size);
-
-    LOG_T("entry `%s` w/ size %u located at offset %d in archive `%s`", name, entry->size, entry->offset, pak_mount->path);
+    Pak_Directory_t *directory = NULL;
+    hmdefault(directory, ((Pak_Entry_t){ 0 })); // Forces the allocation, in case the archive is empty.
+
+    const Pak_Entry_Header_t *header = (const Pak_Entry_Header_t *)(data + sizeof(Pak_Header_t));
+    for (size_t i = 0; i < entries; ++i, ++header) {
+        Pak_Entry_t entry = (Pak_Entry_t){
+                .offset = bytes_ui32le(header->offset),
+                .size = bytes_ui32le(header->size),
+                .stored_size = bytes_ui32le(header->stored_size),
+                .compressed = header->compression == PAK_COMPRESSION_DEFLATE
+            };
+        if (header->compression != PAK_COMPRESSION_NONE && header->compression != PAK_COMPRESSION_DEFLATE) {
+            LOG_E("entry #%d of archive `%s` has unknown compression %d", i, path, header->compression);
+            hmfree(directory);
+            return NULL;
+        }
+        if (!entry.compressed && entry.size != entry.stored_size) {
+            LOG_E("entry #%d of archive `%s` is stored w/ mismatching sizes (%d vs. %d bytes)", i, path, entry.size, entry.stored_size);
+            hmfree(directory);
+            return NULL;
+        }
+        if (entry.offset > size || entry.stored_size > size - entry.offset) { // i.e. `offset + stored_size > size`, w/o overflowing.
+            LOG_E("entry #%d of archive `%s` exceeds the archive size", i, path);
+            hmfree(directory);
+            return NULL;
+        }
 
-    return stream;
+        Pak_Id_t id;
+        memcpy(id.bytes, header->id, PAK_ID_LENGTH);
+        hmput(directory, id, entry);
+    }
 
-error_close_stream:
-    fclose(stream);
-error_exit:
-    return NULL;
+    return directory;
 }
 
 // Precondition: the path need to be pre-validated as being an archive.
 FS_Mount_t *FS_pak_mount(const char *path)
 {
-    FILE *stream = fopen(path, "rb");
-    if (!stream) {
-        LOG_E("can't access file `%s`", path);
+    size_t size;
+    const uint8_t *data = _map_file(path, &size);
+    if (!data) {
         goto error_exit;
     }
 
-    Pak_Header_t header;
-    size_t entries_read = fread(&header, sizeof(Pak_Header_t), 1, stream);
-    if (entries_read != 1) {
+    if (size < sizeof(Pak_Header_t)) {
         LOG_E("can't read header from file `%s`", path);
-        goto error_close_stream;
+        goto error_unmap_file;
     }
 
+    Pak_Header_t header;
+    memcpy(&header, data, sizeof(Pak_Header_t));
+
     size_t entries = bytes_ui32le(header.entries);
     LOG_T("archive `%s` contains %d entries", path, entries);
 
+    Pak_Directory_t *directory = _load_directory(data, size, entries, path);
+    if (!directory) {
+        goto error_unmap_file;
+    }
+
     FS_Mount_t *mount = malloc(sizeof(Pak_Mount_t));
     if (!mount) {
         LOG_E("can't allocate mount for archive `%s`", path);
-        goto error_close_stream;
+        goto error_free_directory;
     }
 
-    fclose(stream);
-
-    _pak_mount_ctor(mount, path, entries, header.flags.encrypted, header.flags.sorted);
+    _pak_mount_ctor(mount, path, data, size, directory, header.flags.encrypted, header.flags.sorted);
 
     return mount;
 
-error_close_stream:
-    fclose(stream);
+error_free_directory:
+    hmfree(directory);
+error_unmap_file:
+    _unmap_file(data, size);
 error_exit:
     return NULL;
 }
 
-static void _pak_mount_ctor(FS_Mount_t *mount, const char *path, size_t entries, bool encrypted, bool sorted)
+static void _pak_mount_ctor(FS_Mount_t *mount, const char *path, const uint8_t *data, size_t size, Pak_Directory_t *directory, bool encrypted, bool sorted)
 {
     Pak_Mount_t *pak_mount = (Pak_Mount_t *)mount;
 
@@ -312,8 +488,9 @@ static void _pak_mount_ctor(FS_Mount_t *mount, const char *path, size_t entries,
                 .open = _pak_mount_open
             },
             .path = { 0 },
-            .entries = entries,
-            .search = sorted ? _binary_search : _linear_search,
+            .data = data,
+            .size = size,
+            .directory = directory,
             .flags = {
                 .encrypted = encrypted,
                 .sorted = sorted
@@ -322,32 +499,50 @@ static void _pak_mount_ctor(FS_Mount_t *mount, const char *path, size_t entries,
 
     strncpy(pak_mount->path, path, PLATFORM_PATH_MAX - 1);
 
-    LOG_T("mount %p initialized w/ %d entries (encrypted is %d, sorted is %d) for archive `%s`", mount, entries, encrypted, sorted, path);
+    LOG_T("mount %p initialized w/ %d entries (encrypted is %d, sorted is %d) for archive `%s`", mount, hmlenu(directory), encrypted, sorted, path);
 }
 
 static void _pak_mount_dtor(FS_Mount_t *mount)
 {
     Pak_Mount_t *pak_mount = (Pak_Mount_t *)mount;
 
+    hmfree(pak_mount->directory);
+    _unmap_file(pak_mount->data, pak_mount->size);
+
     *pak_mount = (Pak_Mount_t){ 0 };
 
     LOG_T("mount %p uninitialized", mount);
 }
 
+static const Pak_Entry_t *_find_entry(const Pak_Mount_t *pak_mount, const char *name, Pak_Id_t *id)
+{
+    char id_hex[PAK_ID_LENGTH_SZ];
+    _hash_file(name, id->bytes, id_hex);
+    LOG_T("entry `%s` has id `%s`", name, id_hex);
+
+    Pak_Directory_t *directory = pak_mount->directory; // `stb_ds` requires a non-const pointer, even to read.
+    ptrdiff_t temp;
+    ptrdiff_t index = hmgeti_ts(directory, *id, temp); // Thread-safe variant, as the storage loader threads look-up concurrently.
+    if (index == -1) {
+        return NULL;
+    }
+
+    const Pak_Entry_t *entry = &directory[index].value;
+    LOG_T("entry `%s` w/ size %u (%u stored) located at offset %d in archive `%s`", name, entry->size, entry->stored_size, entry->offset, pak_mount->path);
+
+    return entry;
+}
+
 static bool _pak_mount_contains(const FS_Mount_t *mount, const char *name)
 {
     const Pak_Mount_t *pak_mount = (const Pak_Mount_t *)mount;
 
-    Pak_Entry_t entry;
-    FILE *stream = _find_entry(pak_mount, name, &entry);
+    Pak_Id_t id;
+    const Pak_Entry_t *entry = _find_entry(pak_mount, name, &id);
 
-    bool found = !!stream;
+    bool found = !!entry;
     LOG_IF_T(!found, "entry `%s` not found in mount %p", name, pak_mount);
 
-    if (stream) {
-        fclose(stream);
-    }
-
     return found;
 }
 
@@ -355,33 +550,48 @@ static FS_Handle_t *_pak_mount_open(const FS_Mount_t *mount, const char *name)
 {
     const Pak_Mount_t *pak_mount = (const Pak_Mount_t *)mount;
 
-    Pak_Entry_t entry;
-    FILE *stream = _find_entry(pak_mount, name, &entry);
-    if (!stream) {
+    Pak_Id_t id;
+    const Pak_Entry_t *entry = _find_entry(pak_mount, name, &id);
+    if (!entry) {
         LOG_E("can't find entry `%s` in mount %p", name, pak_mount);
-        goto error_exit;
+        return NULL;
     }
 
-    bool sought = fseek(stream, entry.offset, SEEK_SET) != -1; // Move to the found entry position into the file.
-    if (!sought) {
-        LOG_E("can't seek entry `%s` at offset %d mount %p", name, entry.offset, pak_mount);
-        goto error_close_stream;
+    Pak_Inflater_t *inflater = NULL;
+    if (entry->compressed) {
+        inflater = malloc(sizeof(Pak_Inflater_t));
+        if (!inflater) {
+            LOG_E("can't allocate inflater for entry `%s`", name);
+            goto error_exit;
+        }
+
+        inflater->stream = (mz_stream){ 0 };
+        int result = mz_inflateInit(&inflater->stream);
+        if (result != MZ_OK) {
+            LOG_E("can't initialize inflater for entry `%s` (%s)", name, mz_error(result));
+            goto error_free_inflater;
+        }
+        inflater->consumed = 0;
     }
 
     FS_Handle_t *handle = malloc(sizeof(Pak_Handle_t));
     if (!handle) {
         LOG_E("can't allocate handle for entry `%s`", name);
-        goto error_close_stream;
+        goto error_end_inflater;
     }
 
-    _pak_handle_ctor(handle, stream, entry.offset, entry.size, pak_mount->flags.encrypted, entry.id);
+    _pak_handle_ctor(handle, pak_mount->data + entry->offset, entry, inflater, pak_mount->flags.encrypted, id.bytes);
 
     LOG_D("entry `%s` opened w/ handle %p", name, handle);
 
     return handle;
 
-error_close_stream:
-    fclose(stream);
+error_end_inflater:
+    if (inflater) {
+        mz_inflateEnd(&inflater->stream);
+    }
+error_free_inflater:
+    free(inflater);
 error_exit:
     return NULL;
 }
@@ -393,29 +603,23 @@ static inline void _derive_key(uint8_t key[PAK_KEY_LENGTH], const void *data, si
     md5_hash(key, data, length);
 }
 
-static void _pak_handle_ctor(FS_Handle_t *handle, FILE *stream, long begin_of_stream, size_t size, bool encrypted, const uint8_t id[PAK_ID_LENGTH])
+static void _pak_handle_ctor(FS_Handle_t *handle, const uint8_t *data, const Pak_Entry_t *entry, Pak_Inflater_t *inflater, bool encrypted, const uint8_t id[PAK_ID_LENGTH])
 {
     Pak_Handle_t *pak_handle = (Pak_Handle_t *)handle;
 
     *pak_handle = (Pak_Handle_t){
-            .vtable = (Handle_VTable_t){
-                .dtor = _pak_handle_dtor,
-                .size = _pak_handle_size,
-                .read = _pak_handle_read,
-                .seek = _pak_handle_seek,
-                .tell = _pak_handle_tell,
-                .eof = _pak_handle_eof
-            },
-            .stream = stream,
-            .stream_size = size,
-            .begin_of_stream = begin_of_stream,
-            .end_of_stream = begin_of_stream + (long)size - 1L,
+            .vtable = inflater ? _pak_handle_vtable_compressed
+                : encrypted ? _pak_handle_vtable_encrypted
+                : _pak_handle_vtable,
+            .data = data,
+            .stored_size = entry->stored_size,
+            .size = entry->size,
+            .position = 0,
             .encrypted = encrypted,
-            .cipher_context = { { 0 } } // Uh! The first member of the structure is an array, need additional braces!
+            .cipher_context = { { 0 } }, // Uh! The first member of the structure is an array, need additional braces!
+            .inflater = inflater
         };
 
-    // TODO: implement a `null_cipher` that will do nothing, so that we can avoid branches.
-
     if (encrypted) { // Encryption is implemented w/ a XOR stream cipher.
         uint8_t key[PAK_KEY_LENGTH];
         _derive_key(key, id, PAK_ID_LENGTH);
@@ -426,14 +630,19 @@ static void _pak_handle_ctor(FS_Handle_t *handle, FILE *stream, long begin_of_st
 #endif
     }
 
-    LOG_T("handle %p initialized at %ld (%d bytes)", handle, begin_of_stream, size);
+    LOG_T("handle %p initialized at %p (%d bytes, compressed is %d)", handle, data, entry->size, entry->compressed);
 }
 
 static void _pak_handle_dtor(FS_Handle_t *handle)
 {
     Pak_Handle_t *pak_handle = (Pak_Handle_t *)handle;
 
-    fclose(pak_handle->stream);
+    if (pak_handle->inflater) {
+        mz_inflateEnd(&pak_handle->inflater->stream);
+        free(pak_handle->inflater);
+    }
+
+    *pak_handle = (Pak_Handle_t){ 0 }; // The data is owned by the mount, nothing else to release.
 
     LOG_T("handle %p uninitialized", handle);
 }
@@ -446,104 +655,145 @@ static size_t _pak_handle_size(FS_Handle_t *handle)
     LOG_D("handle %p is", std_handle);
 #endif  /* VERBOSE_DEBUG */
 
-    return pak_handle->stream_size;
+    return pak_handle->size;
+}
+
+static inline size_t _clamp_request(const Pak_Handle_t *pak_handle, size_t bytes_requested)
+{
+    size_t bytes_available = pak_handle->size - pak_handle->position;
+    return bytes_requested > bytes_available ? bytes_available : bytes_requested;
 }
 
 static size_t _pak_handle_read(FS_Handle_t *handle, void *buffer, size_t bytes_requested)
 {
     Pak_Handle_t *pak_handle = (Pak_Handle_t *)handle;
 
-    long position = ftell(pak_handle->stream);
-    if (position == -1) {
-        LOG_E("can't get current position for handle %p", handle);
-        return 0;
-    }
-
-    size_t bytes_available = (size_t)(pak_handle->end_of_stream - position + 1);
+    size_t bytes_read = _clamp_request(pak_handle, bytes_requested);
 
-    size_t bytes_to_read = bytes_requested;
-    if (bytes_to_read > bytes_available) {
-        bytes_to_read = bytes_available;
-    }
+    memcpy(buffer, pak_handle->data + pak_handle->position, bytes_read);
+    pak_handle->position += bytes_read;
 
-    size_t bytes_read = fread(buffer, sizeof(uint8_t), bytes_to_read, pak_handle->stream);
 #if defined(TOFU_FILE_DEBUG_ENABLED)
-    LOG_T("%d bytes read out of %d (%d requested)", bytes_read, bytes_to_read, bytes_requested);
+    LOG_D("%d bytes read for handle %p (%d requested)", bytes_read, handle, bytes_requested);
 #endif
+    return bytes_read;
+}
 
-    if (pak_handle->encrypted) {
-        xor_process(&pak_handle->cipher_context, buffer, buffer, bytes_read);
-#if defined(TOFU_FILE_DEBUG_ENABLED)
-        LOG_T("%d bytes decrypted", bytes_read);
-#endif
-    }
+static size_t _pak_handle_read_encrypted(FS_Handle_t *handle, void *buffer, size_t bytes_requested)
+{
+    Pak_Handle_t *pak_handle = (Pak_Handle_t *)handle;
+
+    size_t bytes_read = _clamp_request(pak_handle, bytes_requested);
+
+    // Decrypt straight from the mapping, no need for an intermediate copy. The cipher keeps track of the position by
+    // itself, as the data is consumed.
+    xor_process(&pak_handle->cipher_context, buffer, pak_handle->data + pak_handle->position, bytes_read);
+    pak_handle->position += bytes_read;
 
 #if defined(TOFU_FILE_DEBUG_ENABLED)
-    LOG_D("%d bytes read for handle %p", bytes_read, handle);
+    LOG_D("%d bytes read and decrypted for handle %p (%d requested)", bytes_read, handle, bytes_requested);
 #endif
     return bytes_read;
 }
 
-static bool _pak_handle_seek(FS_Handle_t *handle, long offset, int whence)
+static size_t _pak_handle_read_compressed(FS_Handle_t *handle, void *buffer, size_t bytes_requested)
 {
     Pak_Handle_t *pak_handle = (Pak_Handle_t *)handle;
 
+    size_t bytes_read = _inflate(pak_handle, buffer, _clamp_request(pak_handle, bytes_requested));
+
+#if defined(TOFU_FILE_DEBUG_ENABLED)
+    LOG_D("%d bytes inflated for handle %p (%d requested)", bytes_read, handle, bytes_requested);
+#endif
+    return bytes_read;
+}
+
+// Resolves the seek request to an absolute position, checking it's within the entry bounds.
+static bool _resolve(const Pak_Handle_t *pak_handle, long offset, int whence, size_t *position)
+{
     long origin;
     if (whence == SEEK_SET) {
-        origin = pak_handle->begin_of_stream;
+        origin = 0;
     } else
     if (whence == SEEK_CUR) {
-        origin = ftell(pak_handle->stream);
+        origin = (long)pak_handle->position;
     } else
     if (whence == SEEK_END) {
-        origin = pak_handle->end_of_stream;
+        origin = (long)pak_handle->size;
     } else {
-        LOG_E("wrong seek mode %d for handle %p", whence, handle);
+        LOG_E("wrong seek mode %d for handle %p", whence, pak_handle);
         return false;
     }
 
-    long position = origin + offset;
-    if (position < pak_handle->begin_of_stream || position > pak_handle->end_of_stream) {
-        LOG_E("offset %d (position %d) is outside valid range for handle %p", offset, position, handle);
+    long target = origin + offset;
+    if (target < 0 || target > (long)pak_handle->size) {
+        LOG_E("offset %d (position %d) is outside valid range for handle %p", offset, target, pak_handle);
         return false;
     }
 
-    bool sought = fseek(pak_handle->stream, position, SEEK_SET) == 0;
+    *position = (size_t)target;
 #if defined(TOFU_FILE_DEBUG_ENABLED)
-    LOG_T("%d bytes sought w/ mode %d for handle %p w/ result %d", offset, whence, handle, sought);
+    LOG_T("%d bytes sought w/ mode %d for handle %p", offset, whence, pak_handle);
 #endif
+    return true;
+}
 
-    if (pak_handle->encrypted) { // If encrypted, re-sync the cipher to the sought position.
-        size_t index = position - pak_handle->begin_of_stream;
-        xor_seek(&pak_handle->cipher_context, index);
+static bool _pak_handle_seek(FS_Handle_t *handle, long offset, int whence)
+{
+    Pak_Handle_t *pak_handle = (Pak_Handle_t *)handle;
+
+    return _resolve(pak_handle, offset, whence, &pak_handle->position);
+}
+
+static bool _pak_handle_seek_encrypted(FS_Handle_t *handle, long offset, int whence)
+{
+    Pak_Handle_t *pak_handle = (Pak_Handle_t *)handle;
+
+    if (!_resolve(pak_handle, offset, whence, &pak_handle->position)) {
+        return false;
+    }
+
+    xor_seek(&pak_handle->cipher_context, pak_handle->position); // Re-sync the cipher to the sought position.
 #if defined(TOFU_FILE_DEBUG_ENABLED)
-        LOG_T("cipher context adjusted to %d", index);
+    LOG_T("cipher context adjusted to %d", pak_handle->position);
 #endif
+
+    return true;
+}
+
+static bool _pak_handle_seek_compressed(FS_Handle_t *handle, long offset, int whence)
+{
+    Pak_Handle_t *pak_handle = (Pak_Handle_t *)handle;
+
+    size_t position;
+    if (!_resolve(pak_handle, offset, whence, &position)) {
+        return false;
     }
 
-    return sought;
+    return _skip_to(pak_handle, position); // The cipher (if any) is kept in sync by the inflater itself.
 }
 
 static long _pak_handle_tell(FS_Handle_t *handle)
 {
     const Pak_Handle_t *pak_handle = (const Pak_Handle_t *)handle;
 
-    return ftell(pak_handle->stream) - pak_handle->begin_of_stream;
+    return (long)pak_handle->position;
 }
 
 static bool _pak_handle_eof(FS_Handle_t *handle)
 {
     const Pak_Handle_t *pak_handle = (const Pak_Handle_t *)handle;
 
-    long position = ftell(pak_handle->stream);
-    if (position == -1) {
-        LOG_E("can't get current position for handle %p", handle);
-        return true;
-    }
-
-    bool end_of_file = position > pak_handle->end_of_stream;
+    bool end_of_file = pak_handle->position >= pak_handle->size;
 #if defined(TOFU_FILE_DEBUG_ENABLED)
     LOG_IF_D(end_of_file, "end-of-file reached for handle %p", handle);
 #endif
     return end_of_file;
 }
+
+static const void *_pak_handle_map(FS_Handle_t *handle)
+{
+    const Pak_Handle_t *pak_handle = (const Pak_Handle_t *)handle;
+
+    return pak_handle->data; // Plain entries only, the mapping holds the actual content.
+}
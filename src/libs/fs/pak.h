@@ -71,7 +71,10 @@ NOTE: `uint16_t` and `uint32_t` data are explicitly stored in little-endian.
 #define PAK_SIGNATURE        "TOFUPAK!"
 #define PAK_SIGNATURE_LENGTH 8
 
-#define PAK_VERSION          0
+#define PAK_VERSION          1
+
+#define PAK_COMPRESSION_NONE    0
+#define PAK_COMPRESSION_DEFLATE 1 // zlib-wrapped deflate stream.
 
 #define PAK_ID_LENGTH    MD5_SIZE
 #define PAK_ID_LENGTH_SZ (PAK_ID_LENGTH * 2 + 1)
@@ -49,9 +49,30 @@
 #include <dirent.h>
 #include <sys/stat.h>
 
+#if defined(TOFU_FILE_HOT_RELOAD) && PLATFORM_ID == PLATFORM_LINUX
+  #define _WATCH_FOLDERS
+#endif
+
+#if defined(_WATCH_FOLDERS)
+  #include <errno.h>
+  #include <sys/inotify.h>
+  #include <unistd.h>
+
+  #define _WATCH_EVENTS_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE | IN_ONLYDIR)
+
+typedef struct Std_Watch_s {
+    int key; // Watch descriptor...
+    char *value; // ... and the watched sub-folder, relative to the mount path (empty for the mount path itself).
+} Std_Watch_t;
+#endif  /* _WATCH_FOLDERS */
+
 typedef struct Std_Mount_s {
     Mount_VTable_t vtable; // Matches `FS_Mount_t` structure.
     char path[PLATFORM_PATH_MAX];
+#if defined(_WATCH_FOLDERS)
+    int watcher; // `inotify` instance, `-1` when not available.
+    Std_Watch_t *watches;
+#endif  /* _WATCH_FOLDERS */
 } Std_Mount_t;
 
 typedef struct Std_Handle_s {
@@ -60,10 +81,14 @@ typedef struct Std_Handle_s {
     size_t size;
 } Std_Handle_t;
 
-static void _std_mount_ctor(FS_Mount_t *mount, const char *path);
+static void _std_mount_ctor(FS_Mount_t *mount, const char *path, bool watched);
 static void _std_mount_dtor(FS_Mount_t *mount);
 static bool _std_mount_contains(const FS_Mount_t *mount, const char *name);
 static FS_Handle_t *_std_mount_open(const FS_Mount_t *mount, const char *name);
+static bool _std_mount_stamp(const FS_Mount_t *mount, const char *name, time_t *stamp);
+#if defined(_WATCH_FOLDERS)
+static void _std_mount_poll(FS_Mount_t *mount, FS_Poll_Callback_t callback, void *user_data);
+#endif  /* _WATCH_FOLDERS */
 
 static void _std_handle_ctor(FS_Handle_t *handle, FILE *stream, size_t size);
 static void _std_handle_dtor(FS_Handle_t *handle);
@@ -79,7 +104,7 @@ bool FS_std_is_valid(const char *path)
 }
 
 // Precondition: the path need to be pre-validated as being a folder.
-FS_Mount_t *FS_std_mount(const char *path)
+FS_Mount_t *FS_std_mount(const char *path, bool watched)
 {
     FS_Mount_t *mount = malloc(sizeof(Std_Mount_t));
     if (!mount) {
@@ -87,12 +112,72 @@ FS_Mount_t *FS_std_mount(const char *path)
         return NULL;
     }
 
-    _std_mount_ctor(mount, path);
+    _std_mount_ctor(mount, path, watched);
 
     return mount;
 }
 
-static void _std_mount_ctor(FS_Mount_t *mount, const char *path)
+#if defined(_WATCH_FOLDERS)
+// Mount-relative names use the virtual file-system separator, regardless of the platform.
+static void _relative(char *name, const char *folder, const char *file)
+{
+    if (*folder == '\0') {
+        strcpy(name, file);
+    } else {
+        strcpy(name, folder);
+        strcat(name, FS_PATH_SEPARATOR_SZ);
+        strcat(name, file);
+    }
+}
+
+// `inotify` watches aren't recursive, so we need to add a watch for every sub-folder, tracking the (relative) folder
+// each watch descriptor refers to in order to rebuild the name of the changed files.
+static void _watch(Std_Mount_t *std_mount, const char *folder)
+{
+    char path[PLATFORM_PATH_MAX] = { 0 };
+    path_join(path, std_mount->path, folder);
+
+    int wd = inotify_add_watch(std_mount->watcher, path, _WATCH_EVENTS_MASK);
+    if (wd == -1) {
+        LOG_W("can't watch folder `%s` (%s)", path, strerror(errno));
+        return;
+    }
+
+    ptrdiff_t index = hmgeti(std_mount->watches, wd);
+    if (index != -1) { // Already watched (e.g. a folder moved back and forth), refresh the relative name.
+        free(std_mount->watches[index].value);
+        std_mount->watches[index].value = stb_memdup(folder, strlen(folder) + 1);
+    } else {
+        hmput(std_mount->watches, wd, stb_memdup(folder, strlen(folder) + 1));
+    }
+    LOG_T("folder `%s` watched w/ descriptor #%d", path, wd);
+
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return;
+    }
+
+    for (struct dirent *entry = readdir(dir); entry; entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') { // Skip current, parent, and hidden entries.
+            continue;
+        }
+
+        char sub_folder[PLATFORM_PATH_MAX] = { 0 };
+        _relative(sub_folder, folder, entry->d_name);
+
+        char sub_path[PLATFORM_PATH_MAX] = { 0 };
+        path_join(sub_path, std_mount->path, sub_folder);
+
+        if (path_is_folder(sub_path)) {
+            _watch(std_mount, sub_folder);
+        }
+    }
+
+    closedir(dir);
+}
+#endif  /* _WATCH_FOLDERS */
+
+static void _std_mount_ctor(FS_Mount_t *mount, const char *path, bool watched)
 {
     Std_Mount_t *std_mount = (Std_Mount_t *)mount;
 
@@ -100,13 +185,33 @@ static void _std_mount_ctor(FS_Mount_t *mount, const char *path)
             .vtable = (Mount_VTable_t){
                 .dtor = _std_mount_dtor,
                 .contains = _std_mount_contains,
-                .open = _std_mount_open
+                .open = _std_mount_open,
+                .stamp = _std_mount_stamp,
+#if defined(_WATCH_FOLDERS)
+                .poll = _std_mount_poll
+#endif  /* _WATCH_FOLDERS */
             },
             .path = { 0 }
         };
 
     strncpy(std_mount->path, path, PLATFORM_PATH_MAX - 1);
 
+#if defined(_WATCH_FOLDERS)
+    std_mount->watcher = -1;
+    if (!watched) { // e.g. the save folder, as the game writing its own files isn't a change to react to.
+        LOG_D("folder `%s` won't be watched for changes", path);
+    } else {
+        std_mount->watcher = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (std_mount->watcher == -1) {
+            LOG_W("can't watch folder `%s` for changes (%s)", path, strerror(errno));
+        } else {
+            _watch(std_mount, "");
+        }
+    }
+#else
+    (void)watched;
+#endif  /* _WATCH_FOLDERS */
+
     LOG_T("mount %p initialized at folder `%s`", mount, path);
 }
 
@@ -114,6 +219,16 @@ static void _std_mount_dtor(FS_Mount_t *mount)
 {
     Std_Mount_t *std_mount = (Std_Mount_t *)mount;
 
+#if defined(_WATCH_FOLDERS)
+    if (std_mount->watcher != -1) {
+        close(std_mount->watcher); // Closing the instance also removes all its watches.
+    }
+    for (ptrdiff_t index = 0; index < hmlen(std_mount->watches); ++index) {
+        free(std_mount->watches[index].value);
+    }
+    hmfree(std_mount->watches);
+#endif  /* _WATCH_FOLDERS */
+
     *std_mount = (Std_Mount_t){ 0 };
 
     LOG_T("mount %p uninitialized", mount);
@@ -131,6 +246,23 @@ static bool _std_mount_contains(const FS_Mount_t *mount, const char *name)
     return exists;
 }
 
+static bool _std_mount_stamp(const FS_Mount_t *mount, const char *name, time_t *stamp)
+{
+    const Std_Mount_t *std_mount = (const Std_Mount_t *)mount;
+
+    char path[PLATFORM_PATH_MAX] = { 0 };
+    path_join(path, std_mount->path, name);
+
+    struct stat path_stat;
+    if (stat(path, &path_stat) != 0) {
+        LOG_E("can't get stats for file `%s`", path);
+        return false;
+    }
+
+    *stamp = path_stat.st_mtime;
+    return true;
+}
+
 static size_t _size(FILE *stream)
 {
     fseek(stream, 0L, SEEK_END);
@@ -174,6 +306,69 @@ error_exit:
     return NULL;
 }
 
+#if defined(_WATCH_FOLDERS)
+static void _std_mount_poll(FS_Mount_t *mount, FS_Poll_Callback_t callback, void *user_data)
+{
+    Std_Mount_t *std_mount = (Std_Mount_t *)mount;
+
+    if (std_mount->watcher == -1) {
+        return;
+    }
+
+    // The buffer is aligned as the events structure, as suggested by the `inotify` manual page.
+    char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t length = read(std_mount->watcher, buffer, sizeof(buffer));
+        if (length <= 0) { // Non-blocking read, fails w/ `EAGAIN` when no more events are pending.
+            break;
+        }
+
+        for (const char *ptr = buffer; ptr < buffer + length; ) {
+            const struct inotify_event *event = (const struct inotify_event *)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                LOG_W("too many changes in folder `%s`, some were lost", std_mount->path);
+                callback(user_data, NULL);
+                continue;
+            }
+
+            ptrdiff_t index = hmgeti(std_mount->watches, event->wd);
+            if (index == -1) {
+                continue;
+            }
+
+            if (event->mask & IN_IGNORED) { // The watched folder has been removed (or moved away).
+                free(std_mount->watches[index].value);
+                (void)hmdel(std_mount->watches, event->wd);
+                continue;
+            }
+
+            if (event->len == 0 || event->name[0] == '.') { // Events on the folder itself or on hidden files.
+                continue;
+            }
+
+            char name[PLATFORM_PATH_MAX] = { 0 };
+            _relative(name, std_mount->watches[index].value, event->name);
+
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    _watch(std_mount, name);
+                }
+                continue;
+            }
+
+            if (event->mask & IN_CREATE) { // Creation is followed by a close-after-write, report that one only.
+                continue;
+            }
+
+            LOG_D("file `%s` changed in folder `%s`", name, std_mount->path);
+            callback(user_data, name);
+        }
+    }
+}
+#endif  /* _WATCH_FOLDERS */
+
 static void _std_handle_ctor(FS_Handle_t *handle, FILE *stream, size_t size)
 {
     Std_Handle_t *std_handle = (Std_Handle_t *)handle;
@@ -41,6 +41,6 @@
 #include "fs.h"
 
 extern bool FS_std_is_valid(const char *path);
-extern FS_Mount_t *FS_std_mount(const char *path);
+extern FS_Mount_t *FS_std_mount(const char *path, bool watched);
 
 #endif /* TOFU_LIBS_FS_STD_H */
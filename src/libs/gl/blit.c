@@ -42,6 +42,26 @@
 #include <libs/imath.h>
 #include <libs/sincos.h>
 
+#if defined(TOFU_GRAPHICS_VECTORIZED_BLIT) && !defined(TOFU_GRAPHICS_DEBUG_ENABLED)
+    #if defined(PLATFORM_SIMD_SSE2)
+        #define _GL_BLIT_SSE2
+        #include <emmintrin.h>
+    #elif defined(PLATFORM_SIMD_NEON)
+        #define _GL_BLIT_NEON
+        #include <arm_neon.h>
+    #endif
+    #define _GL_BLIT_MASKED
+#endif  /* TOFU_GRAPHICS_VECTORIZED_BLIT */
+
+#if defined(TOFU_GRAPHICS_TILED_ROTATIONS) && !defined(TOFU_GRAPHICS_DEBUG_ENABLED)
+    #define _GL_BLIT_TILED
+    #define _GL_BLIT_TILE_SIZE      8
+    #define _GL_BLIT_FIXED_SHIFT    16
+    #define _GL_BLIT_FIXED_LIMIT    32767.0f // Largest (absolute) coordinate fitting 16.16 fixed-point.
+#endif  /* TOFU_GRAPHICS_TILED_ROTATIONS */
+
+#include <string.h>
+
 #if defined(TOFU_GRAPHICS_DEBUG_ENABLED)
 static inline void _pixel(const GL_Surface_t *surface, int x, int y, int index)
 {
@@ -49,6 +69,151 @@ static inline void _pixel(const GL_Surface_t *surface, int x, int y, int index)
 }
 #endif
 
+#if defined(_GL_BLIT_MASKED)
+// Copies a row of (non-shifted) pixels, skipping the ones matching any of the
+// given (padded) transparent indexes. The bulk of the row is processed 16 pixels
+// at a time, by means of byte-comparisons and a blend with the destination.
+static inline void _blit_row_masked(GL_Pixel_t *dptr, const GL_Pixel_t *sptr, size_t width, const GL_Pixel_t *indexes, const GL_Bool_t *transparent)
+{
+#if defined(_GL_BLIT_SSE2)
+    const __m128i k0 = _mm_set1_epi8((char)indexes[0]);
+    const __m128i k1 = _mm_set1_epi8((char)indexes[1]);
+    const __m128i k2 = _mm_set1_epi8((char)indexes[2]);
+    const __m128i k3 = _mm_set1_epi8((char)indexes[3]);
+    for (; width >= 16; width -= 16) {
+        const __m128i s = _mm_loadu_si128((const __m128i *)sptr);
+        const __m128i d = _mm_loadu_si128((const __m128i *)dptr);
+        const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(s, k0), _mm_cmpeq_epi8(s, k1)),
+            _mm_or_si128(_mm_cmpeq_epi8(s, k2), _mm_cmpeq_epi8(s, k3)));
+        _mm_storeu_si128((__m128i *)dptr, _mm_or_si128(_mm_and_si128(m, d), _mm_andnot_si128(m, s)));
+        sptr += 16;
+        dptr += 16;
+    }
+#elif defined(_GL_BLIT_NEON)
+    const uint8x16_t k0 = vdupq_n_u8(indexes[0]);
+    const uint8x16_t k1 = vdupq_n_u8(indexes[1]);
+    const uint8x16_t k2 = vdupq_n_u8(indexes[2]);
+    const uint8x16_t k3 = vdupq_n_u8(indexes[3]);
+    for (; width >= 16; width -= 16) {
+        const uint8x16_t s = vld1q_u8(sptr);
+        const uint8x16_t d = vld1q_u8(dptr);
+        const uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(s, k0), vceqq_u8(s, k1)),
+            vorrq_u8(vceqq_u8(s, k2), vceqq_u8(s, k3)));
+        vst1q_u8(dptr, vbslq_u8(m, d, s));
+        sptr += 16;
+        dptr += 16;
+    }
+#endif
+    for (; width; --width) { // Remaining pixels (or the whole row, on scalar-only targets).
+        const GL_Pixel_t index = *(sptr++);
+        if (transparent[index]) {
+            ++dptr;
+        } else {
+            *(dptr++) = index;
+        }
+    }
+}
+#endif  /* _GL_BLIT_MASKED */
+
+#if defined(_GL_BLIT_TILED)
+// Backward-mapping of the destination area, with `(u, v) = (u0, v0) + x * (du_dx, dv_dx) + y * (du_dy, dv_dy)`, in
+// 16.16 fixed-point.
+typedef struct _Mapping_s {
+    int32_t u0, v0;
+    int32_t du_dx, dv_dx;
+    int32_t du_dy, dv_dy;
+} _Mapping_t;
+
+static inline int32_t _to_fixed(float value)
+{
+    return (int32_t)IFLOORF(value * (float)(1 << _GL_BLIT_FIXED_SHIFT));
+}
+
+// Since the mapping is affine, the extremes of the source coordinates over a tile are found on its corners. This
+// lets us classify each tile as completely outside, completely inside, or crossing the source area edges.
+static void _blit_tiled(GL_Pixel_t *ddata, size_t dwidth, int width, int height, const GL_Surface_t *source, GL_Quad_t bounds, const _Mapping_t *mapping, const GL_Pixel_t *shifting, const GL_Bool_t *transparent)
+{
+    const GL_Pixel_t *sdata = source->data;
+    const size_t swidth = source->width;
+
+    const int32_t u0 = mapping->u0;
+    const int32_t v0 = mapping->v0;
+    const int32_t du_dx = mapping->du_dx;
+    const int32_t dv_dx = mapping->dv_dx;
+    const int32_t du_dy = mapping->du_dy;
+    const int32_t dv_dy = mapping->dv_dy;
+
+    const unsigned int sw = (unsigned int)(bounds.x1 - bounds.x0);
+    const unsigned int sh = (unsigned int)(bounds.y1 - bounds.y0);
+
+    for (int ty = 0; ty < height; ty += _GL_BLIT_TILE_SIZE) {
+        const int th = imin(_GL_BLIT_TILE_SIZE, height - ty);
+
+        for (int tx = 0; tx < width; tx += _GL_BLIT_TILE_SIZE) {
+            const int tw = imin(_GL_BLIT_TILE_SIZE, width - tx);
+
+            const int32_t ua = u0 + tx * du_dx + ty * du_dy; // Top-left corner, the others follow.
+            const int32_t va = v0 + tx * dv_dx + ty * dv_dy;
+            const int32_t ub = ua + (tw - 1) * du_dx;
+            const int32_t vb = va + (tw - 1) * dv_dx;
+            const int32_t uc = ua + (th - 1) * du_dy;
+            const int32_t vc = va + (th - 1) * dv_dy;
+            const int32_t ud = ub + (th - 1) * du_dy;
+            const int32_t vd = vb + (th - 1) * dv_dy;
+
+            const int umin = imin(imin(ua, ub), imin(uc, ud)) >> _GL_BLIT_FIXED_SHIFT;
+            const int umax = imax(imax(ua, ub), imax(uc, ud)) >> _GL_BLIT_FIXED_SHIFT;
+            const int vmin = imin(imin(va, vb), imin(vc, vd)) >> _GL_BLIT_FIXED_SHIFT;
+            const int vmax = imax(imax(va, vb), imax(vc, vd)) >> _GL_BLIT_FIXED_SHIFT;
+
+            if (umax < bounds.x0 || umin >= bounds.x1 || vmax < bounds.y0 || vmin >= bounds.y1) {
+                continue; // Completely outside, skip the whole tile.
+            }
+            const bool inside = umin >= bounds.x0 && umax < bounds.x1 && vmin >= bounds.y0 && vmax < bounds.y1;
+
+            GL_Pixel_t *drow = ddata + ty * dwidth + tx;
+            int32_t urow = ua;
+            int32_t vrow = va;
+            for (int i = th; i; --i) {
+                GL_Pixel_t *dptr = drow;
+                int32_t u = urow;
+                int32_t v = vrow;
+                if (inside) {
+                    for (int j = tw; j; --j) {
+                        const int x = u >> _GL_BLIT_FIXED_SHIFT;
+                        const int y = v >> _GL_BLIT_FIXED_SHIFT;
+                        const GL_Pixel_t index = shifting[sdata[y * swidth + x]];
+                        if (!transparent[index]) {
+                            *dptr = index;
+                        }
+                        ++dptr;
+                        u += du_dx;
+                        v += dv_dx;
+                    }
+                } else {
+                    for (int j = tw; j; --j) {
+                        const int x = u >> _GL_BLIT_FIXED_SHIFT;
+                        const int y = v >> _GL_BLIT_FIXED_SHIFT;
+                        if ((unsigned int)(x - bounds.x0) < sw && (unsigned int)(y - bounds.y0) < sh) { // Negatives wrap to large values.
+                            const GL_Pixel_t index = shifting[sdata[y * swidth + x]];
+                            if (!transparent[index]) {
+                                *dptr = index;
+                            }
+                        }
+                        ++dptr;
+                        u += du_dx;
+                        v += dv_dx;
+                    }
+                }
+                drow += dwidth;
+                urow += du_dy;
+                vrow += dv_dy;
+            }
+        }
+    }
+}
+#endif  /* _GL_BLIT_TILED */
+
 // TODO: specifies `const` always? Is pedantic or useful?
 // https://dev.to/fenbf/please-declare-your-variables-as-const
 void GL_context_blit(const GL_Context_t *context, GL_Point_t position, const GL_Surface_t *source, GL_Rectangle_t area)
@@ -89,6 +254,7 @@ void GL_context_blit(const GL_Context_t *context, GL_Point_t position, const GL_
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     const GL_Pixel_t *sdata = source->data;
     GL_Pixel_t *ddata = surface->data;
@@ -102,6 +268,27 @@ void GL_context_blit(const GL_Context_t *context, GL_Point_t position, const GL_
     const GL_Pixel_t *sptr = sdata + skip_y * swidth + skip_x;
     GL_Pixel_t *dptr = ddata + drawing_region.y0 * dwidth + drawing_region.x0;
 
+#if defined(_GL_BLIT_MASKED)
+    // When no shifting is active the source pixels can be copied as they are,
+    // either straight (no transparent colors) or with a per-row blend.
+    if (state->masks.identity && state->masks.transparent_count <= GL_MAX_MASKED_TRANSPARENT_INDEXES) {
+        if (state->masks.transparent_count == 0) {
+            for (int i = height; i; --i) {
+                memcpy(dptr, sptr, (size_t)width);
+                sptr += swidth;
+                dptr += dwidth;
+            }
+        } else {
+            for (int i = height; i; --i) {
+                _blit_row_masked(dptr, sptr, (size_t)width, state->masks.transparent, transparent);
+                sptr += swidth;
+                dptr += dwidth;
+            }
+        }
+        return;
+    }
+#endif  /* _GL_BLIT_MASKED */
+
     for (int i = height; i; --i) {
         for (int j = width; j; --j) {
 #if defined(TOFU_GRAPHICS_DEBUG_ENABLED)
@@ -166,6 +353,7 @@ void GL_context_blit_s(const GL_Context_t *context, GL_Point_t position, const G
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     const GL_Pixel_t *sdata = source->data;
     GL_Pixel_t *ddata = surface->data;
@@ -183,17 +371,18 @@ void GL_context_blit_s(const GL_Context_t *context, GL_Point_t position, const G
     //   y_s = round((y_r + 0.5) / S_y - 0.5) = floor((y_r + 0.5) / S_y)
     //
     // Notice that we need to work in the mid-center of the pixels. We can also rewrite the
-    // formula in a recurring fashion if we increment and accumulate by `1 / S_x` and `1 / S_y` steps.
+    // formula in a recurring fashion if we increment and accumulate by `1 / S_x` steps.
+    //
+    // Rows are evaluated directly, instead, so that the source row doesn't depend on where the
+    // clipping region starts (e.g. when the surface is drawn in horizontal bands).
     const float ou0 = (skip_x + 0.5f) / scale_x;
-    const float ov0 = (skip_y + 0.5f) / scale_y; // `skip_*` is never negative, so we can check the sign!
     const float ou = (float)area.x + (ou0 < 0.0f ? (float)area.width + ou0 : ou0); // Offset to the correct margin, according to flipping.
-    const float ov = (float)area.y + (ov0 < 0.0f ? (float)area.height + ov0 : ov0);
 
     const float du = 1.0f / scale_x; // Retain sign of the scaling to move according to a "vector" along the scaling.
-    const float dv = 1.0f / scale_y;
 
-    float v = ov;
     for (int i = height; i; --i) {
+        const float ov0 = (skip_y + (float)(height - i) + 0.5f) / scale_y; // `skip_*` is never negative, so we can check the sign!
+        const float v = (float)area.y + (ov0 < 0.0f ? (float)area.height + ov0 : ov0);
         const int y = ITRUNC(v); // Truncate, as we used `ITRUNC()` to calculate the scaled size.
         const GL_Pixel_t *sptr = sdata + y * swidth;
 
@@ -212,7 +401,6 @@ void GL_context_blit_s(const GL_Context_t *context, GL_Point_t position, const G
             u += du;
         }
 
-        v += dv;
         dptr += dskip;
     }
 #if defined(TOFU_GRAPHICS_DEBUG_ENABLED)
@@ -311,6 +499,7 @@ void GL_context_blit_sr(const GL_Context_t *context, GL_Point_t position, const
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     const int sminx = area.x;
     const int sminy = area.y;
@@ -332,6 +521,34 @@ void GL_context_blit_sr(const GL_Context_t *context, GL_Point_t position, const
 
     GL_Pixel_t *dptr = ddata + drawing_region.y0 * dwidth + drawing_region.x0;
 
+#if defined(_GL_BLIT_TILED)
+    // The fixed-point origin is computed on the unclipped AABB corner and then moved by the (integer) amount of
+    // clipped pixels, so that the mapping of each pixel doesn't depend on the clipping region (e.g. when the surface
+    // is drawn in horizontal bands). Check, first, that the coordinates of the whole AABB fit the 16.16 fixed-point
+    // range (they always do, unless for huge surfaces or extreme scaling factors).
+    const float ou0 = aabb_x0 * M11 + aabb_y0 * M12 + sx + 0.5f; // Ditto, see below.
+    const float ov0 = aabb_x0 * M21 + aabb_y0 * M22 + sy + 0.5f;
+    const float aabb_size = aabb_x1 - aabb_x0 + 1.0f;
+    const float extent_u = (FABS(M11) + FABS(M12)) * aabb_size;
+    const float extent_v = (FABS(M21) + FABS(M22)) * aabb_size;
+    if (FABS(ou0) + extent_u < _GL_BLIT_FIXED_LIMIT && FABS(ov0) + extent_v < _GL_BLIT_FIXED_LIMIT) {
+        const int32_t du_dx = _to_fixed(M11);
+        const int32_t dv_dx = _to_fixed(M21);
+        const int32_t du_dy = _to_fixed(M12);
+        const int32_t dv_dy = _to_fixed(M22);
+        const int32_t clipped_x = (int32_t)(skip_x - aabb_x0);
+        const int32_t clipped_y = (int32_t)(skip_y - aabb_y0);
+        const _Mapping_t mapping = (_Mapping_t){
+                .u0 = _to_fixed(ou0) + clipped_x * du_dx + clipped_y * du_dy,
+                .v0 = _to_fixed(ov0) + clipped_x * dv_dx + clipped_y * dv_dy,
+                .du_dx = du_dx, .dv_dx = dv_dx,
+                .du_dy = du_dy, .dv_dy = dv_dy
+            };
+        _blit_tiled(dptr, dwidth, width, height, source, (GL_Quad_t){ .x0 = sminx, .y0 = sminy, .x1 = smaxx, .y1 = smaxy }, &mapping, shifting, transparent);
+        return;
+    }
+#endif  /* _GL_BLIT_TILED */
+
     for (int i = 0; i < height; ++i) {
         const float ov = skip_y + (float)i; // + 0.5f;
 #if defined(TOFU_GRAPHICS_OPTIMIZED_ROTATIONS)
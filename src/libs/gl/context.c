@@ -43,6 +43,45 @@
 #include <libs/log.h>
 #include <libs/stb.h>
 
+static void _update_masks(GL_State_t *state)
+{
+    bool identity = true;
+    for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; ++i) {
+        if (state->shifting[i] != (GL_Pixel_t)i) {
+            identity = false;
+            break;
+        }
+    }
+    state->masks.identity = identity;
+
+    size_t count = 0;
+    for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; ++i) {
+        if (!state->transparent[i]) {
+            continue;
+        }
+        if (count < GL_MAX_MASKED_TRANSPARENT_INDEXES) {
+            state->masks.transparent[count] = (GL_Pixel_t)i;
+        }
+        count += 1;
+    }
+    state->masks.transparent_count = count;
+
+    // Pad the unused slots with a duplicate of the first index, so that the
+    // comparisons can always be performed on the whole set.
+    for (size_t i = count; count > 0 && i < GL_MAX_MASKED_TRANSPARENT_INDEXES; ++i) {
+        state->masks.transparent[i] = state->masks.transparent[0];
+    }
+
+    for (size_t i = 0; i < GL_MAX_PALETTE_COLORS / 32; ++i) {
+        state->masks.skipped[i] = 0;
+    }
+    for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; ++i) {
+        if (state->transparent[state->shifting[i]]) {
+            state->masks.skipped[i >> 5] |= 1U << (i & 31);
+        }
+    }
+}
+
 static void _reset(GL_Context_t *context)
 {
     const GL_Surface_t *surface = context->surface;
@@ -64,6 +103,8 @@ static void _reset(GL_Context_t *context)
     }
     state.transparent[0] = GL_BOOL_TRUE;
 
+    _update_masks(&state);
+
     context->state.current = state;
 }
 
@@ -152,6 +193,8 @@ void GL_context_set_shifting(GL_Context_t *context, const GL_Pixel_t *from, cons
             state->shifting[from[i]] = to[i];
         }
     }
+
+    _update_masks(state);
 }
 
 void GL_context_set_transparent(GL_Context_t *context, const GL_Pixel_t *indexes, const GL_Bool_t *transparent, size_t count)
@@ -167,6 +210,8 @@ void GL_context_set_transparent(GL_Context_t *context, const GL_Pixel_t *indexes
             state->transparent[indexes[i]] = transparent[i];
         }
     }
+
+    _update_masks(state);
 }
 
 void GL_context_clear(const GL_Context_t *context, GL_Pixel_t index, bool transparency)
@@ -182,6 +227,7 @@ void GL_context_clear(const GL_Context_t *context, GL_Pixel_t index, bool transp
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, *clipping_region);
     // FIXME: remove this early bailing out everywhere? Null for-loop suffices and is better due to lack of branch?
 
     index = shifting[index];
@@ -44,10 +44,20 @@
 
 #include <stdbool.h>
 
+// Amount of transparent indexes that are tracked in the state masks. Above this
+// value the slower table-based drawing is used.
+#define GL_MAX_MASKED_TRANSPARENT_INDEXES   4
+
 typedef struct GL_State_s {
     GL_Quad_t clipping_region;
     GL_Pixel_t shifting[GL_MAX_PALETTE_COLORS];
     GL_Bool_t transparent[GL_MAX_PALETTE_COLORS];
+    struct { // Derived from the tables above, they are used to detect (and enable) faster drawing code-paths.
+        bool identity; // `true` when the shifting table doesn't alter any index.
+        size_t transparent_count;
+        GL_Pixel_t transparent[GL_MAX_MASKED_TRANSPARENT_INDEXES]; // Unused slots repeat the first index.
+        uint32_t skipped[GL_MAX_PALETTE_COLORS / 32]; // Bit-set of the (source) indexes that are transparent once shifted.
+    } masks;
 } GL_State_t;
 
 typedef struct GL_Context_s {
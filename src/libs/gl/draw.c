@@ -64,6 +64,7 @@ void GL_context_fill(const GL_Context_t *context, GL_Point_t seed, GL_Pixel_t in
         || seed.y < clipping_region->y0 || seed.y >= clipping_region->y1) {
         return;
     }
+    GL_surface_touch(surface, *clipping_region); // The filled area is unknown in advance, assume the worst case.
 
     GL_Pixel_t *ddata = surface->data;
 
@@ -162,6 +163,7 @@ void GL_context_scan(const GL_Context_t *context, GL_Rectangle_t area, GL_Contex
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     GL_Pixel_t *ddata = surface->data;
 
@@ -226,6 +228,7 @@ void GL_context_process(const GL_Context_t *context, GL_Point_t position, const
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     const GL_Pixel_t *sdata = source->data;
     GL_Pixel_t *ddata = surface->data;
@@ -297,6 +300,7 @@ void GL_context_copy(const GL_Context_t *context, GL_Point_t position, const GL_
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     const GL_Pixel_t *sdata = source->data;
     GL_Pixel_t *ddata = surface->data;
@@ -411,6 +415,7 @@ void GL_context_stencil(const GL_Context_t *context, GL_Point_t position, const
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     const GL_Pixel_t *sdata = source->data;
     const GL_Pixel_t *mdata = mask->data;
@@ -557,6 +562,7 @@ void GL_context_blend(const GL_Context_t *context, GL_Point_t position, const GL
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     const GL_Pixel_t *sdata = source->data;
     GL_Pixel_t *ddata = surface->data;
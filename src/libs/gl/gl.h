@@ -42,6 +42,7 @@
 #include "common.h"
 #include "context.h"
 #include "draw.h"
+#include "matcher.h"
 #include "palette.h"
 #include "primitive.h"
 #include "processor.h"
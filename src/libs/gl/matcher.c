@@ -0,0 +1,288 @@
+/*
+ *                 ___________________  _______________ ___
+ *                 \__    ___/\_____  \ \_   _____/    |   \
+ *                   |    |    /   |   \ |    __) |    |   /
+ *                   |    |   /    |    \|     \  |    |  /
+ *                   |____|   \_______  /\___  /  |______/
+ *                                    \/     \/
+ *         ___________ _______    ________.___ _______  ___________
+ *         \_   _____/ \      \  /  _____/|   |\      \ \_   _____/
+ *          |    __)_  /   |   \/   \  ___|   |/   |   \ |    __)_
+ *          |        \/    |    \    \_\  \   /    |    \|        \
+ *         /_______  /\____|__  /\______  /___\____|__  /_______  /
+ *                 \/         \/        \/            \/        \
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2019-2024 Marco Lizza
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "matcher.h"
+
+#include <core/config.h>
+#include <core/platform.h>
+#define _LOG_TAG "gl-matcher"
+#include <libs/log.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(TOFU_GRAPHICS_VECTORIZED_MATCH) && defined(PLATFORM_SIMD_SSE2)
+    #define _GL_MATCHER_SSE2
+    #include <emmintrin.h>
+#endif  /* TOFU_GRAPHICS_VECTORIZED_MATCH */
+
+#define _GL_MATCHER_CUBE_BITS  5
+#define _GL_MATCHER_CUBE_SHIFT (8 - _GL_MATCHER_CUBE_BITS)
+#define _GL_MATCHER_CUBE_CELLS (1 << (_GL_MATCHER_CUBE_BITS * 3))
+
+#if TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM == COLOR_MATCH_PERCEPTUAL
+typedef struct CIELAB_s {
+    float L, a, b;
+} CIELAB_t;
+
+static inline float _gamma_correct(float v)
+{
+    return 100.0f * (v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f));
+}
+
+static inline float _nonlinear_to_linear(float v)
+{
+    return v > 0.008856f ? cbrtf(v) : 7.787f * v + 16.0f / 116.0f;
+}
+
+static inline CIELAB_t _rgb_to_cielab(uint8_t r, uint8_t g, uint8_t b)
+{
+    float red = _gamma_correct((float)r / 255.0f);
+    float green = _gamma_correct((float)g / 255.0f);
+    float blue = _gamma_correct((float)b / 255.0f);
+
+    float xr = _nonlinear_to_linear((red * 0.4124564f + green * 0.3575761f + blue * 0.1804375f) / 95.047f);
+    float yr = _nonlinear_to_linear((red * 0.2126729f + green * 0.7151522f + blue * 0.0721750f) / 100.000f);
+    float zr = _nonlinear_to_linear((red * 0.0193339f + green * 0.1191920f + blue * 0.9503041f) / 108.883f);
+
+    return (CIELAB_t){ 116.0f * yr - 16.0f, 500.0f * (xr - yr), 200.0f * (yr - zr) };
+}
+#endif  /* TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM */
+
+// Converts the color into the (matching algorithm) color-space. For the perceptual matching this is the CIELab one,
+// and this is where the most of the gain is, as the palette entries are converted just once.
+static inline void _convert(GL_Color_t color, float *x, float *y, float *z)
+{
+#if TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM == COLOR_MATCH_PERCEPTUAL
+    CIELAB_t lab = _rgb_to_cielab(color.r, color.g, color.b);
+    *x = lab.L;
+    *y = lab.a;
+    *z = lab.b;
+#else
+    *x = (float)color.r;
+    *y = (float)color.g;
+    *z = (float)color.b;
+#endif  /* TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM */
+}
+
+static void _prepare(GL_Matcher_t *matcher, const GL_Color_t *palette)
+{
+    for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; ++i) {
+        _convert(palette[i], &matcher->components[0][i], &matcher->components[1][i], &matcher->components[2][i]);
+    }
+
+    if (matcher->filled) {
+        memset(matcher->filled, 0x00, _GL_MATCHER_CUBE_CELLS / 8);
+    }
+}
+
+GL_Matcher_t *GL_matcher_create(const GL_Color_t *palette)
+{
+    GL_Matcher_t *matcher = malloc(sizeof(GL_Matcher_t));
+    if (!matcher) {
+        LOG_E("can't allocate matcher");
+        return NULL;
+    }
+
+    *matcher = (GL_Matcher_t){ 0 };
+
+    _prepare(matcher, palette);
+
+    LOG_D("matcher %p created", matcher);
+
+    return matcher;
+}
+
+void GL_matcher_destroy(GL_Matcher_t *matcher)
+{
+    LOG_D("freeing matcher %p", matcher);
+    free(matcher->cube); // The bitmap is part of the same memory block.
+    free(matcher);
+}
+
+void GL_matcher_update(GL_Matcher_t *matcher, const GL_Color_t *palette)
+{
+    _prepare(matcher, palette);
+}
+
+// The distances are computed with the very same operations (and order) in both the scalar and vectorized variants,
+// so that the outcome is identical. Ties are resolved in favour of the lower index.
+#if defined(_GL_MATCHER_SSE2)
+GL_Pixel_t GL_matcher_match(const GL_Matcher_t *matcher, GL_Color_t color)
+{
+    float x, y, z;
+    _convert(color, &x, &y, &z);
+
+    const __m128 cx = _mm_set1_ps(x);
+    const __m128 cy = _mm_set1_ps(y);
+    const __m128 cz = _mm_set1_ps(z);
+#if TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM == COLOR_MATCH_WEIGHTED
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 full = _mm_set1_ps(255.0f);
+#endif  /* TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM */
+
+    __m128 minimum = _mm_set1_ps(__FLT_MAX__);
+    __m128i best = _mm_setzero_si128();
+    __m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i step = _mm_set1_epi32(4);
+
+    for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; i += 4) {
+        const __m128 px = _mm_loadu_ps(&matcher->components[0][i]);
+        const __m128 py = _mm_loadu_ps(&matcher->components[1][i]);
+        const __m128 pz = _mm_loadu_ps(&matcher->components[2][i]);
+
+        const __m128 dx = _mm_sub_ps(cx, px);
+        const __m128 dy = _mm_sub_ps(cy, py);
+        const __m128 dz = _mm_sub_ps(cz, pz);
+
+#if TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM == COLOR_MATCH_WEIGHTED
+        const __m128 r_mean = _mm_mul_ps(_mm_add_ps(cx, px), half);
+        const __m128 wx = _mm_add_ps(two, _mm_div_ps(r_mean, full));
+        const __m128 wz = _mm_add_ps(two, _mm_div_ps(_mm_sub_ps(full, r_mean), full));
+
+        const __m128 distance = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_mul_ps(dx, dx), wx),
+                _mm_mul_ps(_mm_mul_ps(dy, dy), four)),
+                _mm_mul_ps(_mm_mul_ps(dz, dz), wz));
+#else
+        const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+#endif  /* TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM */
+
+        const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, minimum)); // Strict, keeps the first one.
+        minimum = _mm_min_ps(distance, minimum);
+        best = _mm_or_si128(_mm_and_si128(closer, indices), _mm_andnot_si128(closer, best));
+
+        indices = _mm_add_epi32(indices, step);
+    }
+
+    float minima[4];
+    int32_t bests[4];
+    _mm_storeu_ps(minima, minimum);
+    _mm_storeu_si128((__m128i *)bests, best);
+
+    size_t lane = 0;
+    for (size_t i = 1; i < 4; ++i) {
+        if (minima[i] < minima[lane] || (minima[i] == minima[lane] && bests[i] < bests[lane])) {
+            lane = i;
+        }
+    }
+
+    return (GL_Pixel_t)bests[lane];
+}
+#else   /* _GL_MATCHER_SSE2 */
+GL_Pixel_t GL_matcher_match(const GL_Matcher_t *matcher, GL_Color_t color)
+{
+    float x, y, z;
+    _convert(color, &x, &y, &z);
+
+    GL_Pixel_t index = 0;
+    float minimum = __FLT_MAX__;
+    for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; ++i) {
+        const float px = matcher->components[0][i];
+        const float py = matcher->components[1][i];
+        const float pz = matcher->components[2][i];
+
+        const float dx = x - px;
+        const float dy = y - py;
+        const float dz = z - pz;
+
+#if TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM == COLOR_MATCH_WEIGHTED
+        // https://www.compuphase.com/cmetric.htm
+        const float r_mean = (x + px) * 0.5f;
+
+        const float distance = (dx * dx) * (2.0f + (r_mean / 255.0f))
+            + (dy * dy) * 4.0f
+            + (dz * dz) * (2.0f + ((255.0f - r_mean) / 255.0f));
+#else
+        const float distance = dx * dx + dy * dy + dz * dz;
+#endif  /* TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM */
+
+        // Note: computing the square root is unnecessary as the function is
+        //       crescent invariant.
+
+        if (minimum > distance) {
+            minimum = distance;
+            index = (GL_Pixel_t)i;
+        }
+    }
+
+    return index;
+}
+#endif  /* _GL_MATCHER_SSE2 */
+
+GL_Pixel_t GL_matcher_match_cached(GL_Matcher_t *matcher, GL_Color_t color)
+{
+    if (!matcher->cube) {
+        // The cube and its "filled" bitmap are allocated in a single block, the first time they are needed.
+        uint8_t *block = calloc(_GL_MATCHER_CUBE_CELLS + _GL_MATCHER_CUBE_CELLS / 8, sizeof(uint8_t));
+        if (!block) {
+            LOG_W("can't allocate matcher cube, falling back to plain matching");
+            return GL_matcher_match(matcher, color);
+        }
+        matcher->cube = (GL_Pixel_t *)block;
+        matcher->filled = block + _GL_MATCHER_CUBE_CELLS;
+        LOG_D("matcher %p cube allocated", matcher);
+    }
+
+    const size_t r = color.r >> _GL_MATCHER_CUBE_SHIFT;
+    const size_t g = color.g >> _GL_MATCHER_CUBE_SHIFT;
+    const size_t b = color.b >> _GL_MATCHER_CUBE_SHIFT;
+    const size_t cell = (r << (_GL_MATCHER_CUBE_BITS * 2)) | (g << _GL_MATCHER_CUBE_BITS) | b;
+
+    const uint8_t mask = (uint8_t)(1 << (cell & 7));
+    if (matcher->filled[cell >> 3] & mask) {
+        return matcher->cube[cell];
+    }
+
+    // Match the center of the cell, so that the outcome doesn't depend on which color has been queried first.
+    const uint8_t center = 1 << (_GL_MATCHER_CUBE_SHIFT - 1);
+    const GL_Color_t representative = (GL_Color_t){
+            .r = (uint8_t)((r << _GL_MATCHER_CUBE_SHIFT) | center),
+            .g = (uint8_t)((g << _GL_MATCHER_CUBE_SHIFT) | center),
+            .b = (uint8_t)((b << _GL_MATCHER_CUBE_SHIFT) | center),
+            .a = 255
+        };
+    const GL_Pixel_t index = GL_matcher_match(matcher, representative);
+
+    matcher->cube[cell] = index;
+    matcher->filled[cell >> 3] |= mask;
+
+    return index;
+}
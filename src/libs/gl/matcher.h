@@ -0,0 +1,64 @@
+/*
+ *                 ___________________  _______________ ___
+ *                 \__    ___/\_____  \ \_   _____/    |   \
+ *                   |    |    /   |   \ |    __) |    |   /
+ *                   |    |   /    |    \|     \  |    |  /
+ *                   |____|   \_______  /\___  /  |______/
+ *                                    \/     \/
+ *         ___________ _______    ________.___ _______  ___________
+ *         \_   _____/ \      \  /  _____/|   |\      \ \_   _____/
+ *          |    __)_  /   |   \/   \  ___|   |/   |   \ |    __)_
+ *          |        \/    |    \    \_\  \   /    |    \|        \
+ *         /_______  /\____|__  /\______  /___\____|__  /_______  /
+ *                 \/         \/        \/            \/        \
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2019-2024 Marco Lizza
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TOFU_LIBS_GL_MATCHER_H
+#define TOFU_LIBS_GL_MATCHER_H
+
+#include "common.h"
+
+#include <stdint.h>
+
+// A matcher finds the nearest palette color for arbitrary RGB colors. The palette is stored in SoA form (already
+// converted to the color-space the matching algorithm works in) so that it can be scanned with vector instructions.
+//
+// An optional lookup cube can be used, too, where the match for each RGB cell is calculated on first access. It's
+// approximate, as the colors are quantized to the cell center, but it's as fast as a table lookup.
+typedef struct GL_Matcher_s {
+    float components[3][GL_MAX_PALETTE_COLORS];
+    GL_Pixel_t *cube;
+    uint8_t *filled;
+} GL_Matcher_t;
+
+extern GL_Matcher_t *GL_matcher_create(const GL_Color_t *palette);
+extern void GL_matcher_destroy(GL_Matcher_t *matcher);
+
+extern void GL_matcher_update(GL_Matcher_t *matcher, const GL_Color_t *palette);
+
+extern GL_Pixel_t GL_matcher_match(const GL_Matcher_t *matcher, GL_Color_t color);
+extern GL_Pixel_t GL_matcher_match_cached(GL_Matcher_t *matcher, GL_Color_t color);
+
+#endif  /* TOFU_LIBS_GL_MATCHER_H */
@@ -126,89 +126,6 @@ void GL_palette_set_quantized(GL_Color_t *palette, size_t red_bits, size_t green
     }
 }
 
-#if TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM == COLOR_MATCH_PERCEPTUAL
-typedef struct CIELAB_s {
-    float L, a, b;
-} CIELAB_t;
-
-static inline float _gamma_correct(float v)
-{
-    return 100.0f * (v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f));
-}
-
-static inline float _nonlinear_to_linear(float v)
-{
-    return v > 0.008856f ? cbrtf(v) : 7.787f * v + 16.0f / 116.0f;
-}
-
-static inline CIELAB_t _rgb_to_cielab(uint8_t r, uint8_t g, uint8_t b)
-{
-    float red = _gamma_correct((float)r / 255.0f);
-    float green = _gamma_correct((float)g / 255.0f);
-    float blue = _gamma_correct((float)b / 255.0f);
-
-    float xr = _nonlinear_to_linear((red * 0.4124564f + green * 0.3575761f + blue * 0.1804375f) / 95.047f);
-    float yr = _nonlinear_to_linear((red * 0.2126729f + green * 0.7151522f + blue * 0.0721750f) / 100.000f);
-    float zr = _nonlinear_to_linear((red * 0.0193339f + green * 0.1191920f + blue * 0.9503041f) / 108.883f);
-
-    return (CIELAB_t){ 116.0f * yr - 16.0f, 500.0f * (xr - yr), 200.0f * (yr - zr) };
-}
-#endif
-
-GL_Pixel_t GL_palette_find_nearest_color(const GL_Color_t *palette, GL_Color_t color)
-{
-#if TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM == COLOR_MATCH_PERCEPTUAL
-    CIELAB_t color_lab = _rgb_to_cielab(color.r, color.g, color.b);
-#endif
-
-    GL_Pixel_t index = 0;
-    float minimum = __FLT_MAX__;
-    for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; ++i) {
-        const GL_Color_t *current = &palette[i];
-
-#if TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM == COLOR_MATCH_EUCLIDIAN
-        const float delta_r = (float)(color.r - current->r);
-        const float delta_g = (float)(color.g - current->g);
-        const float delta_b = (float)(color.b - current->b);
-
-        const float distance = delta_r * delta_r
-            + delta_g * delta_g
-            + delta_b * delta_b;
-#elif TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM == COLOR_MATCH_WEIGHTED
-        // https://www.compuphase.com/cmetric.htm
-        const float delta_r = (float)(color.r - current->r);
-        const float delta_g = (float)(color.g - current->g);
-        const float delta_b = (float)(color.b - current->b);
-
-        const float r_mean = (float)(color.r + current->r) * 0.5f;
-
-        const float distance = (delta_r * delta_r) * (2.0f + (r_mean / 255.0f))
-            + (delta_g * delta_g) * 4.0f
-            + (delta_b * delta_b) * (2.0f + ((255.0f - r_mean) / 255.0f));
-#elif TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM == COLOR_MATCH_PERCEPTUAL
-        CIELAB_t current_lab = _rgb_to_cielab(current->r, current->g, current->b);
-
-        float delta_L = color_lab.L - current_lab.L;
-        float delta_a = color_lab.a - current_lab.a;
-        float delta_b = color_lab.b - current_lab.b;
-
-        const float distance = delta_L * delta_L
-            + delta_a * delta_a
-            + delta_b * delta_b;
-#endif  /* TOFU_GRAPHICS_COLOR_MATCHING_ALGORITHM */
-
-        // Note: computing the square root is unnecessary as the function is
-        //       crescent invariant.
-
-        if (minimum > distance) {
-            minimum = distance;
-            index = (GL_Pixel_t)i;
-        }
-    }
-
-    return index;
-}
-
 GL_Color_t GL_palette_mix(GL_Color_t from, GL_Color_t to, float ratio)
 {
     return (GL_Color_t){
@@ -224,6 +141,21 @@ void GL_palette_copy(GL_Color_t *palette, const GL_Color_t *source)
     memcpy(palette, source, sizeof(GL_Color_t) * GL_MAX_PALETTE_COLORS);
 }
 
+// 32-bit FNV-1a of the palette entries, in RGBA order. Offline tools compute the very same value, to tag the assets
+// they convert against a given palette.
+uint32_t GL_palette_hash(const GL_Color_t *palette)
+{
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; ++i) {
+        const GL_Color_t *color = &palette[i];
+        const uint8_t bytes[4] = { color->r, color->g, color->b, color->a };
+        for (size_t j = 0; j < 4; ++j) {
+            hash = (hash ^ bytes[j]) * 16777619U;
+        }
+    }
+    return hash;
+}
+
 static bool _contains(const GL_Color_t *palette, GL_Color_t color)
 {
     for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; ++i) {
@@ -62,6 +62,7 @@ static void _point(const GL_Surface_t *surface, const GL_Quad_t *clipping_region
     }
 
     surface->data[y * surface->width + x] = index;
+    GL_surface_touch(surface, (GL_Quad_t){ .x0 = x, .y0 = y, .x1 = x + 1, .y1 = y + 1 });
 }
 
 // https://sighack.com/post/cohen-sutherland-line-clipping-algorithm
@@ -143,6 +144,8 @@ static void _line(const GL_Surface_t *surface, const GL_Quad_t *clipping_region,
         }
     }
 
+    GL_surface_touch(surface, (GL_Quad_t){ .x0 = imin(x0, x1), .y0 = imin(y0, y1), .x1 = imax(x0, x1) + 1, .y1 = imax(y0, y1) + 1 });
+
 #if !defined(__NON_DDA_LINES__)
     GL_Pixel_t *ddata = surface->data;
 
@@ -267,6 +270,7 @@ static void _hline(const GL_Surface_t *surface, const GL_Quad_t *clipping_region
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     GL_Pixel_t *ddata = surface->data;
 
@@ -306,6 +310,7 @@ static void _vline(const GL_Surface_t *surface, const GL_Quad_t *clipping_region
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     GL_Pixel_t *ddata = surface->data;
 
@@ -437,6 +442,7 @@ void GL_context_filled_rectangle(const GL_Context_t *context, GL_Rectangle_t rec
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     GL_Pixel_t *ddata = surface->data;
 
@@ -498,6 +504,7 @@ void GL_context_filled_triangle(const GL_Context_t *context, GL_Point_t v0, GL_P
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out! (can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
 #if defined(TOFU_GRAPHICS_FIX_RASTERIZER_WINDING)
 #if defined(TOFU_GRAPHICS_CLOCKWISE_RASTERIZER_WINDING)
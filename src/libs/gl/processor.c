@@ -42,7 +42,130 @@
 #include <libs/log.h>
 #include <libs/stb.h>
 
-GL_Processor_t *GL_processor_create(void)
+// Minimum amount of scanlines converted by a single worker, to keep the
+// dispatch cost negligible on small surfaces.
+#define _GL_PROCESSOR_MIN_ROWS_PER_JOB 32
+
+typedef struct _Conversion_s {
+    const GL_Processor_State_t *state;
+    const GL_Surface_t *surface;
+    GL_Color_t *pixels;
+    size_t jobs;
+} _Conversion_t;
+
+#if defined(TOFU_GRAPHICS_DEBUG_ENABLED)
+static inline GL_Color_t _fused_color(const GL_Color_t *palette, const GL_Pixel_t *shifting, size_t index)
+{
+    const GL_Pixel_t shifted = shifting[index];
+    if (shifted >= GL_MAX_PALETTE_COLORS - 16) {
+        const int y = (shifted - 240) * 8;
+        return (GL_Color_t){ 0, 63 + y, 0, 255 };
+    }
+    return palette[shifted];
+}
+#else
+static inline GL_Color_t _fused_color(const GL_Color_t *palette, const GL_Pixel_t *shifting, size_t index)
+{
+    return palette[shifting[index]];
+}
+#endif
+
+static void _fuse(GL_Processor_State_t *state)
+{
+    for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; ++i) {
+        state->colors[i] = _fused_color(state->palette, state->shifting, i);
+    }
+}
+
+static void _uncompile(GL_Processor_State_t *state)
+{
+    arrfree(state->program.events);
+    arrfree(state->program.scanlines);
+}
+
+// Replays the program the same way the Copper(tm) would, pixel by pixel, recording for each scanline the (wrapped)
+// offset and the (accumulated) modulo in effect, and the list of the palette/shifting changes occurring on it. Note
+// that the offset is sampled at the beginning of the scanline, and the modulo at its end; that is, both are affected
+// by the commands issued up to the previous/current scanline, respectively.
+static void _compile(GL_Processor_State_t *state, const GL_Program_t *program, size_t width, size_t height)
+{
+    const size_t limit = width * height;
+
+    size_t y = 0;
+    size_t offset = 0; // Always in the range `[0, width)`.
+    int modulo = 0;
+    ptrdiff_t source = 0;
+
+    GL_Processor_Scanline_t scanline = (GL_Processor_Scanline_t){ .offset = offset, .source = source, .events = 0 };
+    arrpush(state->program.scanlines, scanline);
+
+    // Each command is executed as soon as the pixel counter reaches the current `WAIT` position, but never before the
+    // previous command (that is, commands are executed in order).
+    size_t position = 0;
+    size_t wait = 0;
+    const GL_Program_Entry_t *entry = program->entries;
+    for (size_t count = arrlenu(program->entries); count; --count) {
+        if (position < wait) {
+            position = wait;
+        }
+        if (position >= limit) { // Beyond the end of the surface, it won't be ever executed.
+            break;
+        }
+
+        for (; position >= (y + 1) * width; ++y) { // Close the scanlines up to the current one.
+            source += (ptrdiff_t)width + modulo;
+            scanline = (GL_Processor_Scanline_t){ .offset = offset, .source = source, .events = arrlenu(state->program.events) };
+            arrpush(state->program.scanlines, scanline);
+        }
+
+        switch (entry->command) {
+            case GL_PROGRAM_COMMAND_WAIT: {
+                size_t wx = entry->args[0].size;
+                size_t wy = entry->args[1].size;
+                wait = wy * width + wx;
+                break;
+            }
+            case GL_PROGRAM_COMMAND_SKIP: {
+                int dx = entry->args[0].integer;
+                int dy = entry->args[1].integer;
+                wait += dy * width + dx;
+                break;
+            }
+            case GL_PROGRAM_COMMAND_MODULO: {
+                modulo = entry->args[0].integer;
+                break;
+            }
+            case GL_PROGRAM_COMMAND_OFFSET: {
+                // The offset is in the range of a scanline, so we modulo it to spare operations. Note that
+                // we are casting to `int` to avoid integer promotion, as this is a macro!
+                offset = (size_t)IMOD(entry->args[0].integer, (int)width);
+                break;
+            }
+            case GL_PROGRAM_COMMAND_COLOR:
+            case GL_PROGRAM_COMMAND_SHIFT: {
+                const GL_Processor_Event_t event = (GL_Processor_Event_t){ .x = position - y * width, .entry = *entry };
+                arrpush(state->program.events, event);
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+        ++entry;
+    }
+
+    for (; y < height; ++y) { // Close the remaining scanlines, and add the sentinel one.
+        source += (ptrdiff_t)width + modulo;
+        scanline = (GL_Processor_Scanline_t){ .offset = offset, .source = source, .events = arrlenu(state->program.events) };
+        arrpush(state->program.scanlines, scanline);
+    }
+
+#if defined(VERBOSE_DEBUG)
+    LOG_D("program compiled w/ %d event(s) on %d scanline(s)", arrlenu(state->program.events), height);
+#endif  /* VERBOSE_DEBUG */
+}
+
+GL_Processor_t *GL_processor_create(size_t width, size_t height)
 {
     GL_Processor_t *processor = malloc(sizeof(GL_Processor_t));
     if (!processor) {
@@ -50,7 +173,10 @@ GL_Processor_t *GL_processor_create(void)
         return NULL;
     }
 
-    *processor = (GL_Processor_t){ 0 };
+    *processor = (GL_Processor_t){
+            .width = width,
+            .height = height
+        };
 #if defined(VERBOSE_DEBUG)
     LOG_D("processor created at %p", processor);
 #endif  /* VERBOSE_DEBUG */
@@ -84,12 +210,10 @@ GL_Processor_t *GL_processor_create(void)
 
 void GL_processor_destroy(GL_Processor_t *processor)
 {
-    if (processor->state.program) {
-        GL_program_destroy(processor->state.program);
+    _uncompile(&processor->state);
 #if defined(VERBOSE_DEBUG)
-        LOG_D("processor program %p destroyed", processor->state.program);
+    LOG_D("processor program freed");
 #endif  /* VERBOSE_DEBUG */
-    }
 
     free(processor);
 #if defined(VERBOSE_DEBUG)
@@ -112,6 +236,7 @@ const GL_Color_t *GL_processor_get_palette(const GL_Processor_t *processor)
 void GL_processor_set_palette(GL_Processor_t *processor, const GL_Color_t *palette)
 {
     GL_palette_copy(processor->state.palette, palette);
+    _fuse(&processor->state);
 #if defined(VERBOSE_DEBUG)
     LOG_D("palette copied");
 #endif  /* VERBOSE_DEBUG */
@@ -129,169 +254,208 @@ void GL_processor_set_shifting(GL_Processor_t *processor, const GL_Pixel_t *from
             processor->state.shifting[from[i]] = to[i];
         }
     }
+    _fuse(&processor->state);
 }
 
-static void _surface_to_rgba(const GL_Processor_State_t *state, const GL_Surface_t *surface, GL_Color_t *pixels)
+// Since palette and shifting are fused we perform a single lookup per pixel. Note that there's no way to vectorize it
+// further (SSE2 and NEON lack a *gather* instruction), so we just unroll the loop to help the pipelining.
+static inline void _convert(const GL_Color_t *colors, const GL_Pixel_t *src, GL_Color_t *dst, size_t length)
 {
-    const GL_Color_t *palette = state->palette;
-    const GL_Pixel_t *shifting = state->shifting;
+    for (size_t i = length >> 2; i; --i) {
+        dst[0] = colors[src[0]];
+        dst[1] = colors[src[1]];
+        dst[2] = colors[src[2]];
+        dst[3] = colors[src[3]];
+        src += 4;
+        dst += 4;
+    }
+    for (size_t i = length & 3; i; --i) {
+        *(dst++) = colors[*(src++)];
+    }
+}
 
-#if defined(TOFU_GRAPHICS_DEBUG_ENABLED)
-    const int count = processor->palette->size;
-#endif
+// Converts the `[y0, y1)` scanlines range.
+static void _convert_rows(const GL_Processor_State_t *state, const GL_Surface_t *surface, GL_Color_t *pixels, size_t y0, size_t y1)
+{
+    const size_t offset = y0 * surface->width;
+    _convert(state->colors, surface->data + offset, pixels + offset, (y1 - y0) * surface->width);
+}
+
+static void _convert_job(void *user_data, size_t index)
+{
+    const _Conversion_t *conversion = (const _Conversion_t *)user_data;
+    const size_t height = conversion->surface->height;
+    const size_t y0 = height * index / conversion->jobs;
+    const size_t y1 = height * (index + 1) / conversion->jobs;
+    _convert_rows(conversion->state, conversion->surface, conversion->pixels, y0, y1);
+}
+
+static size_t _jobs(const GL_Surface_t *surface, Workers_t *workers)
+{
+    size_t jobs = workers ? Workers_concurrency(workers) : 1;
+    const size_t max_jobs = surface->height / _GL_PROCESSOR_MIN_ROWS_PER_JOB;
+    if (jobs > max_jobs) {
+        jobs = max_jobs > 0 ? max_jobs : 1;
+    }
+    return jobs;
+}
 
-    const size_t data_size = surface->data_size;
+static void _surface_to_rgba(const GL_Processor_State_t *state, const GL_Surface_t *surface, GL_Color_t *pixels, Workers_t *workers)
+{
+    const size_t jobs = _jobs(surface, workers);
+    if (jobs == 1) {
+        _convert_rows(state, surface, pixels, 0, surface->height);
+        return;
+    }
 
-    const GL_Pixel_t *src = surface->data;
-    GL_Color_t *dst = pixels;
+    Workers_run(workers, _convert_job, &(_Conversion_t){
+            .state = state,
+            .surface = surface,
+            .pixels = pixels,
+            .jobs = jobs
+        }, jobs);
+}
 
-    for (size_t i = data_size; i; --i) {
-        const GL_Pixel_t index = shifting[*(src++)];
-#if defined(TOFU_GRAPHICS_DEBUG_ENABLED)
-        GL_Color_t color;
-        if (index >= count) {
-            const int y = (index - 240) * 8;
-            color = (GL_Color_t){ 0, 63 + y, 0, 255 };
-        } else {
-            color = palette[index];
+static inline void _apply(const GL_Program_Entry_t *entry, GL_Color_t *palette, GL_Pixel_t *shifting, GL_Color_t *colors)
+{
+    if (entry->command == GL_PROGRAM_COMMAND_COLOR) {
+        const GL_Pixel_t index = entry->args[0].pixel;
+        palette[index] = entry->args[1].color;
+        for (size_t i = 0; i < GL_MAX_PALETTE_COLORS; ++i) { // Update every fused entry that's shifted to the index.
+            if (shifting[i] == index) {
+                colors[i] = _fused_color(palette, shifting, i);
+            }
         }
-        *(dst++) = color;
-#else
-        *(dst++) = palette[index];
-#endif
+    } else {
+        const GL_Pixel_t from = entry->args[0].pixel;
+        shifting[from] = entry->args[1].pixel;
+        colors[from] = _fused_color(palette, shifting, from);
     }
 }
 
-// TODO: use array of function pointers instead of mega-switch?
-// TODO: ditch wait-x? processor operations changes only once per scanline?
-void _surface_to_rgba_program(const GL_Processor_State_t *state, const GL_Surface_t *surface, GL_Color_t *pixels)
+// Converts the `[x0, x1)` span of a source scanline, wrapping the destination around the `offset`-rotated scanline.
+static inline void _convert_span(const GL_Color_t *colors, const GL_Pixel_t *src, GL_Color_t *dst, size_t width, size_t offset, size_t x0, size_t x1)
+{
+    size_t x = offset + x0;
+    if (x >= width) {
+        x -= width;
+    }
+    const size_t length = x1 - x0;
+    const size_t head = width - x;
+    if (length <= head) {
+        _convert(colors, src + x0, dst + x, length);
+    } else {
+        _convert(colors, src + x0, dst + x, head);
+        _convert(colors, src + x0 + head, dst, length - head);
+    }
+}
+
+// The program is run from its compiled form, that is the per-scanline events table. Between consecutive events we
+// convert the span with the (local) fused palette; scanlines with no events are converted in a single go.
+static void _convert_program_rows(const GL_Processor_State_t *state, const GL_Surface_t *surface, GL_Color_t *pixels, size_t y0, size_t y1)
 {
     GL_Color_t palette[GL_MAX_PALETTE_COLORS];
     GL_Pixel_t shifting[GL_MAX_PALETTE_COLORS];
-    memcpy(palette, state->palette, sizeof(GL_Color_t) * GL_MAX_PALETTE_COLORS); // Make a local copy, the processor could change it.
+    GL_Color_t colors[GL_MAX_PALETTE_COLORS];
+    memcpy(palette, state->palette, sizeof(GL_Color_t) * GL_MAX_PALETTE_COLORS); // Make a local copy, the program will change it.
     memcpy(shifting, state->shifting, sizeof(GL_Pixel_t) * GL_MAX_PALETTE_COLORS);
+    memcpy(colors, state->colors, sizeof(GL_Color_t) * GL_MAX_PALETTE_COLORS);
 
-    size_t wait = 0;
-#if defined(TOFU_GRAPHICS_DEBUG_ENABLED)
-    const int count = processor->palette->size;
-#endif
-    int modulo = 0;
-    size_t offset = 0; // Always in the range `[0, width)`.
+    const GL_Processor_Event_t *events = state->program.events;
+    const GL_Processor_Scanline_t *scanlines = state->program.scanlines;
 
-    const GL_Program_Entry_t *entry = state->program->entries;
-    const GL_Pixel_t *src = surface->data;
-    GL_Color_t *dst_sod = pixels;
-
-    const size_t dwidth = surface->width;
-    const size_t dheight = surface->height;
-
-    size_t i = 0;
-    for (size_t h = dheight; h; --h) {
-        GL_Color_t *dst_eod = dst_sod + dwidth;
-        GL_Color_t *dst = dst_sod + offset; // Apply the (wrapped) offset separately on this row pointer to check row "restart".
-
-        for (size_t w = dwidth; w; --w) {
-            // Note: there's no length indicator for the processor program. That means that the interpreter would run
-            // endlessly (and unsafely read outside memory bounds, causing crashes). To avoid this a "wait forever"
-            // trailer is added to the program in the `GL_program_create()` and `GL_program_reset()` functions.
-            // This somehow mimics the real Copper(tm) behaviour, where a special `WAIT` instruction `$FFFF, $FFFE`
-            // is used to mark the end of the processor.
-#if defined(__PROCESSOR_ONE_COMMAND_PER_PIXEL__)
-            if (i >= wait) {
-#else
-            while (i >= wait) {
-#endif
-                switch (entry->command) {
-                    case GL_PROGRAM_COMMAND_NOP: {
-                        break;
-                    }
-                    case GL_PROGRAM_COMMAND_WAIT: {
-                        size_t x = entry->args[0].size;
-                        size_t y = entry->args[1].size;
-                        wait = y * dwidth + x;
-                        break;
-                    }
-                    case GL_PROGRAM_COMMAND_SKIP: {
-                        int dx = entry->args[0].integer;
-                        int dy = entry->args[1].integer;
-                        wait += dy * dwidth + dx;
-                        break;
-                    }
-                    case GL_PROGRAM_COMMAND_MODULO: {
-                        modulo = entry->args[0].integer;
-                        break;
-                    }
-                    case GL_PROGRAM_COMMAND_OFFSET: {
-                        // The offset is in the range of a scanline, so we modulo it to spare operations. Note that
-                        // we are casting to `int` to avoid integer promotion, as this is a macro!
-                        offset = (size_t)IMOD(entry->args[0].integer, (int)dwidth);
-                        break;
-                    }
-                    case GL_PROGRAM_COMMAND_COLOR: {
-                        const GL_Pixel_t index = entry->args[0].pixel;
-                        const GL_Color_t color = entry->args[1].color;
-                        palette[index] = color;
-                        break;
-                    }
-                    case GL_PROGRAM_COMMAND_SHIFT: {
-                        const GL_Pixel_t from = entry->args[0].pixel;
-                        const GL_Pixel_t to = entry->args[1].pixel;
-                        shifting[from] = to;
-                        break;
-                    }
-                    default: {
-                        break;
-                    }
-                }
-                ++entry;
-            }
+    // Fast-forward the palette state by replaying the events of the preceding scanlines.
+    const GL_Processor_Event_t *event = events;
+    for (const GL_Processor_Event_t *eod = events + scanlines[y0].events; event < eod; ++event) {
+        _apply(&event->entry, palette, shifting, colors);
+    }
 
-            const GL_Pixel_t index = shifting[*(src++)];
-#if defined(TOFU_GRAPHICS_DEBUG_ENABLED)
-            GL_Color_t color;
-            if (index >= count) {
-                const int v = (index - 240) * 8;
-                color = (GL_Color_t){ 0, 63 + v, 0, 255 };
-            } else {
-                color = palette[index];
-            }
-            *(dst++) = color;
-#else
-            *(dst++) = palette[index];
-#endif
-            if (dst == dst_eod) { // Wrap on end-of-data. Check for equality since we are copy one pixel at time.
-                dst = dst_sod;
-            }
+    const size_t width = surface->width;
 
-            ++i;
+    for (size_t y = y0; y < y1; ++y) {
+        const GL_Processor_Scanline_t *scanline = &scanlines[y];
+        const GL_Processor_Event_t *eod = events + scanline[1].events;
+        const GL_Pixel_t *src = surface->data + scanline->source;
+        GL_Color_t *dst = pixels + y * width;
+        const size_t offset = scanline->offset;
+
+        if (event == eod && offset == 0) {
+            _convert(colors, src, dst, width);
+            continue;
         }
 
-        src += modulo;
-        dst_sod += dwidth;
+        size_t x = 0;
+        for (; event < eod; ++event) {
+            if (event->x > x) {
+                _convert_span(colors, src, dst, width, offset, x, event->x);
+                x = event->x;
+            }
+            _apply(&event->entry, palette, shifting, colors);
+        }
+        if (x < width) {
+            _convert_span(colors, src, dst, width, offset, x, width);
+        }
     }
 }
 
-// FIXME: make a copy or track the reference? (also for xform and palettes)
-void GL_processor_set_program(GL_Processor_t *processor, const GL_Program_t *program)
+static void _convert_program_job(void *user_data, size_t index)
 {
-    if (processor->state.program) { // Deallocate current program, is present.
-       GL_program_destroy(processor->state.program);
-#if defined(VERBOSE_DEBUG)
-        LOG_D("processor program %p destroyed", processor->program);
-#endif  /* VERBOSE_DEBUG */
-        processor->state.program = NULL;
+    const _Conversion_t *conversion = (const _Conversion_t *)user_data;
+    const size_t height = conversion->surface->height;
+    const size_t y0 = height * index / conversion->jobs;
+    const size_t y1 = height * (index + 1) / conversion->jobs;
+    _convert_program_rows(conversion->state, conversion->surface, conversion->pixels, y0, y1);
+}
+
+static void _surface_to_rgba_program(const GL_Processor_State_t *state, const GL_Surface_t *surface, GL_Color_t *pixels, Workers_t *workers)
+{
+    const size_t jobs = _jobs(surface, workers);
+    if (jobs == 1) {
+        _convert_program_rows(state, surface, pixels, 0, surface->height);
+        return;
     }
 
+    Workers_run(workers, _convert_program_job, &(_Conversion_t){
+            .state = state,
+            .surface = surface,
+            .pixels = pixels,
+            .jobs = jobs
+        }, jobs);
+}
+
+void GL_processor_set_program(GL_Processor_t *processor, const GL_Program_t *program)
+{
+    _uncompile(&processor->state); // Discard the current program, if present.
+
     if (program) {
-        processor->state.program = GL_program_clone(program);
-#if defined(VERBOSE_DEBUG)
-        LOG_D("processor program at %p copied at %p", program, processor->program);
-#endif  /* VERBOSE_DEBUG */
+        _compile(&processor->state, program, processor->width, processor->height);
     }
     processor->surface_to_rgba = program ? _surface_to_rgba_program : _surface_to_rgba;
 }
 
-void GL_processor_surface_to_rgba(const GL_Processor_t *processor, const GL_Surface_t *surface, GL_Color_t *pixels)
+bool GL_processor_has_program(const GL_Processor_t *processor)
+{
+    return processor->state.program.scanlines != NULL;
+}
+
+void GL_processor_surface_to_rgba(const GL_Processor_t *processor, const GL_Surface_t *surface, GL_Color_t *pixels, Workers_t *workers)
 {
-    processor->surface_to_rgba(&processor->state, surface, pixels);
+    processor->surface_to_rgba(&processor->state, surface, pixels, workers);
+}
+
+void GL_processor_surface_to_rgba_area(const GL_Processor_t *processor, const GL_Surface_t *surface, GL_Color_t *pixels, GL_Quad_t area)
+{
+    const GL_Color_t *colors = processor->state.colors;
+
+    const size_t width = surface->width;
+    const size_t length = (size_t)(area.x1 - area.x0);
+
+    const GL_Pixel_t *src = surface->data + area.y0 * width + area.x0;
+    GL_Color_t *dst = pixels + area.y0 * width + area.x0;
+
+    for (int i = area.y1 - area.y0; i > 0; --i) {
+        _convert(colors, src, dst, length);
+        src += width;
+        dst += width;
+    }
 }
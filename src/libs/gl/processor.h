@@ -43,20 +43,41 @@
 #include "program.h"
 #include "surface.h"
 
+#include <libs/workers.h>
+
+// A `COLOR` or `SHIFT` program command, executed when the conversion reaches the `x` pixel of the scanline.
+typedef struct GL_Processor_Event_s {
+    size_t x;
+    GL_Program_Entry_t entry;
+} GL_Processor_Event_t;
+
+typedef struct GL_Processor_Scanline_s {
+    size_t offset; // Destination offset, in the range `[0, width)`.
+    ptrdiff_t source; // Index of the scanline first source pixel (modulos accumulate along the surface).
+    size_t events; // Index of the first event, the following scanline marks the end of the list.
+} GL_Processor_Scanline_t;
+
 typedef struct GL_Processor_State_s {
     GL_Color_t palette[GL_MAX_PALETTE_COLORS];
     GL_Pixel_t shifting[GL_MAX_PALETTE_COLORS];
-    GL_Program_t *program;
+    GL_Color_t colors[GL_MAX_PALETTE_COLORS]; // Palette and shifting fused together, i.e. `palette[shifting[i]]`.
+    struct {
+        GL_Processor_Event_t *events;
+        GL_Processor_Scanline_t *scanlines; // One entry per scanline, plus a trailing sentinel.
+    } program;
 } GL_Processor_State_t;
 
-typedef void (*GL_Processor_Surface_To_Rgba_t)(const GL_Processor_State_t *state, const GL_Surface_t *surface, GL_Color_t *pixels);
+typedef void (*GL_Processor_Surface_To_Rgba_t)(const GL_Processor_State_t *state, const GL_Surface_t *surface, GL_Color_t *pixels, Workers_t *workers);
 
 typedef struct GL_Processor_s {
+    size_t width, height;
     GL_Processor_State_t state;
     GL_Processor_Surface_To_Rgba_t surface_to_rgba;
 } GL_Processor_t;
 
-extern GL_Processor_t *GL_processor_create(void);
+// The processor is bound to the size of the surfaces it will convert, as the
+// program is compiled (when set) into a per-scanline events table.
+extern GL_Processor_t *GL_processor_create(size_t width, size_t height);
 extern void GL_processor_destroy(GL_Processor_t *processor);
 
 extern void GL_processor_reset(GL_Processor_t *processor);
@@ -67,6 +88,12 @@ extern void GL_processor_set_palette(GL_Processor_t *processor, const GL_Color_t
 extern void GL_processor_set_shifting(GL_Processor_t *processor, const GL_Pixel_t *from, const GL_Pixel_t *to, size_t count);
 extern void GL_processor_set_program(GL_Processor_t *processor, const GL_Program_t *program);
 
-extern void GL_processor_surface_to_rgba(const GL_Processor_t *processor, const GL_Surface_t *surface, GL_Color_t *pixels);
+extern bool GL_processor_has_program(const GL_Processor_t *processor);
+
+// The conversion is spread across the `workers` (if not `NULL`) by scanline ranges.
+extern void GL_processor_surface_to_rgba(const GL_Processor_t *processor, const GL_Surface_t *surface, GL_Color_t *pixels, Workers_t *workers);
+// Converts the (half-open) `area` only, ignoring the program. A surface with an active program need to be fully
+// converted, as the program changes can't be localized.
+extern void GL_processor_surface_to_rgba_area(const GL_Processor_t *processor, const GL_Surface_t *surface, GL_Color_t *pixels, GL_Quad_t area);
 
 #endif  /* TOFU_LIBS_GL_PROCESSOR_H */
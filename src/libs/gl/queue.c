@@ -41,9 +41,31 @@
 
 #include <core/config.h>
 #define _LOG_TAG "gl-queue"
+#include <libs/fmath.h>
+#include <libs/imath.h>
 #include <libs/log.h>
 #include <libs/stb.h>
 
+#include <math.h>
+
+// Bands thinner than this won't repay the cost of the dispatch, and the amount
+// of bands is reduced accordingly.
+#define _GL_QUEUE_MIN_BAND_HEIGHT 16
+
+// The layers are sorted with a LSD radix sort, a byte at a time.
+#define _GL_QUEUE_RADIX_BITS    8
+#define _GL_QUEUE_RADIX_BUCKETS (1 << _GL_QUEUE_RADIX_BITS)
+#define _GL_QUEUE_RADIX_MASK    (_GL_QUEUE_RADIX_BUCKETS - 1)
+#define _GL_QUEUE_RADIX_PASSES  (32 / _GL_QUEUE_RADIX_BITS)
+
+typedef struct _Flush_s {
+    const GL_Queue_t *queue;
+    const GL_Context_t *context;
+    const GL_Surface_t *surface; // Untracked copy of the context surface.
+    GL_Queue_Modes_t mode;
+    size_t bands;
+} _Flush_t;
+
 GL_Queue_t *GL_queue_create(const GL_Sheet_t *sheet, size_t capacity)
 {
     GL_Queue_t *queue = malloc(sizeof(GL_Queue_t));
@@ -63,7 +85,11 @@ GL_Queue_t *GL_queue_create(const GL_Sheet_t *sheet, size_t capacity)
 
     *queue = (GL_Queue_t){
             .sheet = sheet,
-            .sprites = sprites
+            .sprites = sprites,
+            .sorted = true,
+            .entries = NULL,
+            .scratch = NULL,
+            .stats = { 0 }
         };
     LOG_D("queue %p attached", queue);
 
@@ -77,6 +103,10 @@ error_exit:
 
 void GL_queue_destroy(GL_Queue_t *queue)
 {
+    arrfree(queue->scratch);
+    arrfree(queue->entries);
+    LOG_D("queue entries freed");
+
     arrfree(queue->sprites);
     LOG_D("queue sprites freed");
 
@@ -112,42 +142,226 @@ void GL_queue_clear(GL_Queue_t *queue)
 {
     static const size_t zero = 0; // Note: we don't pass the immediate `0` to avoid a "type-limit" warning from the compiler.
     arrsetlen(queue->sprites, zero);
+    queue->sorted = true;
 }
 
 void GL_queue_add(GL_Queue_t *queue, GL_Queue_Sprite_t sprite)
 {
+    const size_t count = arrlenu(queue->sprites);
+    if (count > 0 && sprite.z < queue->sprites[count - 1].z) {
+        queue->sorted = false;
+    }
     arrpush(queue->sprites, sprite);
 }
 
-void GL_queue_blit(const GL_Queue_t *queue, const GL_Context_t *context)
+// Conservative (half-open) bounding rectangle of the sprite, mirroring the drawing regions computed by the blitting
+// functions prior clipping.
+static inline GL_Quad_t _bounds(const GL_Queue_Sprite_t *sprite, GL_Rectangle_t area, GL_Queue_Modes_t mode)
 {
-    const GL_Sheet_t *sheet = queue->sheet;
+    const GL_Point_t position = sprite->position;
 
-    const GL_Queue_Sprite_t *current = queue->sprites;
-    for (size_t count = arrlenu(queue->sprites); count; --count) {
-        const GL_Queue_Sprite_t *sprite = current++;
-        GL_sheet_blit(sheet, context, sprite->position, sprite->cell_id);
+    if (mode == GL_QUEUE_MODE_FAST) {
+        return (GL_Quad_t){
+                .x0 = position.x,
+                .y0 = position.y,
+                .x1 = position.x + (int)area.width,
+                .y1 = position.y + (int)area.height
+            };
+    } else
+    if (mode == GL_QUEUE_MODE_SCALED) {
+        return (GL_Quad_t){
+                .x0 = position.x,
+                .y0 = position.y,
+                .x1 = position.x + ITRUNC((float)area.width * FABS(sprite->scale_x)),
+                .y1 = position.y + ITRUNC((float)area.height * FABS(sprite->scale_y))
+            };
     }
+
+    // The rotated sprite is bound by the disc centered at the anchor point.
+    const float dw = (float)area.width * FABS(sprite->scale_x);
+    const float dh = (float)area.height * FABS(sprite->scale_y);
+    const float dax = (dw - 1.0f) * sprite->anchor_x;
+    const float day = (dh - 1.0f) * sprite->anchor_y;
+    const float delta_x = fmaxf(dax, dw - dax) - 0.5f;
+    const float delta_y = fmaxf(day, dh - day) - 0.5f;
+    const int radius = ICEILF(sqrtf(delta_x * delta_x + delta_y * delta_y)) + 1; // Add a pixel to be on the safe side.
+
+    return (GL_Quad_t){
+            .x0 = position.x - radius,
+            .y0 = position.y - radius,
+            .x1 = position.x + radius + 1,
+            .y1 = position.y + radius + 1
+        };
 }
 
-void GL_queue_blit_s(const GL_Queue_t *queue, const GL_Context_t *context)
+static inline bool _is_outside(GL_Quad_t bounds, const GL_Quad_t *clipping_region)
 {
-    const GL_Sheet_t *sheet = queue->sheet;
+    return bounds.x1 <= clipping_region->x0 || bounds.x0 >= clipping_region->x1
+        || bounds.y1 <= clipping_region->y0 || bounds.y0 >= clipping_region->y1;
+}
 
-    const GL_Queue_Sprite_t *current = queue->sprites;
-    for (size_t count = arrlenu(queue->sprites); count; --count) {
-        const GL_Queue_Sprite_t *sprite = current++;
-        GL_sheet_blit_s(sheet, context, sprite->position, sprite->cell_id, sprite->scale_x, sprite->scale_y);
+// Stable, least-significant-digit first, radix sort. Passes where every key share the same digit are skipped, so
+// that a single-layer queue is never actually moved around.
+static GL_Queue_Entry_t *_sort(GL_Queue_Entry_t *entries, GL_Queue_Entry_t *scratch, size_t count)
+{
+    GL_Queue_Entry_t *source = entries;
+    GL_Queue_Entry_t *target = scratch;
+
+    for (size_t pass = 0; pass < _GL_QUEUE_RADIX_PASSES; ++pass) {
+        const size_t shift = pass * _GL_QUEUE_RADIX_BITS;
+
+        size_t offsets[_GL_QUEUE_RADIX_BUCKETS] = { 0 };
+        for (size_t i = 0; i < count; ++i) {
+            offsets[(source[i].key >> shift) & _GL_QUEUE_RADIX_MASK] += 1;
+        }
+        if (offsets[(source[0].key >> shift) & _GL_QUEUE_RADIX_MASK] == count) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t i = 0; i < _GL_QUEUE_RADIX_BUCKETS; ++i) {
+            const size_t amount = offsets[i];
+            offsets[i] = offset;
+            offset += amount;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const GL_Queue_Entry_t entry = source[i];
+            target[offsets[(entry.key >> shift) & _GL_QUEUE_RADIX_MASK]++] = entry;
+        }
+
+        GL_Queue_Entry_t *swap = source;
+        source = target;
+        target = swap;
     }
+
+    return source;
 }
 
-void GL_queue_blit_sr(const GL_Queue_t *queue, const GL_Context_t *context)
+// Builds the list of the sprites to be drawn, in drawing order. Must be called before any (possibly concurrent)
+// drawing takes place.
+static void _prepare(GL_Queue_t *queue, const GL_Quad_t *clipping_region, GL_Queue_Modes_t mode)
+{
+    const GL_Rectangle_t *cells = queue->sheet->cells;
+
+    const size_t count = arrlenu(queue->sprites);
+    arrsetlen(queue->entries, count);
+    arrsetlen(queue->scratch, count);
+
+    size_t drawn = 0;
+    const GL_Queue_Sprite_t *sprites = queue->sprites;
+    for (size_t i = 0; i < count; ++i) {
+        const GL_Queue_Sprite_t *sprite = &sprites[i];
+        if (_is_outside(_bounds(sprite, cells[sprite->cell_id], mode), clipping_region)) {
+            continue;
+        }
+        queue->entries[drawn++] = (GL_Queue_Entry_t){
+                .key = (uint32_t)sprite->z ^ 0x80000000u, // Flip the sign bit, so that negative layers come first.
+                .index = (uint32_t)i
+            };
+    }
+    arrsetlen(queue->entries, drawn);
+
+    if (!queue->sorted && drawn > 1) {
+        GL_Queue_Entry_t *sorted = _sort(queue->entries, queue->scratch, drawn);
+        if (sorted != queue->entries) { // Swap the buffers, rather than copying back.
+            queue->scratch = queue->entries;
+            queue->entries = sorted;
+            arrsetlen(queue->entries, drawn);
+        }
+    }
+
+    queue->stats = (GL_Queue_Stats_t){
+            .culled = count - drawn,
+            .drawn = drawn
+        };
+}
+
+static void _draw(const GL_Queue_t *queue, const GL_Context_t *context, GL_Queue_Modes_t mode)
 {
     const GL_Sheet_t *sheet = queue->sheet;
+    const GL_Queue_Sprite_t *sprites = queue->sprites;
+
+    const GL_Queue_Entry_t *current = queue->entries;
+    for (size_t count = arrlenu(queue->entries); count; --count) {
+        const GL_Queue_Sprite_t *sprite = &sprites[(current++)->index];
+        if (mode == GL_QUEUE_MODE_FAST) {
+            GL_sheet_blit(sheet, context, sprite->position, sprite->cell_id);
+        } else
+        if (mode == GL_QUEUE_MODE_SCALED) {
+            GL_sheet_blit_s(sheet, context, sprite->position, sprite->cell_id, sprite->scale_x, sprite->scale_y);
+        } else {
+            GL_sheet_blit_sr(sheet, context, sprite->position, sprite->cell_id, sprite->scale_x, sprite->scale_y, sprite->rotation, sprite->anchor_x, sprite->anchor_y);
+        }
+    }
+}
+
+void GL_queue_blit(GL_Queue_t *queue, const GL_Context_t *context)
+{
+    _prepare(queue, &context->state.current.clipping_region, GL_QUEUE_MODE_FAST);
+    _draw(queue, context, GL_QUEUE_MODE_FAST);
+}
+
+void GL_queue_blit_s(GL_Queue_t *queue, const GL_Context_t *context)
+{
+    _prepare(queue, &context->state.current.clipping_region, GL_QUEUE_MODE_SCALED);
+    _draw(queue, context, GL_QUEUE_MODE_SCALED);
+}
+
+void GL_queue_blit_sr(GL_Queue_t *queue, const GL_Context_t *context)
+{
+    _prepare(queue, &context->state.current.clipping_region, GL_QUEUE_MODE_COMPLETE);
+    _draw(queue, context, GL_QUEUE_MODE_COMPLETE);
+}
+
+static void _flush_band(void *user_data, size_t index)
+{
+    const _Flush_t *flush = (const _Flush_t *)user_data;
 
-    const GL_Queue_Sprite_t *current = queue->sprites;
-    for (size_t count = arrlenu(queue->sprites); count; --count) {
-        const GL_Queue_Sprite_t *sprite = current++;
-        GL_sheet_blit_sr(sheet, context, sprite->position, sprite->cell_id, sprite->scale_x, sprite->scale_y, sprite->rotation, sprite->anchor_x, sprite->anchor_y);
+    GL_Context_t context = *flush->context; // Shallow copy, to restrict the clipping region to the band only.
+    context.surface = flush->surface;
+    GL_Quad_t *clipping_region = &context.state.current.clipping_region;
+    const int y0 = clipping_region->y0;
+    const int height = clipping_region->y1 - clipping_region->y0;
+    clipping_region->y0 = y0 + (int)((size_t)height * index / flush->bands);
+    clipping_region->y1 = y0 + (int)((size_t)height * (index + 1) / flush->bands);
+
+    _draw(flush->queue, &context, flush->mode);
+}
+
+void GL_queue_blit_parallel(GL_Queue_t *queue, const GL_Context_t *context, GL_Queue_Modes_t mode, Workers_t *workers)
+{
+    const GL_Quad_t *clipping_region = &context->state.current.clipping_region;
+    const int height = clipping_region->y1 - clipping_region->y0;
+    if (height <= 0) {
+        queue->stats = (GL_Queue_Stats_t){ .culled = arrlenu(queue->sprites), .drawn = 0 };
+        return;
     }
+
+    _prepare(queue, clipping_region, mode); // Culling and sorting are done once, in advance, for all the bands.
+
+    size_t bands = Workers_concurrency(workers);
+    const size_t max_bands = (size_t)height / _GL_QUEUE_MIN_BAND_HEIGHT;
+    if (bands > max_bands) {
+        bands = max_bands > 0 ? max_bands : 1;
+    }
+
+    // Bands could share the same dirty tiles (and revision), so we mark the whole clipping region in advance and let
+    // the bands draw on an untracked copy of the surface descriptor.
+    GL_surface_touch(context->surface, *clipping_region);
+    GL_Surface_t surface = *context->surface;
+    surface.dirty.tiles = NULL;
+    surface.revision = NULL;
+
+    if (mode == GL_QUEUE_MODE_FAST) {
+        GL_sheet_prepare(queue->sheet, context); // Lazy compilation can't happen concurrently (and follows the touch).
+    }
+
+    Workers_run(workers, _flush_band, &(_Flush_t){
+            .queue = queue,
+            .context = context,
+            .surface = &surface,
+            .mode = mode,
+            .bands = bands
+        }, bands);
 }
@@ -42,19 +42,45 @@
 #include "sheet.h"
 #include "surface.h"
 
+#include <libs/workers.h>
+
 #include <stdbool.h>
 
+typedef enum GL_Queue_Modes_e {
+    GL_Queue_Modes_t_First = 0,
+    GL_QUEUE_MODE_FAST = GL_Queue_Modes_t_First,
+    GL_QUEUE_MODE_SCALED,
+    GL_QUEUE_MODE_COMPLETE,
+    GL_Queue_Modes_t_Last = GL_QUEUE_MODE_COMPLETE,
+    GL_Queue_Modes_t_CountOf
+} GL_Queue_Modes_t;
+
 typedef struct GL_Queue_Sprite_s {
     GL_Cell_t cell_id;
     GL_Point_t position;
     float scale_x, scale_y;
     int rotation;
     float anchor_x, anchor_y;
+    int z; // Layer, sprites are drawn in ascending order (and in submission order within the same layer).
 } GL_Queue_Sprite_t;
 
+typedef struct GL_Queue_Entry_s {
+    uint32_t key;
+    uint32_t index;
+} GL_Queue_Entry_t;
+
+typedef struct GL_Queue_Stats_s {
+    size_t culled;
+    size_t drawn;
+} GL_Queue_Stats_t;
+
 typedef struct GL_Queue_s {
     const GL_Sheet_t *sheet;
     GL_Queue_Sprite_t *sprites;
+    bool sorted; // Tells whether the sprites have been submitted with non-decreasing layers.
+    GL_Queue_Entry_t *entries; // Visible sprites, in drawing order (rebuilt on every flush).
+    GL_Queue_Entry_t *scratch;
+    GL_Queue_Stats_t stats; // Updated on every flush.
 } GL_Queue_t;
 
 extern GL_Queue_t *GL_queue_create(const GL_Sheet_t *sheet, size_t capacity);
@@ -67,8 +93,15 @@ extern void GL_queue_add(GL_Queue_t *queue, GL_Queue_Sprite_t sprite);
 
 //extern GL_Queue_Sprite_t *GL_queue_get_sprite(const GL_Queue_t *queue, size_t index);
 
-void GL_queue_blit(const GL_Queue_t *queue, const GL_Context_t *context); // FIXME: rename to `flush()`
-void GL_queue_blit_s(const GL_Queue_t *queue, const GL_Context_t *context);
-void GL_queue_blit_sr(const GL_Queue_t *queue, const GL_Context_t *context);
+// Prior drawing, the sprites whose bounding rectangle is completely outside the clipping region are culled and the
+// remaining ones are (stable) radix-sorted by layer. The outcome is reported in the `stats` field of the queue.
+void GL_queue_blit(GL_Queue_t *queue, const GL_Context_t *context); // FIXME: rename to `flush()`
+void GL_queue_blit_s(GL_Queue_t *queue, const GL_Context_t *context);
+void GL_queue_blit_sr(GL_Queue_t *queue, const GL_Context_t *context);
+
+// Splits the (clipping region of the) context into horizontal bands, each one
+// drawn by a distinct worker. Sprites are drawn in submission order within
+// every band, so that the result is the same of the serial counterpart.
+void GL_queue_blit_parallel(GL_Queue_t *queue, const GL_Context_t *context, GL_Queue_Modes_t mode, Workers_t *workers);
 
 #endif  /* TOFU_LIBS_GL_QUEUE_H */
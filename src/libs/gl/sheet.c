@@ -48,6 +48,7 @@
 #include <libs/stb.h>
 
 #include <math.h>
+#include <string.h>
 
 static GL_Rectangle_t *_parse_cells(const GL_Rectangle32_t *rectangles, size_t count)
 {
@@ -159,6 +160,17 @@ error_exit:
 
 void GL_sheet_destroy(GL_Sheet_t *sheet)
 {
+    if (sheet->cache) {
+        for (size_t i = 0; i < GL_SHEET_COMPILED_VARIANTS; ++i) {
+            GL_Sheet_Compiled_t *compiled = &sheet->cache->variants[i];
+            arrfree(compiled->cells);
+            arrfree(compiled->rows);
+            arrfree(compiled->spans);
+        }
+        free(sheet->cache);
+        LOG_D("sheet compiled spans freed");
+    }
+
     free(sheet->cells);
     LOG_D("sheet cells freed");
 
@@ -166,6 +178,204 @@ void GL_sheet_destroy(GL_Sheet_t *sheet)
     LOG_D("sheet %p freed", sheet);
 }
 
+static inline bool _is_skipped(const uint32_t *skipped, GL_Pixel_t index)
+{
+    return (skipped[index >> 5] >> (index & 31)) & 1;
+}
+
+static void _compile(GL_Sheet_Compiled_t *compiled, const GL_Sheet_t *sheet, const uint32_t *skipped)
+{
+    static const size_t zero = 0; // Note: we don't pass the immediate `0` to avoid a "type-limit" warning from the compiler.
+    arrsetlen(compiled->cells, zero);
+    arrsetlen(compiled->rows, zero);
+    arrsetlen(compiled->spans, zero);
+
+    const GL_Surface_t *atlas = sheet->atlas;
+    const size_t swidth = atlas->width;
+
+    for (size_t i = 0; i < sheet->count; ++i) {
+        const GL_Rectangle_t *cell = &sheet->cells[i];
+        const int width = (int)cell->width;
+
+        arrpush(compiled->cells, arrlenu(compiled->rows));
+
+        const GL_Pixel_t *sptr = atlas->data + cell->y * swidth + cell->x;
+        for (size_t j = cell->height; j; --j) {
+            arrpush(compiled->rows, arrlenu(compiled->spans));
+
+            for (int x = 0; x < width; ) {
+                if (_is_skipped(skipped, sptr[x])) {
+                    ++x;
+                    continue;
+                }
+                const int offset = x;
+                while (x < width && !_is_skipped(skipped, sptr[x])) {
+                    ++x;
+                }
+                arrpush(compiled->spans, ((GL_Sheet_Span_t){ .offset = offset, .length = x - offset }));
+            }
+
+            sptr += swidth;
+        }
+    }
+    arrpush(compiled->rows, arrlenu(compiled->spans)); // Sentinel, to get the spans count of the very last row.
+
+    memcpy(compiled->skipped, skipped, sizeof(compiled->skipped));
+
+    LOG_D("sheet %p compiled w/ %d rows and %d spans", sheet, arrlenu(compiled->rows) - 1, arrlenu(compiled->spans));
+}
+
+static const GL_Sheet_Compiled_t *_lookup(const GL_Sheet_Cache_t *cache, const uint32_t *skipped)
+{
+    for (size_t i = 0; i < cache->count; ++i) {
+        const GL_Sheet_Compiled_t *compiled = &cache->variants[i];
+        if (memcmp(compiled->skipped, skipped, sizeof(compiled->skipped)) == 0) {
+            return compiled;
+        }
+    }
+    return NULL;
+}
+
+static const GL_Sheet_Compiled_t *_prepare(const GL_Sheet_t *sheet, const uint32_t *skipped)
+{
+    GL_Sheet_Cache_t *cache = sheet->cache;
+
+    const size_t revision = GL_surface_revision(sheet->atlas);
+    if (cache->revision != revision) { // The atlas has been written, every variant is stale.
+        LOG_D("sheet %p atlas changed, discarding %d compiled variant(s)", sheet, cache->count);
+        cache->revision = revision;
+        cache->count = 0;
+        cache->next = 0;
+    }
+
+    const GL_Sheet_Compiled_t *compiled = _lookup(cache, skipped);
+    if (compiled) {
+        return compiled; // Hits don't write anything, so that concurrent blits are safe once prepared.
+    }
+
+    GL_Sheet_Compiled_t *variant = &cache->variants[cache->next];
+    cache->next = (cache->next + 1) % GL_SHEET_COMPILED_VARIANTS;
+    if (cache->count < GL_SHEET_COMPILED_VARIANTS) {
+        cache->count += 1;
+    }
+    _compile(variant, sheet, skipped);
+
+    return variant;
+}
+
+bool GL_sheet_compile(GL_Sheet_t *sheet)
+{
+    if (!sheet->cache) {
+        sheet->cache = malloc(sizeof(GL_Sheet_Cache_t));
+        if (!sheet->cache) {
+            LOG_E("can't allocate sheet compiled spans");
+            return false;
+        }
+        *sheet->cache = (GL_Sheet_Cache_t){ 0 };
+    }
+
+    // Discard the previous variants, if any, and build the one for the default
+    // context state (that is only the `0` index is transparent).
+    sheet->cache->revision = GL_surface_revision(sheet->atlas);
+    sheet->cache->count = 0;
+    sheet->cache->next = 0;
+
+    const uint32_t skipped[GL_MAX_PALETTE_COLORS / 32] = { 1U };
+    _prepare(sheet, skipped);
+
+    return true;
+}
+
+void GL_sheet_prepare(const GL_Sheet_t *sheet, const GL_Context_t *context)
+{
+    if (!sheet->cache) {
+        return;
+    }
+
+    _prepare(sheet, context->state.current.masks.skipped);
+}
+
+static void _blit_compiled(const GL_Sheet_t *sheet, const GL_Context_t *context, GL_Point_t position, size_t cell_id)
+{
+    const GL_Surface_t *surface = context->surface;
+    const GL_State_t *state = &context->state.current;
+    const GL_Quad_t *clipping_region = &state->clipping_region;
+    const GL_Pixel_t *shifting = state->shifting;
+
+    const GL_Sheet_Compiled_t *compiled = _prepare(sheet, state->masks.skipped);
+
+    const GL_Rectangle_t *cell = &sheet->cells[cell_id];
+
+    int skip_x = 0; // Offset into the cell, updated during clipping.
+    int skip_y = 0;
+
+    GL_Quad_t drawing_region = (GL_Quad_t){
+            .x0 = position.x,
+            .y0 = position.y,
+            .x1 = position.x + (int)cell->width,
+            .y1 = position.y + (int)cell->height
+        };
+
+    if (drawing_region.x0 < clipping_region->x0) {
+        skip_x += clipping_region->x0 - drawing_region.x0;
+        drawing_region.x0 = clipping_region->x0;
+    }
+    if (drawing_region.y0 < clipping_region->y0) {
+        skip_y += clipping_region->y0 - drawing_region.y0;
+        drawing_region.y0 = clipping_region->y0;
+    }
+    if (drawing_region.x1 > clipping_region->x1) {
+        drawing_region.x1 = clipping_region->x1;
+    }
+    if (drawing_region.y1 > clipping_region->y1) {
+        drawing_region.y1 = clipping_region->y1;
+    }
+
+    const int width = drawing_region.x1 - drawing_region.x0;
+    const int height = drawing_region.y1 - drawing_region.y0;
+    if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
+        return;
+    }
+    GL_surface_touch(surface, drawing_region);
+
+    const int left = skip_x; // Visible portion of the cell (in cell coordinates).
+    const int right = skip_x + width;
+
+    const size_t swidth = sheet->atlas->width;
+    const size_t dwidth = surface->width;
+
+    const GL_Pixel_t *sptr = sheet->atlas->data + (cell->y + skip_y) * swidth + cell->x;
+    GL_Pixel_t *dptr = surface->data + drawing_region.y0 * dwidth + drawing_region.x0;
+
+    const bool identity = state->masks.identity;
+    const GL_Sheet_Span_t *spans = compiled->spans;
+    const size_t *row = compiled->rows + compiled->cells[cell_id] + skip_y;
+
+    for (int i = height; i; --i) {
+        const GL_Sheet_Span_t *span = spans + row[0];
+        const GL_Sheet_Span_t *end = spans + row[1];
+        for (; span < end && span->offset < right; ++span) {
+            const int x0 = imax(span->offset, left);
+            const int x1 = imin(span->offset + span->length, right);
+            if (x0 >= x1) {
+                continue;
+            }
+            const GL_Pixel_t *src = sptr + x0;
+            GL_Pixel_t *dst = dptr + (x0 - left);
+            if (identity) {
+                memcpy(dst, src, (size_t)(x1 - x0));
+            } else {
+                for (int j = x1 - x0; j; --j) {
+                    *(dst++) = shifting[*(src++)];
+                }
+            }
+        }
+        ++row;
+        sptr += swidth;
+        dptr += dwidth;
+    }
+}
+
 GL_Size_t GL_sheet_size(const GL_Sheet_t *sheet, size_t cell_id, float scale_x, float scale_y)
 {
     const GL_Rectangle_t *cell = &sheet->cells[cell_id];
@@ -177,6 +387,10 @@ GL_Size_t GL_sheet_size(const GL_Sheet_t *sheet, size_t cell_id, float scale_x,
 
 void GL_sheet_blit(const GL_Sheet_t *sheet, const GL_Context_t *context, GL_Point_t position, size_t cell_id)
 {
+    if (sheet->cache) {
+        _blit_compiled(sheet, context, position, cell_id);
+        return;
+    }
     GL_context_blit(context, position, sheet->atlas, sheet->cells[cell_id]);
 }
 
@@ -44,17 +44,56 @@
 #include "context.h"
 #include "surface.h"
 
+typedef struct GL_Sheet_Span_s {
+    int offset; // Relative to the cell left edge.
+    int length;
+} GL_Sheet_Span_t;
+
+// Amount of compiled forms (i.e. distinct transparency masks) that are kept at once for a sheet.
+#define GL_SHEET_COMPILED_VARIANTS  4
+
+// The *compiled* form of the sheet holds, for every row of each cell, the list
+// of opaque spans. They depend on the context transparency (and shifting), so
+// the masks they are built upon are stored, too.
+typedef struct GL_Sheet_Compiled_s {
+    uint32_t skipped[GL_MAX_PALETTE_COLORS / 32];
+    size_t *cells; // Index, for each cell, of its first entry in `rows`.
+    size_t *rows; // Index, for each row, of its first span (with a trailing sentinel).
+    GL_Sheet_Span_t *spans;
+} GL_Sheet_Compiled_t;
+
+// The cache is lazily filled while blitting, so it's mutable even when the
+// sheet is shared as `const`. The variants are replaced in round-robin order,
+// and they are all discarded once the atlas revision changes.
+typedef struct GL_Sheet_Cache_s {
+    size_t revision; // Atlas revision the variants are built upon.
+    GL_Sheet_Compiled_t variants[GL_SHEET_COMPILED_VARIANTS];
+    size_t count;
+    size_t next;
+} GL_Sheet_Cache_t;
+
 typedef struct GL_Sheet_s {
     const GL_Surface_t *atlas;
 
     GL_Rectangle_t *cells;
     size_t count;
+
+    GL_Sheet_Cache_t *cache; // Optional, `NULL` when not compiled.
 } GL_Sheet_t;
 
 extern GL_Sheet_t *GL_sheet_create_fixed(const GL_Surface_t *atlas, GL_Size_t cell_size);
 extern GL_Sheet_t *GL_sheet_create(const GL_Surface_t *atlas, const GL_Rectangle32_t *cells, size_t count);
 extern void GL_sheet_destroy(GL_Sheet_t *sheet);
 
+// Builds the opaque-spans cache of the cells, that will be used from now on by
+// `GL_sheet_blit()`. Writes to the atlas are detected (by means of its revision)
+// and the spans are rebuilt on the next blit.
+extern bool GL_sheet_compile(GL_Sheet_t *sheet);
+// Brings the compiled spans up-to-date with the context state and the atlas. It's
+// implicitly called by `GL_sheet_blit()` and it's required only prior concurrent
+// blits (which then only read the cache).
+extern void GL_sheet_prepare(const GL_Sheet_t *sheet, const GL_Context_t *context);
+
 extern GL_Size_t GL_sheet_size(const GL_Sheet_t *sheet, size_t cell_id, float scale_x, float scale_y);
 
 extern void GL_sheet_blit(const GL_Sheet_t *sheet, const GL_Context_t *context, GL_Point_t position, size_t cell_id);
@@ -38,6 +38,7 @@
 #include "surface.h"
 
 #include <core/config.h>
+#include <libs/imath.h>
 #define _LOG_TAG "gl-surface"
 #include <libs/log.h>
 #include <libs/stb.h>
@@ -68,10 +69,17 @@ GL_Surface_t *GL_surface_create(size_t width, size_t height)
         goto error_exit;
     }
 
+    size_t *revision = malloc(sizeof(size_t));
+    if (!revision) {
+        LOG_E("can't allocate surface revision");
+        goto error_free_data;
+    }
+    *revision = 0;
+
     GL_Surface_t *surface = malloc(sizeof(GL_Surface_t));
     if (!surface) {
         LOG_E("can't allocate surface");
-        goto error_free_data;
+        goto error_free_revision;
     }
 
     *surface = (GL_Surface_t){
@@ -79,13 +87,16 @@ GL_Surface_t *GL_surface_create(size_t width, size_t height)
             .height = height,
             .data = data,
             .data_size = width * height,
-            .is_power_of_two = _is_power_of_two((int)width) && _is_power_of_two((int)height)
+            .is_power_of_two = _is_power_of_two((int)width) && _is_power_of_two((int)height),
+            .revision = revision
         };
 
     LOG_D("surface created at %p (%dx%d)", data, width, height);
 
     return surface;
 
+error_free_revision:
+    free(revision);
 error_free_data:
     free(data);
 error_exit:
@@ -94,6 +105,13 @@ error_exit:
 
 void GL_surface_destroy(GL_Surface_t *surface)
 {
+    if (surface->dirty.tiles) {
+        free(surface->dirty.tiles);
+        LOG_D("surface dirty-tiles at %p freed", surface->dirty.tiles);
+    }
+
+    free(surface->revision);
+
     free(surface->data);
     LOG_D("surface data at %p freed", surface->data);
 
@@ -101,8 +119,100 @@ void GL_surface_destroy(GL_Surface_t *surface)
     LOG_D("surface %p freed", surface);
 }
 
+bool GL_surface_track(GL_Surface_t *surface)
+{
+    const size_t columns = (surface->width + GL_SURFACE_DIRTY_TILE_SIZE - 1) / GL_SURFACE_DIRTY_TILE_SIZE;
+    const size_t rows = (surface->height + GL_SURFACE_DIRTY_TILE_SIZE - 1) / GL_SURFACE_DIRTY_TILE_SIZE;
+    const size_t stride = (columns + 31) / 32;
+
+    uint32_t *tiles = malloc(sizeof(uint32_t) * stride * rows);
+    if (!tiles) {
+        LOG_E("can't allocate (%dx%d) dirty-tiles", columns, rows);
+        return false;
+    }
+
+    surface->dirty.tiles = tiles;
+    surface->dirty.columns = columns;
+    surface->dirty.rows = rows;
+    surface->dirty.stride = stride;
+    LOG_D("surface %p tracked w/ %dx%d dirty-tiles", surface, columns, rows);
+
+    GL_surface_touch_all(surface); // Initially the whole surface needs to be refreshed.
+
+    return true;
+}
+
+void GL_surface_touch(const GL_Surface_t *surface, GL_Quad_t area)
+{
+    if (surface->revision) {
+        *surface->revision += 1;
+    }
+
+    uint32_t *tiles = surface->dirty.tiles;
+    if (!tiles) {
+        return;
+    }
+
+    const int x0 = imax(area.x0, 0);
+    const int y0 = imax(area.y0, 0);
+    const int x1 = imin(area.x1, (int)surface->width);
+    const int y1 = imin(area.y1, (int)surface->height);
+    if ((x0 >= x1) || (y0 >= y1)) {
+        return;
+    }
+
+    const size_t c0 = (size_t)x0 / GL_SURFACE_DIRTY_TILE_SIZE;
+    const size_t c1 = (size_t)(x1 - 1) / GL_SURFACE_DIRTY_TILE_SIZE;
+    const size_t r0 = (size_t)y0 / GL_SURFACE_DIRTY_TILE_SIZE;
+    const size_t r1 = (size_t)(y1 - 1) / GL_SURFACE_DIRTY_TILE_SIZE;
+
+    const size_t stride = surface->dirty.stride;
+    for (size_t r = r0; r <= r1; ++r) {
+        uint32_t *row = tiles + r * stride;
+        for (size_t c = c0; c <= c1; ++c) {
+            row[c / 32] |= 1u << (c % 32);
+        }
+    }
+}
+
+void GL_surface_touch_all(const GL_Surface_t *surface)
+{
+    if (surface->revision) {
+        *surface->revision += 1;
+    }
+
+    if (!surface->dirty.tiles) {
+        return;
+    }
+    memset(surface->dirty.tiles, 0xff, sizeof(uint32_t) * surface->dirty.stride * surface->dirty.rows);
+}
+
+void GL_surface_untouch(const GL_Surface_t *surface)
+{
+    if (!surface->dirty.tiles) {
+        return;
+    }
+    memset(surface->dirty.tiles, 0x00, sizeof(uint32_t) * surface->dirty.stride * surface->dirty.rows);
+}
+
+bool GL_surface_is_touched(const GL_Surface_t *surface, size_t column, size_t row)
+{
+    const uint32_t *tiles = surface->dirty.tiles;
+    if (!tiles) {
+        return true; // Untracked surfaces are always to be considered modified.
+    }
+    return tiles[row * surface->dirty.stride + column / 32] & (1u << (column % 32));
+}
+
+size_t GL_surface_revision(const GL_Surface_t *surface)
+{
+    return surface->revision ? *surface->revision : 0;
+}
+
 void GL_surface_clear(const GL_Surface_t *surface, GL_Pixel_t index)
 {
+    GL_surface_touch_all(surface);
+
 #if defined(__NO_MEMSET_MEMCPY__)
     GL_Pixel_t *dst = surface->data;
     for (size_t i = surface->data_size; i; --i) {
@@ -121,4 +231,5 @@ GL_Pixel_t GL_surface_peek(const GL_Surface_t *surface, GL_Point_t position)
 void GL_surface_poke(const GL_Surface_t *surface, GL_Point_t position, GL_Pixel_t index)
 {
     surface->data[position.y * surface->width + position.x] = index;
+    GL_surface_touch(surface, (GL_Quad_t){ .x0 = position.x, .y0 = position.y, .x1 = position.x + 1, .y1 = position.y + 1 });
 }
@@ -41,12 +41,22 @@
 #include "common.h"
 
 #include <stdbool.h>
+#include <stdint.h>
+
+// Size (in pixels) of the square tiles used to track the modified areas of a surface.
+#define GL_SURFACE_DIRTY_TILE_SIZE  16
 
 typedef struct GL_Surface_s {
     size_t width, height; // FIXME: use `GL_Size_t`.
     GL_Pixel_t *data;
     size_t data_size;
     bool is_power_of_two;
+    size_t *revision; // Bumped on every touch, to detect stale derived data (it's a pointer as surfaces are shared as `const`).
+    struct { // Coarse bit-map of the modified tiles, `tiles` is `NULL` when the tracking is not enabled.
+        uint32_t *tiles;
+        size_t columns, rows;
+        size_t stride; // Amount of words per tiles row.
+    } dirty;
 } GL_Surface_t;
 
 typedef void (*GL_Surface_Callback_t)(void *user_data, GL_Surface_t *surface, const void *pixels); // RGBA888 format.
@@ -57,6 +67,16 @@ extern GL_Surface_t *GL_surface_decode(size_t width, size_t height, const void *
 extern GL_Surface_t *GL_surface_create(size_t width, size_t height);
 extern void GL_surface_destroy(GL_Surface_t *surface);
 
+// Dirty tracking is opt-in, and it's enabled only for the surfaces that need it (i.e. the display canvas). Drawing
+// operations mark the area they could have modified with `GL_surface_touch()` (the area is half-open). Regardless of
+// the tracking, touching a surface always bumps its revision.
+extern bool GL_surface_track(GL_Surface_t *surface);
+extern void GL_surface_touch(const GL_Surface_t *surface, GL_Quad_t area);
+extern void GL_surface_touch_all(const GL_Surface_t *surface);
+extern void GL_surface_untouch(const GL_Surface_t *surface);
+extern bool GL_surface_is_touched(const GL_Surface_t *surface, size_t column, size_t row);
+extern size_t GL_surface_revision(const GL_Surface_t *surface);
+
 extern void GL_surface_clear(const GL_Surface_t *surface, GL_Pixel_t index);
 extern GL_Pixel_t GL_surface_peek(const GL_Surface_t *surface, GL_Point_t position);
 extern void GL_surface_poke(const GL_Surface_t *surface, GL_Point_t position, GL_Pixel_t index);
@@ -85,6 +85,7 @@ extern void GL_context_tile(const GL_Context_t *context, GL_Point_t position, co
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     const GL_Pixel_t *sdata = source->data;
     GL_Pixel_t *ddata = surface->data;
@@ -163,6 +164,7 @@ void GL_context_tile_s(const GL_Context_t *context, GL_Point_t position, const G
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
     const GL_Pixel_t *sdata = source->data;
     GL_Pixel_t *ddata = surface->data;
@@ -43,6 +43,41 @@
 #include <libs/log.h>
 #include <libs/stb.h>
 
+// Texture coordinates are stepped in 16.16 fixed-point. We use 64-bits integers (that is 48.16) in the general case,
+// to avoid overflows when the H/V offsets are large; the repeat case with power-of-two sizes can safely wrap-around
+// on 32-bits, instead, as only the (masked) lower bits of the integer part are used.
+#define _GL_XFORM_FIXED_SHIFT  16
+#define _GL_XFORM_FIXED_ONE    (1 << _GL_XFORM_FIXED_SHIFT)
+
+typedef struct _Source_s {
+    const GL_Pixel_t *data; // Pointing to the area origin.
+    size_t stride;
+    int width, height;
+} _Source_t;
+
+typedef struct _Span_s {
+    int64_t x, y; // Fixed-point, already biased by one half for rounding.
+    int64_t dx, dy;
+    size_t length;
+} _Span_t;
+
+typedef void (*_Span_Function_t)(GL_Pixel_t *dptr, const _Source_t *source, const _Span_t *span, const GL_State_t *state);
+
+#if defined(TOFU_GRAPHICS_XFORM_TRANSPARENCY)
+  #define _WRITE(p, i, t) \
+    do { \
+        if (!(t)[(i)]) { \
+            *(p) = (i); \
+        } \
+    } while (0)
+#else
+  #define _WRITE(p, i, t) \
+    do { \
+        (void)(t); \
+        *(p) = (i); /* NOTE: no transparency in Mode-7! */ \
+    } while (0)
+#endif  /* TOFU_GRAPHICS_XFORM_TRANSPARENCY */
+
 #if defined(TOFU_GRAPHICS_DEBUG_ENABLED)
 static inline void _pixel(const GL_Surface_t *surface, int x, int y, int index)
 {
@@ -119,6 +154,236 @@ void GL_xform_table(GL_XForm_t *xform, const GL_XForm_Table_Entry_t *entries, si
     arrpush(xform->table, (GL_XForm_Table_Entry_t){ .scan_line = -1 }); // Set the end-of-data (safety) marker
 }
 
+// https://www.khronos.org/registry/OpenGL/specs/gl/glspec46.core.pdf
+// see page #260
+//
+// The wrap mode is resolved once per blit, by picking one of the following span functions.
+
+// Faster case, when the source area is power-of-two (just a bitmask). No branches in the loop, the compiler is free
+// to vectorize it.
+static void _span_repeat_pot(GL_Pixel_t *dptr, const _Source_t *source, const _Span_t *span, const GL_State_t *state)
+{
+    const GL_Pixel_t *sdata = source->data;
+    const size_t stride = source->stride;
+    const uint32_t mx = (uint32_t)source->width - 1;
+    const uint32_t my = (uint32_t)source->height - 1;
+    const GL_Pixel_t *shifting = state->shifting;
+    const GL_Bool_t *transparent = state->transparent;
+
+    uint32_t x = (uint32_t)span->x;
+    uint32_t y = (uint32_t)span->y;
+    const uint32_t dx = (uint32_t)span->dx;
+    const uint32_t dy = (uint32_t)span->dy;
+
+    for (size_t i = span->length; i; --i) {
+        const uint32_t sx = (x >> _GL_XFORM_FIXED_SHIFT) & mx;
+        const uint32_t sy = (y >> _GL_XFORM_FIXED_SHIFT) & my;
+        const GL_Pixel_t index = shifting[sdata[sy * stride + sx]];
+        _WRITE(dptr, index, transparent);
+        ++dptr;
+        x += dx;
+        y += dy;
+    }
+}
+
+static void _span_repeat(GL_Pixel_t *dptr, const _Source_t *source, const _Span_t *span, const GL_State_t *state)
+{
+    const GL_Pixel_t *sdata = source->data;
+    const size_t stride = source->stride;
+    const int sw = source->width;
+    const int sh = source->height;
+    const GL_Pixel_t *shifting = state->shifting;
+    const GL_Bool_t *transparent = state->transparent;
+
+    // Bring the starting point in range (keeping the fractional part), so that the coordinates can be wrapped with
+    // a single compare-and-subtract as long as the step is smaller than the source size.
+    const int64_t fw = (int64_t)sw << _GL_XFORM_FIXED_SHIFT;
+    const int64_t fh = (int64_t)sh << _GL_XFORM_FIXED_SHIFT;
+    int64_t x = IMOD(span->x, fw);
+    int64_t y = IMOD(span->y, fh);
+    const int64_t dx = span->dx % fw;
+    const int64_t dy = span->dy % fh;
+
+    for (size_t i = span->length; i; --i) {
+        const int sx = (int)(x >> _GL_XFORM_FIXED_SHIFT);
+        const int sy = (int)(y >> _GL_XFORM_FIXED_SHIFT);
+        const GL_Pixel_t index = shifting[sdata[sy * stride + sx]];
+        _WRITE(dptr, index, transparent);
+        ++dptr;
+        x += dx;
+        if (x >= fw) {
+            x -= fw;
+        } else
+        if (x < 0) {
+            x += fw;
+        }
+        y += dy;
+        if (y >= fh) {
+            y -= fh;
+        } else
+        if (y < 0) {
+            y += fh;
+        }
+    }
+}
+
+static void _span_clamp_to_edge(GL_Pixel_t *dptr, const _Source_t *source, const _Span_t *span, const GL_State_t *state)
+{
+    const GL_Pixel_t *sdata = source->data;
+    const size_t stride = source->stride;
+    const int swm1 = source->width - 1;
+    const int shm1 = source->height - 1;
+    const GL_Pixel_t *shifting = state->shifting;
+    const GL_Bool_t *transparent = state->transparent;
+
+    int64_t x = span->x;
+    int64_t y = span->y;
+    const int64_t dx = span->dx;
+    const int64_t dy = span->dy;
+
+    for (size_t i = span->length; i; --i) {
+        const int64_t sx = x >> _GL_XFORM_FIXED_SHIFT;
+        const int64_t sy = y >> _GL_XFORM_FIXED_SHIFT;
+        const int cx = (int)ICLAMP(sx, 0, swm1);
+        const int cy = (int)ICLAMP(sy, 0, shm1);
+        const GL_Pixel_t index = shifting[sdata[cy * stride + cx]];
+        _WRITE(dptr, index, transparent);
+        ++dptr;
+        x += dx;
+        y += dy;
+    }
+}
+
+static void _span_clamp_to_border(GL_Pixel_t *dptr, const _Source_t *source, const _Span_t *span, const GL_State_t *state)
+{
+    const GL_Pixel_t *sdata = source->data;
+    const size_t stride = source->stride;
+    const int64_t sw = source->width;
+    const int64_t sh = source->height;
+    const GL_Pixel_t *shifting = state->shifting;
+    const GL_Bool_t *transparent = state->transparent;
+
+    int64_t x = span->x;
+    int64_t y = span->y;
+    const int64_t dx = span->dx;
+    const int64_t dy = span->dy;
+
+    for (size_t i = span->length; i; --i) {
+        const int64_t sx = x >> _GL_XFORM_FIXED_SHIFT;
+        const int64_t sy = y >> _GL_XFORM_FIXED_SHIFT;
+        if (sx >= 0 && sx < sw && sy >= 0 && sy < sh) {
+            const GL_Pixel_t index = shifting[sdata[sy * (int64_t)stride + sx]];
+            _WRITE(dptr, index, transparent);
+        }
+        ++dptr;
+        x += dx;
+        y += dy;
+    }
+}
+
+static void _span_mirrored_repeat(GL_Pixel_t *dptr, const _Source_t *source, const _Span_t *span, const GL_State_t *state)
+{
+    const GL_Pixel_t *sdata = source->data;
+    const size_t stride = source->stride;
+    const int64_t sw = source->width;
+    const int64_t sh = source->height;
+    const int64_t swb2 = sw * 2;
+    const int64_t shb2 = sh * 2;
+    const GL_Pixel_t *shifting = state->shifting;
+    const GL_Bool_t *transparent = state->transparent;
+
+    int64_t x = span->x;
+    int64_t y = span->y;
+    const int64_t dx = span->dx;
+    const int64_t dy = span->dy;
+
+    for (size_t i = span->length; i; --i) {
+        const int64_t mx = IMOD(x >> _GL_XFORM_FIXED_SHIFT, swb2); // There's a typo in OpenGL's formula. Correct one is:
+        const int64_t my = IMOD(y >> _GL_XFORM_FIXED_SHIFT, shb2); // (size - 1) - mirror((coord mod (2 x size)) - size)
+        const int64_t sx = (sw - 1) - IMIRROR(mx - sw);
+        const int64_t sy = (sh - 1) - IMIRROR(my - sh);
+        const GL_Pixel_t index = shifting[sdata[sy * (int64_t)stride + sx]];
+        _WRITE(dptr, index, transparent);
+        ++dptr;
+        x += dx;
+        y += dy;
+    }
+}
+
+static void _span_mirror_clamp_to_edge(GL_Pixel_t *dptr, const _Source_t *source, const _Span_t *span, const GL_State_t *state)
+{
+    const GL_Pixel_t *sdata = source->data;
+    const size_t stride = source->stride;
+    const int64_t swm1 = source->width - 1;
+    const int64_t shm1 = source->height - 1;
+    const GL_Pixel_t *shifting = state->shifting;
+    const GL_Bool_t *transparent = state->transparent;
+
+    int64_t x = span->x;
+    int64_t y = span->y;
+    const int64_t dx = span->dx;
+    const int64_t dy = span->dy;
+
+    for (size_t i = span->length; i; --i) {
+        const int64_t mx = IMIRROR(x >> _GL_XFORM_FIXED_SHIFT);
+        const int64_t my = IMIRROR(y >> _GL_XFORM_FIXED_SHIFT);
+        const int64_t sx = ICLAMP(mx, 0, swm1);
+        const int64_t sy = ICLAMP(my, 0, shm1);
+        const GL_Pixel_t index = shifting[sdata[sy * (int64_t)stride + sx]];
+        _WRITE(dptr, index, transparent);
+        ++dptr;
+        x += dx;
+        y += dy;
+    }
+}
+
+// This is a (not so wild) guess... :)
+static void _span_mirror_clamp_to_border(GL_Pixel_t *dptr, const _Source_t *source, const _Span_t *span, const GL_State_t *state)
+{
+    const GL_Pixel_t *sdata = source->data;
+    const size_t stride = source->stride;
+    const int64_t sw = source->width;
+    const int64_t sh = source->height;
+    const GL_Pixel_t *shifting = state->shifting;
+    const GL_Bool_t *transparent = state->transparent;
+
+    int64_t x = span->x;
+    int64_t y = span->y;
+    const int64_t dx = span->dx;
+    const int64_t dy = span->dy;
+
+    for (size_t i = span->length; i; --i) {
+        const int64_t sx = IMIRROR(x >> _GL_XFORM_FIXED_SHIFT);
+        const int64_t sy = IMIRROR(y >> _GL_XFORM_FIXED_SHIFT);
+        if (sx < sw && sy < sh) { // Mirrored coordinates are never negative.
+            const GL_Pixel_t index = shifting[sdata[sy * (int64_t)stride + sx]];
+            _WRITE(dptr, index, transparent);
+        }
+        ++dptr;
+        x += dx;
+        y += dy;
+    }
+}
+
+static const _Span_Function_t _span_functions[GL_XForm_Wraps_t_CountOf] = {
+    _span_repeat,
+    _span_clamp_to_edge,
+    _span_clamp_to_border,
+    _span_mirrored_repeat,
+    _span_mirror_clamp_to_edge,
+    _span_mirror_clamp_to_border
+};
+
+static inline bool _is_power_of_two(int n)
+{
+    return n && !(n & (n - 1));
+}
+
+static inline int64_t _to_fixed(double value)
+{
+    return (int64_t)floor(value * (double)_GL_XFORM_FIXED_ONE + 0.5); // Round to the nearest fixed-point value.
+}
+
 // https://www.youtube.com/watch?v=3FVN_Ze7bzw
 // http://www.coranac.com/tonc/text/mode7.htm
 // https://wiki.superfamicom.org/registers
@@ -128,13 +393,8 @@ void GL_xform_blit(const GL_XForm_t *xform, const GL_Context_t *context, GL_Poin
     const GL_Surface_t *surface = context->surface;
     const GL_State_t *state = &context->state.current;
     const GL_Quad_t *clipping_region = &state->clipping_region;
-    const GL_Pixel_t *shifting = state->shifting;
-#if defined(TOFU_GRAPHICS_XFORM_TRANSPARENCY)
-    const GL_Bool_t *transparent = state->transparent;
-#endif  /* TOFU_GRAPHICS_XFORM_TRANSPARENCY */
 
     const GL_XForm_Table_Entry_t *table = xform->table;
-    const GL_XForm_Wraps_t wrap = xform->wrap;
 
     GL_Quad_t drawing_region = (GL_Quad_t){
             .x0 = position.x,
@@ -161,25 +421,28 @@ void GL_xform_blit(const GL_XForm_t *xform, const GL_Context_t *context, GL_Poin
     if ((width <= 0) || (height <= 0)) { // Nothing to draw! Bail out!(can be negative due to clipping region)
         return;
     }
+    GL_surface_touch(surface, drawing_region);
 
-    const int sw = (int)area.width;
-    const int sh = (int)area.height;
-    const int swm1 = sw - 1;
-    const int shm1 = sh - 1;
-    const int swb2 = sw * 2;
-    const int shb2 = sh * 2;
-    const bool is_power_of_two = source->is_power_of_two;
+    const _Source_t span_source = (_Source_t){
+            .data = source->data + area.y * (int)source->width + area.x,
+            .stride = source->width,
+            .width = (int)area.width,
+            .height = (int)area.height
+        };
+
+    // Note that we are checking the *area* size, which is what we are wrapping around.
+    const bool is_power_of_two = _is_power_of_two(span_source.width) && _is_power_of_two(span_source.height)
+        && span_source.width <= _GL_XFORM_FIXED_ONE && span_source.height <= _GL_XFORM_FIXED_ONE;
+    const _Span_Function_t span_function = xform->wrap == GL_XFORM_WRAP_REPEAT && is_power_of_two
+        ? _span_repeat_pot
+        : _span_functions[xform->wrap];
 
-    const GL_Pixel_t *sdata = source->data;
     GL_Pixel_t *ddata = surface->data;
 
-    const size_t swidth = source->width;
     const size_t dwidth = surface->width;
 
     GL_Pixel_t *dptr = ddata + drawing_region.y0 * dwidth + drawing_region.x0;
 
-    const size_t dskip = dwidth - width;
-
     // The basic Mode7 formula is the following
     //
     // [ X ]   [ A B ]   [ SX + H - CX ]   [ CX ]
@@ -204,6 +467,9 @@ void GL_xform_blit(const GL_XForm_t *xform, const GL_Context_t *context, GL_Poin
     //
     // X = A * (SX - CX) + B * (SY - CY) + CX + H
     // Y = C * (SX - CX) + D * (SY - CY) + CY + V
+    //
+    // The scan-line starting point is computed in (double precision) floating-point, then we step along the line
+    // in fixed-point. The one-half bias accounts for the rounding to the nearest texel.
     const float *registers = xform->registers;
     float h = registers[GL_XFORM_REGISTER_H]; float v = registers[GL_XFORM_REGISTER_V];
     float a = registers[GL_XFORM_REGISTER_A]; float b = registers[GL_XFORM_REGISTER_B];
@@ -235,89 +501,30 @@ void GL_xform_blit(const GL_XForm_t *xform, const GL_Context_t *context, GL_Poin
 #endif
         }
 
-        const float xi = 0.0f - x0;
-        const float yi = (float)i - y0;
+        const double xi = 0.0 - (double)x0;
+        const double yi = (double)i - (double)y0;
 
 #if !defined(__CLIP_OFFSET__)
-        float xp = (a * xi + b * yi) + x0 + h;
-        float yp = (c * xi + d * yi) + y0 + v;
+        const double xp = ((double)a * xi + (double)b * yi) + (double)x0 + (double)h;
+        const double yp = ((double)c * xi + (double)d * yi) + (double)y0 + (double)v;
 #else
-        float xp = (a * xi + b * yi) + x0 + fmodf(h, sw); // Clip to avoid cancellation when H/V are large.
-        float yp = (c * xi + d * yi) + y0 + fmodf(v, sh);
+        const double xp = ((double)a * xi + (double)b * yi) + (double)x0 + fmod(h, span_source.width); // Clip to avoid cancellation when H/V are large.
+        const double yp = ((double)c * xi + (double)d * yi) + (double)y0 + fmod(v, span_source.height);
 #endif
 
-        for (int j = 0; j < width; ++j) {
 #if defined(TOFU_GRAPHICS_DEBUG_ENABLED)
+        for (int j = 0; j < width; ++j) {
             _pixel(surface, drawing_region.x0 + j, drawing_region.y0 + i, i + j);
-#endif
-            int sx = IROUNDF(xp); // Preserve direction, for negative values!
-            int sy = IROUNDF(yp);
-
-            // https://www.khronos.org/registry/OpenGL/specs/gl/glspec46.core.pdf
-            // see page #260
-            bool copy = true;
-            if (wrap == GL_XFORM_WRAP_REPEAT) {
-                if (is_power_of_two) { // Faster case, when the source texture is power-of-two (just a bitmask).
-                    sx &= swm1;
-                    sy &= shm1;
-                } else {
-                    sx = IMOD(sx, sw);
-                    sy = IMOD(sy, sh);
-                }
-            } else
-            if (wrap == GL_XFORM_WRAP_CLAMP_TO_EDGE) {
-                sx = ICLAMP(sx, 0, swm1);
-                sy = ICLAMP(sy, 0, shm1);
-            } else
-            if (wrap == GL_XFORM_WRAP_CLAMP_TO_BORDER) {
-                if (sx < 0 || sx > swm1 || sy < 0 || sy > shm1) {
-                    copy = false;
-                }
-            } else
-            if (wrap == GL_XFORM_WRAP_MIRRORED_REPEAT) {
-                const int mx = IMOD(sx, swb2); // There's a typo in OpenGL's formula. Correct one is:
-                const int my = IMOD(sy, shb2); // (size - 1) - mirror((coord mod (2 x size)) - size)
-                sx = swm1 - IMIRROR(mx - sw);
-                sy = shm1 - IMIRROR(my - sh);
-            } else
-            if (wrap == GL_XFORM_WRAP_MIRROR_CLAMP_TO_EDGE) {
-                const int mx = IMIRROR(sx);
-                const int my = IMIRROR(sy);
-                sx = ICLAMP(mx, 0, swm1);
-                sy = ICLAMP(my, 0, shm1);
-            } else
-            if (wrap == GL_XFORM_WRAP_MIRROR_CLAMP_TO_BORDER) { // This is a (not so wild) guess... :)
-                sx = IMIRROR(sx);
-                sy = IMIRROR(sy);
-                if (sx < 0 || sx > swm1 || sy < 0 || sy > shm1) {
-                    copy = false;
-                }
-//            } else {
-//                copy = false;
-            }
-
-            if (copy) {
-                sx += area.x;
-                sy += area.y;
-
-                const GL_Pixel_t *sptr = sdata + sy * swidth + sx;
-                GL_Pixel_t index = shifting[*sptr];
-#if defined(TOFU_GRAPHICS_XFORM_TRANSPARENCY)
-                if (!transparent[index]) {
-                    *dptr = index;
-                }
-#else
-                // NOTE: no transparency in Mode-7!
-                *dptr = index;
-#endif  /* TOFU_GRAPHICS_XFORM_TRANSPARENCY */
-            }
-
-            ++dptr;
-
-            xp += a;
-            yp += c;
         }
-
-        dptr += dskip;
+#endif
+        span_function(dptr, &span_source, &(const _Span_t){
+                .x = _to_fixed(xp + 0.5),
+                .y = _to_fixed(yp + 0.5),
+                .dx = _to_fixed((double)a),
+                .dy = _to_fixed((double)c),
+                .length = (size_t)width
+            }, state);
+
+        dptr += dwidth;
     }
 }
@@ -41,6 +41,10 @@
 
 #define SL_MIXING_BUFFER_SIZE_IN_FRAMES 128
 
+// Sources are accumulated into a floating-point bus (w/ the same scale of the internal format), that is clamped and
+// converted to the output format only once all of them have been mixed. The bus is processed in chunks of this size.
+#define SL_BUS_SIZE_IN_FRAMES   512
+
 // We are using an unsigned integer to store the group-id. We could technically just use `-1` and cast to unsigned, to
 // model the "any" group... but it just sucks. :P
 #define SL_GROUPS_AMOUNT        256
@@ -49,6 +53,10 @@
 #define SL_DEFAULT_GROUP        SL_FIRST_GROUP
 #define SL_ANY_GROUP            (SL_LAST_GROUP + 1)
 
+// When there are more active sources than voices, the ones w/ the lowest priority (and, on par, the quietest) are
+// virtualized, that is their play-head advances w/o them being mixed.
+#define SL_DEFAULT_PRIORITY     0
+
 typedef struct SL_Callbacks_s {
     size_t (*read)(void *user_data, void *buffer, size_t bytes_to_read);
     bool   (*seek)(void *user_data, long offset, int whence);
@@ -32,18 +32,31 @@
 #include <libs/stb.h>
 
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
 
-SL_Context_t *SL_context_create(void)
+SL_Context_t *SL_context_create(size_t voices, size_t capacity)
 {
     SL_Context_t *context = malloc(sizeof(SL_Context_t));
     if (!context) {
         return NULL;
     }
 
+    if (capacity < voices) {
+        LOG_W("capacity %d is less than the voices, raising it to %d", capacity, voices);
+        capacity = voices;
+    }
+
     *context = (SL_Context_t){
-            .sources = NULL
+            .sources = NULL,
+            .voices = voices,
+            .capacity = capacity
         };
 
+    // The whole capacity is reserved in advance, and never exceeded, so that tracking a source won't ever allocate
+    // on the device thread.
+    arrsetcap(context->sources, capacity);
+
     for (size_t i = 0; i < SL_GROUPS_AMOUNT; ++i) {
         context->groups[i] = (SL_Group_t){
                 .mix = mix_balance(0.0f), // Groups are stereo by definition, so we are balancing as a default.
@@ -51,7 +64,7 @@ SL_Context_t *SL_context_create(void)
             };
     }
 
-    LOG_D("context created");
+    LOG_D("context created w/ %d voices, %d sources capacity", voices, capacity);
     return context;
 }
 
@@ -113,18 +126,55 @@ const SL_Group_t *SL_context_get_group(const SL_Context_t *context, size_t group
     return &context->groups[group_id];
 }
 
-void SL_context_track(SL_Context_t *context, SL_Source_t *source)
+static inline float _loudness(const SL_Source_t *source)
+{
+    const SL_Mix_t mix = source->props->precomputed_mix; // Gains are never negative.
+    return fmaxf(mix.left_to_left + mix.right_to_left, mix.left_to_right + mix.right_to_right);
+}
+
+static inline bool _precedes(const SL_Source_t *a, const SL_Source_t *b)
+{
+    const size_t a_priority = a->props->priority;
+    const size_t b_priority = b->props->priority;
+    return a_priority > b_priority || (a_priority == b_priority && _loudness(a) > _loudness(b));
+}
+
+// When the context is full, the incoming source steals the place of the lowest ranked one, if it ranks higher
+// (ties are resolved in favour of the already tracked). Otherwise, the incoming source is rejected. In both cases, the
+// dropped source is returned to the caller that need to release it.
+SL_Source_t *SL_context_track(SL_Context_t *context, SL_Source_t *source)
 {
     size_t count = arrlenu(context->sources);
     for (size_t i = 0; i < count; ++i) {
         if (context->sources[i] == source) {
             LOG_W("source %p already tracked for context %p", source, context);
-            return;
+            return NULL;
         }
     }
-    arrpush(context->sources, source);
-    LOG_D("source %p tracked for context %p", source, context);
+
     SL_source_on_group_changed(source, SL_ANY_GROUP); // Propagate, to the attached source, to precompute the mix matrix.
+
+    if (count < context->capacity) {
+        arrpush(context->sources, source);
+        LOG_D("source %p tracked for context %p", source, context);
+        return NULL;
+    }
+
+    size_t lowest = 0;
+    for (size_t i = 1; i < count; ++i) {
+        if (_precedes(context->sources[lowest], context->sources[i])) {
+            lowest = i;
+        }
+    }
+
+    SL_Source_t *dropped = context->sources[lowest];
+    if (!_precedes(source, dropped)) {
+        LOG_W("context %p is full, source %p rejected", context, source);
+        return source;
+    }
+    context->sources[lowest] = source;
+    LOG_W("context %p is full, source %p stolen by %p", context, dropped, source);
+    return dropped;
 }
 
 void SL_context_untrack(SL_Context_t *context, SL_Source_t *source)
@@ -158,34 +208,71 @@ size_t SL_context_count_tracked(const SL_Context_t *context)
 
 void SL_context_halt(SL_Context_t *context)
 {
-    arrfree(context->sources);
+    static const size_t zero = 0;
+    arrsetlen(context->sources, zero); // Keep the reserved voices.
 }
 
-// TODO: should we constantly generate into a buffer during the `update()` call and pull data later?
-bool SL_context_update(SL_Context_t *context, float delta_time)
+// Partial selection, only the first `voices` slots are filled w/ the highest ranked sources (in order), the
+// others are left unsorted. The cost is bounded by the voices times the (fixed) capacity. Ties are resolved in favour
+// of the source already in place, so that voices don't swap back and forth when on par.
+static void _rank(SL_Context_t *context)
 {
-    SL_Source_t **current = context->sources;
-    for (size_t count = arrlenu(context->sources); count; --count) {
-        SL_Source_t *source = *(current++);
-        bool result = source->vtable.update(source, delta_time);
-        if (!result) {
-            return false;
+    SL_Source_t **sources = context->sources;
+    size_t count = arrlenu(context->sources);
+    for (size_t i = 0; i < context->voices; ++i) {
+        size_t best = i;
+        for (size_t j = i + 1; j < count; ++j) {
+            if (_precedes(sources[j], sources[best])) {
+                best = j;
+            }
         }
+        SL_Source_t *source = sources[best];
+        sources[best] = sources[i];
+        sources[i] = source;
     }
-    return true;
 }
 
-void SL_context_generate(SL_Context_t *context, void *output, size_t frames_requested)
+// Sources are updated (i.e. their data is produced) by the caller, from a different thread than the generating one.
+// The context only tracks which sources are to be mixed, and reports the ones that reached their end-of-data.
+//
+// The output is generated in chunks, each one accumulated in the bus and then converted at once. The output is
+// entirely overwritten, there's no need for it to be pre-silenced. Only the first (ranked) sources are mixed, up to
+// the amount of voices, the others are virtualized. The cost is bounded regardless of the amount of sources.
+void SL_context_generate(SL_Context_t *context, void *output, size_t frames_requested, SL_Context_Callback_t on_completed, void *user_data)
 {
-    // Backward scan, to properly implement the SWAP-AND-POP(tm) idiom along the whole array
-    // when removing the to-be-released sources.
-    for (int index = arrlen(context->sources) - 1; index >= 0; --index) {
-        SL_Source_t *source = context->sources[index];
-        bool still_running = source->vtable.generate(source, output, frames_requested);
-        if (still_running) {
-            continue;
+    float *bus = context->bus;
+
+    uint8_t *cursor = (uint8_t *)output;
+
+    for (size_t frames_remaining = frames_requested; frames_remaining > 0; ) {
+        size_t frames_to_generate = frames_remaining > SL_BUS_SIZE_IN_FRAMES ? SL_BUS_SIZE_IN_FRAMES : frames_remaining;
+
+        memset(bus, 0, frames_to_generate * SL_CHANNELS_PER_FRAME * sizeof(float));
+
+        const size_t voices = context->voices;
+        if (arrlenu(context->sources) > voices) {
+            _rank(context);
+        }
+
+        // Backward scan, to properly implement the SWAP-AND-POP(tm) idiom along the whole array
+        // when removing the to-be-released sources.
+        for (int index = arrlen(context->sources) - 1; index >= 0; --index) {
+            SL_Source_t *source = context->sources[index];
+            bool still_running = (size_t)index < voices
+                ? source->vtable.generate(source, bus, frames_to_generate)
+                : source->vtable.advance(source, frames_to_generate);
+            if (still_running) {
+                continue;
+            }
+
+            arrdelswap(context->sources, index); // Obliterate the source!
+
+            on_completed(user_data, source);
         }
 
-        arrdelswap(context->sources, index); // Obliterate the source!
+        mix_bus_to_output(cursor, bus, frames_to_generate);
+
+        cursor += frames_to_generate * SL_BYTES_PER_FRAME;
+        frames_remaining -= frames_to_generate;
     }
 }
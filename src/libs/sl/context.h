@@ -31,12 +31,17 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+typedef void (*SL_Context_Callback_t)(void *user_data, SL_Source_t *source);
+
 typedef struct SL_Context_s {
     SL_Group_t groups[SL_GROUPS_AMOUNT];
-    SL_Source_t **sources;
+    SL_Source_t **sources; // Ranked by priority and loudness (when exceeding the voices), the first ones are mixed.
+    size_t voices;
+    size_t capacity; // Sources that can be tracked at once, reserved upfront (never less than the voices).
+    float bus[SL_BUS_SIZE_IN_FRAMES * SL_CHANNELS_PER_FRAME]; // Used by the generating thread only.
 } SL_Context_t;
 
-extern SL_Context_t *SL_context_create(void);
+extern SL_Context_t *SL_context_create(size_t voices, size_t capacity);
 extern void SL_context_destroy(SL_Context_t *context);
 
 extern void SL_context_set_mix(SL_Context_t *context, size_t group_id, SL_Mix_t mix);
@@ -46,13 +51,12 @@ extern void SL_context_set_gain(SL_Context_t *context, size_t group_id, float ga
 
 extern const SL_Group_t *SL_context_get_group(const SL_Context_t *context, size_t group_id);
 
-extern void SL_context_track(SL_Context_t *context, SL_Source_t *source);
+extern SL_Source_t *SL_context_track(SL_Context_t *context, SL_Source_t *source); // Returns the dropped source, if any.
 extern void SL_context_untrack(SL_Context_t *context, SL_Source_t *source);
 extern bool SL_context_is_tracked(const SL_Context_t *context, const SL_Source_t *source);
 extern size_t SL_context_count_tracked(const SL_Context_t *context);
 extern void SL_context_halt(SL_Context_t *context);
 
-extern bool SL_context_update(SL_Context_t *context, float delta_time);
-extern void SL_context_generate(SL_Context_t *context, void *output, size_t frames_requested);
+extern void SL_context_generate(SL_Context_t *context, void *output, size_t frames_requested, SL_Context_Callback_t on_completed, void *user_data);
 
 #endif  /* TOFU_LIBS_SL_CONTEXT_H */
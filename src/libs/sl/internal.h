@@ -44,7 +44,8 @@ typedef struct Source_VTable_s {
     void (*dtor)(SL_Source_t *source);
     bool (*reset)(SL_Source_t *source);
     bool (*update)(SL_Source_t *source, float delta_time);
-    bool (*generate)(SL_Source_t *source, void *output, size_t frames_requested); // Returns `false` when end-of-data.
+    bool (*generate)(SL_Source_t *source, float *bus, size_t frames_requested); // Returns `false` when end-of-data.
+    bool (*advance)(SL_Source_t *source, size_t frames_requested); // Moves the play-head only (i.e. virtualized voice), ditto.
 } Source_VTable_t;
 
 struct SL_Source_s {
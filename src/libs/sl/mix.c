@@ -25,49 +25,36 @@
 #include "mix.h"
 
 #include <core/config.h>
+#include <core/platform.h>
 #include <libs/fmath.h>
 
+#if defined(TOFU_SOUND_VECTORIZED_MIX) && SL_BYTES_PER_SAMPLE == 2
+    #if defined(PLATFORM_SIMD_SSE2)
+        #define _MIX_SSE2
+        #include <emmintrin.h>
+    #elif defined(PLATFORM_SIMD_NEON)
+        #define _MIX_NEON
+        #include <arm_neon.h>
+    #endif
+#endif  /* TOFU_SOUND_VECTORIZED_MIX */
+
 #include <stdint.h>
 
-// Add to the `accumulator` the `sample` scaled by `gain`.
-//
-// Note that, due to scaling, the intermediate `sample * gain` value can exceed the sample maximum/minimum value.
-// We are clamping after the accumulation to save one operation.
+// The sources are accumulated into a floating-point bus, so there's no need to clamp after each source. The bus is
+// clamped (and converted) only once, when all the sources have been mixed. The bus has the same scale of the
+// internal format, so that no scaling is required during the mixing.
 //
-// Also note that we are safe using a `float`, over a (for example) fixed-point 24:8 value. We are not going to
-// loose resolution during the computation.
-#if SL_BYTES_PER_SAMPLE == 2
-static inline int16_t _accumulate_s16(int16_t accumulator, int16_t left_sample, float left_gain, int16_t right_sample, float right_gain)
-{
-    const int32_t result = (int32_t)((float)accumulator + (float)left_sample * left_gain + (float)right_sample * right_gain);
-    if (result >= INT16_MAX) {
-        return INT16_MAX;
-    }
-    if (result <= INT16_MIN) {
-        return INT16_MIN;
-    }
-    return (int16_t)result;
-}
-#elif SL_BYTES_PER_SAMPLE == 4
-static inline float _accumulate_f32(float accumulator, float left_sample, float left_gain, float right_sample, float right_gain)
-{
-    const float result = accumulator + left_sample * left_gain + right_sample * right_gain;
-    if (result >= 1.0f) {
-        return 1.0f;
-    }
-    if (result <= -1.0f) {
-        return -1.0f;
-    }
-    return result;
-}
-#endif
+// Note that we are safe using a `float`, over a (for example) fixed-point 24:8 value. We are not going to loose
+// resolution during the computation.
 
 //
 // | L/L R/L |   | L |
 // |         | * |   | = | L/L * L + R/L * R, L/R * L + R/R * R |
 // | L/R R/R |   | R |
 //
-void mix_2on2_additive(void *output, const void *input, size_t frames, SL_Mix_t mix)
+// The vectorized implementations process the interleaved frames as they are, by multiplying the frames and their
+// channel-swapped copy by the (interleaved) gains, eight frames at a time.
+void mix_2on2_additive(float *bus, const void *input, size_t frames, SL_Mix_t mix)
 {
     const float left_to_left = mix.left_to_left;
     const float left_to_right = mix.left_to_right;
@@ -76,51 +63,157 @@ void mix_2on2_additive(void *output, const void *input, size_t frames, SL_Mix_t
 
 #if SL_BYTES_PER_SAMPLE == 2
     const int16_t *sptr = input;
-    int16_t *dptr = output;
-    for (size_t i = frames; i--; dptr += 2, sptr += 2) {
-        const int16_t left = sptr[0];
-        const int16_t right = sptr[1];
-        dptr[0] = _accumulate_s16(dptr[0], left, left_to_left, right, right_to_left);
-        dptr[1] = _accumulate_s16(dptr[1], left, left_to_right, right, right_to_right);
-    }
 #elif SL_BYTES_PER_SAMPLE == 4
     const float *sptr = input;
-    float *dptr = output;
-    for (size_t i = frames; i--; dptr += 2, sptr += 2) {
-        const float left = sptr[0];
-        const float right = sptr[1];
-        dptr[0] = _accumulate_f32(dptr[0], left, left_to_left, right, right_to_left);
-        dptr[1] = _accumulate_f32(dptr[1], left, left_to_right, right, right_to_right);
-    }
 #else
     #error "Wrong internal format"
 #endif
+    float *dptr = bus;
+
+#if defined(_MIX_SSE2)
+    const __m128 straight = _mm_setr_ps(left_to_left, right_to_right, left_to_left, right_to_right);
+    const __m128 crossed = _mm_setr_ps(right_to_left, left_to_right, right_to_left, left_to_right);
+    for (; frames >= 8; frames -= 8) {
+        const __m128i s0 = _mm_loadu_si128((const __m128i *)sptr);
+        const __m128i s1 = _mm_loadu_si128((const __m128i *)(sptr + 8));
+        const __m128 v[4] = { // Sign-extend the 16-bit samples by shifting them in the upper half.
+                _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s0, s0), 16)),
+                _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s0, s0), 16)),
+                _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s1, s1), 16)),
+                _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s1, s1), 16))
+            };
+        for (size_t i = 0; i < 4; ++i) {
+            const __m128 swapped = _mm_shuffle_ps(v[i], v[i], _MM_SHUFFLE(2, 3, 0, 1));
+            const __m128 d = _mm_loadu_ps(dptr + i * 4);
+            _mm_storeu_ps(dptr + i * 4, _mm_add_ps(d, _mm_add_ps(_mm_mul_ps(v[i], straight), _mm_mul_ps(swapped, crossed))));
+        }
+        sptr += 16;
+        dptr += 16;
+    }
+#elif defined(_MIX_NEON)
+    const float32x4_t straight = vld1q_f32((const float[4]){ left_to_left, right_to_right, left_to_left, right_to_right });
+    const float32x4_t crossed = vld1q_f32((const float[4]){ right_to_left, left_to_right, right_to_left, left_to_right });
+    for (; frames >= 8; frames -= 8) {
+        const int16x8_t s0 = vld1q_s16(sptr);
+        const int16x8_t s1 = vld1q_s16(sptr + 8);
+        const float32x4_t v[4] = {
+                vcvtq_f32_s32(vmovl_s16(vget_low_s16(s0))),
+                vcvtq_f32_s32(vmovl_s16(vget_high_s16(s0))),
+                vcvtq_f32_s32(vmovl_s16(vget_low_s16(s1))),
+                vcvtq_f32_s32(vmovl_s16(vget_high_s16(s1)))
+            };
+        for (size_t i = 0; i < 4; ++i) {
+            const float32x4_t swapped = vrev64q_f32(v[i]);
+            const float32x4_t d = vld1q_f32(dptr + i * 4);
+            vst1q_f32(dptr + i * 4, vaddq_f32(d, vaddq_f32(vmulq_f32(v[i], straight), vmulq_f32(swapped, crossed))));
+        }
+        sptr += 16;
+        dptr += 16;
+    }
+#endif
+    for (; frames; --frames) { // Remaining frames (or all of them, on scalar-only targets).
+        const float left = (float)sptr[0];
+        const float right = (float)sptr[1];
+        dptr[0] += left * left_to_left + right * right_to_left;
+        dptr[1] += right * right_to_right + left * left_to_right;
+        sptr += 2;
+        dptr += 2;
+    }
 }
 
-void mix_1on2_additive(void *output, const void *input, size_t frames, SL_Mix_t mix)
+// Being the source monaural, both the channels are the same and the gains can be summed up in advance.
+void mix_1on2_additive(float *bus, const void *input, size_t frames, SL_Mix_t mix)
 {
-    const float left_to_left = mix.left_to_left;
-    const float left_to_right = mix.left_to_right;
-    const float right_to_left = mix.right_to_left;
-    const float right_to_right = mix.right_to_right;
+    const float left_gain = mix.left_to_left + mix.right_to_left;
+    const float right_gain = mix.right_to_right + mix.left_to_right;
 
 #if SL_BYTES_PER_SAMPLE == 2
     const int16_t *sptr = input;
+#elif SL_BYTES_PER_SAMPLE == 4
+    const float *sptr = input;
+#else
+    #error "Wrong internal format"
+#endif
+    float *dptr = bus;
+
+#if defined(_MIX_SSE2)
+    const __m128 gains = _mm_setr_ps(left_gain, right_gain, left_gain, right_gain);
+    for (; frames >= 8; frames -= 8) {
+        const __m128i s = _mm_loadu_si128((const __m128i *)sptr);
+        const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+        const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+        const __m128 v[4] = { // Duplicate each sample on both the channels.
+                _mm_unpacklo_ps(lo, lo),
+                _mm_unpackhi_ps(lo, lo),
+                _mm_unpacklo_ps(hi, hi),
+                _mm_unpackhi_ps(hi, hi)
+            };
+        for (size_t i = 0; i < 4; ++i) {
+            const __m128 d = _mm_loadu_ps(dptr + i * 4);
+            _mm_storeu_ps(dptr + i * 4, _mm_add_ps(d, _mm_mul_ps(v[i], gains)));
+        }
+        sptr += 8;
+        dptr += 16;
+    }
+#elif defined(_MIX_NEON)
+    const float32x4_t gains = vld1q_f32((const float[4]){ left_gain, right_gain, left_gain, right_gain });
+    for (; frames >= 8; frames -= 8) {
+        const int16x8_t s = vld1q_s16(sptr);
+        const float32x4x2_t lo = vzipq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))));
+        const float32x4x2_t hi = vzipq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))));
+        const float32x4_t v[4] = { lo.val[0], lo.val[1], hi.val[0], hi.val[1] };
+        for (size_t i = 0; i < 4; ++i) {
+            const float32x4_t d = vld1q_f32(dptr + i * 4);
+            vst1q_f32(dptr + i * 4, vaddq_f32(d, vmulq_f32(v[i], gains)));
+        }
+        sptr += 8;
+        dptr += 16;
+    }
+#endif
+    for (; frames; --frames) { // Ditto.
+        const float sample = (float)sptr[0];
+        dptr[0] += sample * left_gain;
+        dptr[1] += sample * right_gain;
+        sptr += 1;
+        dptr += 2;
+    }
+}
+
+// The vectorized implementations rely on the saturating narrowing instructions to clamp the values. As for the
+// scalar one, the values are truncated (not rounded).
+void mix_bus_to_output(void *output, const float *bus, size_t frames)
+{
+    const float *sptr = bus;
+    size_t samples = frames * SL_CHANNELS_PER_FRAME;
+
+#if SL_BYTES_PER_SAMPLE == 2
     int16_t *dptr = output;
-    for (size_t i = frames; i--; dptr += 2, sptr += 1) {
-        const int16_t left = sptr[0];
-        const int16_t right = sptr[0];
-        dptr[0] = _accumulate_s16(dptr[0], left, left_to_left, right, right_to_left);
-        dptr[1] = _accumulate_s16(dptr[1], left, left_to_right, right, right_to_right);
+#if defined(_MIX_SSE2)
+    for (; samples >= 8; samples -= 8) {
+        const __m128i lo = _mm_cvttps_epi32(_mm_loadu_ps(sptr));
+        const __m128i hi = _mm_cvttps_epi32(_mm_loadu_ps(sptr + 4));
+        _mm_storeu_si128((__m128i *)dptr, _mm_packs_epi32(lo, hi));
+        sptr += 8;
+        dptr += 8;
+    }
+#elif defined(_MIX_NEON)
+    for (; samples >= 8; samples -= 8) {
+        const int16x4_t lo = vqmovn_s32(vcvtq_s32_f32(vld1q_f32(sptr)));
+        const int16x4_t hi = vqmovn_s32(vcvtq_s32_f32(vld1q_f32(sptr + 4)));
+        vst1q_s16(dptr, vcombine_s16(lo, hi));
+        sptr += 8;
+        dptr += 8;
+    }
+#endif
+    for (; samples; --samples) {
+        const float value = *(sptr++);
+        *(dptr++) = value >= (float)INT16_MAX ? INT16_MAX : value <= (float)INT16_MIN ? INT16_MIN : (int16_t)value;
     }
 #elif SL_BYTES_PER_SAMPLE == 4
-    const float *sptr = input;
     float *dptr = output;
-    for (size_t i = frames; i--; dptr += 2, sptr += 1) {
-        const float left = sptr[0];
-        const float right = sptr[0];
-        dptr[0] = _accumulate_f32(dptr[0], left, left_to_left, right, right_to_left);
-        dptr[1] = _accumulate_f32(dptr[1], left, left_to_right, right, right_to_right);
+    for (; samples; --samples) {
+        const float value = *(sptr++);
+        *(dptr++) = value >= 1.0f ? 1.0f : value <= -1.0f ? -1.0f : value;
     }
 #else
     #error "Wrong internal format"
@@ -33,7 +33,8 @@ extern SL_Mix_t mix_twin_pan(float left_pan, float right_pan);
 extern SL_Mix_t mix_pan(float pan);
 extern SL_Mix_t mix_balance(float balance);
 
-extern void mix_2on2_additive(void *output, const void *input, size_t frames, SL_Mix_t mix);
-extern void mix_1on2_additive(void *output, const void *input, size_t frames, SL_Mix_t mix);
+extern void mix_2on2_additive(float *bus, const void *input, size_t frames, SL_Mix_t mix);
+extern void mix_1on2_additive(float *bus, const void *input, size_t frames, SL_Mix_t mix);
+extern void mix_bus_to_output(void *output, const float *bus, size_t frames); // Clamps and converts to the internal format.
 
 #endif  /* TOFU_LIBS_SL_MIX_H */
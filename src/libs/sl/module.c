@@ -36,13 +36,16 @@
 
 #include <stdint.h>
 
-// We are going to buffer 1 second of non-converted data. As long as the `SL_music_update()` function is called
-// once half a second we are good. Since it's very unlikely we will run at less than 2 FPS... well, we can sleep well. :)
+// We are going to buffer 1 second of non-converted data. The buffer is refilled by the audio decoder thread, which
+// runs at a much higher pace than the game loop and independently of it.
 #define _STREAMING_BUFFER_SIZE_IN_FRAMES   SL_FRAMES_PER_SECOND
 
 // That's the size of a single chunk read in each `produce()` call. Can't be larger than the buffer size.
 #define _STREAMING_BUFFER_CHUNK_IN_FRAMES  (_STREAMING_BUFFER_SIZE_IN_FRAMES / 4)
 
+// The decoder thread keeps the buffer filled at least up to this level, producing as many chunks as required.
+#define _STREAMING_BUFFER_WATERMARK_IN_FRAMES ((_STREAMING_BUFFER_SIZE_IN_FRAMES * 3) / 4)
+
 // Modules are generated in stereo mode, which means that we need to handle a stereo source (i.e. we have two channels per frame)
 #define _MODULE_OUTPUT_FORMAT              ma_format_s16
 #define _MODULE_OUTPUT_BYTES_PER_SAMPLE    2
@@ -66,14 +69,15 @@ typedef struct Module_s {
     xmp_context context;
 
     ma_pcm_rb buffer;
-    bool completed;
+    bool completed; // Set (atomically) by the decoder thread once the last frames are in the buffer.
 } Module_t;
 
 static bool _module_ctor(SL_Source_t *source, const SL_Context_t *context, SL_Callbacks_t callbacks);
 static void _module_dtor(SL_Source_t *source);
 static bool _module_reset(SL_Source_t *source);
 static bool _module_update(SL_Source_t *source, float delta_time);
-static bool _module_generate(SL_Source_t *source, void *output, size_t frames_requested);
+static bool _module_generate(SL_Source_t *source, float *bus, size_t frames_requested);
+static bool _module_advance(SL_Source_t *source, size_t frames_requested);
 
 static inline bool _rewind(Module_t *module)
 {
@@ -81,7 +85,7 @@ static inline bool _rewind(Module_t *module)
 
     xmp_restart_module(module->context);
 
-    module->completed = false;
+    __atomic_store_n(&module->completed, false, __ATOMIC_RELEASE);
 
     return true;
 }
@@ -98,7 +102,7 @@ static inline bool _reset(Module_t *module)
 
 static inline bool _produce(Module_t *module)
 {
-    if (module->completed) { // End-of-data, early exit.
+    if (__atomic_load_n(&module->completed, __ATOMIC_RELAXED)) { // End-of-data, early exit (only we set it).
         return true;
     }
 
@@ -128,7 +132,7 @@ static inline bool _produce(Module_t *module)
 
     if (play_result == -XMP_END) {
         LOG_D("module %p reached end, marking as completed", module);
-        module->completed = true;
+        __atomic_store_n(&module->completed, true, __ATOMIC_RELEASE); // Published after the frames, see `_module_generate()`.
     } else
     if (play_result != 0) { // Mark the end-of-data for both "end" and "error state" cases.
         LOG_E("module %p in error state %d, forcing end-of-data", module, play_result);
@@ -190,7 +194,8 @@ static bool _module_ctor(SL_Source_t *source, const SL_Context_t *context, SL_Ca
                 .dtor = _module_dtor,
                 .reset = _module_reset,
                 .update = _module_update,
-                .generate = _module_generate
+                .generate = _module_generate,
+                .advance = _module_advance
             },
             .completed = false
         };
@@ -272,14 +277,28 @@ static bool _module_reset(SL_Source_t *source)
     return true;
 }
 
+// Called by the decoder thread, tops the buffer up to the watermark so that it can survive longer stalls.
 static bool _module_update(SL_Source_t *source, float delta_time)
 {
     Module_t *module = (Module_t *)source;
 
-    return _produce(module);
+    ma_pcm_rb *buffer = &module->buffer;
+    for (ma_uint32 frames_available = ma_pcm_rb_available_read(buffer); frames_available < _STREAMING_BUFFER_WATERMARK_IN_FRAMES; ) {
+        if (!_produce(module)) {
+            return false;
+        }
+
+        ma_uint32 frames_buffered = ma_pcm_rb_available_read(buffer);
+        if (frames_buffered <= frames_available) { // Nothing produced (i.e. end-of-data), we are done for now.
+            break;
+        }
+        frames_available = frames_buffered;
+    }
+
+    return true;
 }
 
-static bool _module_generate(SL_Source_t *source, void *output, size_t frames_requested)
+static bool _module_generate(SL_Source_t *source, float *bus, size_t frames_requested)
 {
     Module_t *module = (Module_t *)source;
 
@@ -290,13 +309,16 @@ static bool _module_generate(SL_Source_t *source, void *output, size_t frames_re
 
     const SL_Mix_t mix = module->props->precomputed_mix;
 
-    uint8_t *cursor = (uint8_t *)output;
+    float *cursor = bus;
 
     size_t frames_remaining = frames_requested;
     while (frames_remaining > 0) {
+        // The flag is loaded before checking the buffer, when set the last frames are already there.
+        const bool completed = __atomic_load_n(&module->completed, __ATOMIC_ACQUIRE);
         ma_uint32 frames_available = ma_pcm_rb_available_read(buffer);
         if (frames_available == 0) {
-            if (!module->completed) {
+            if (!completed) {
+                module->props->underruns += 1;
                 LOG_W("buffer underrun for source %p - stalling (waiting for data)", source);
                 return true;
             } else {
@@ -327,9 +349,38 @@ static bool _module_generate(SL_Source_t *source, void *output, size_t frames_re
 #else
     #error "Mixing buffer has wrong number of channels"
 #endif
-        cursor += frames_generated * SL_BYTES_PER_FRAME;
+        cursor += frames_generated * SL_CHANNELS_PER_FRAME;
         frames_remaining -= frames_generated;
     }
 
     return true;
 }
+
+// The buffered frames are dropped w/o being converted and mixed, so that the decoder keeps producing them.
+static bool _module_advance(SL_Source_t *source, size_t frames_requested)
+{
+    Module_t *module = (Module_t *)source;
+
+    ma_data_converter *converter = &module->props->converter;
+    ma_pcm_rb *buffer = &module->buffer;
+
+    const bool completed = __atomic_load_n(&module->completed, __ATOMIC_ACQUIRE); // See `_module_generate()`.
+    ma_uint32 frames_available = ma_pcm_rb_available_read(buffer);
+    if (frames_available == 0) {
+        if (!completed) {
+            module->props->underruns += 1;
+            LOG_W("buffer underrun for (virtual) source %p - stalling (waiting for data)", source);
+            return true;
+        } else {
+            LOG_D("end-of-data reached for (virtual) source %p", source);
+            return false;
+        }
+    }
+
+    ma_uint64 frames_to_skip;
+    ma_data_converter_get_required_input_frame_count(converter, frames_requested, &frames_to_skip);
+
+    ma_pcm_rb_seek_read(buffer, frames_to_skip > frames_available ? frames_available : (ma_uint32)frames_to_skip);
+
+    return true;
+}
@@ -35,14 +35,18 @@
 
 #include <stdint.h>
 
-// We are going to buffer 1 second of non-converted data. As long as the `SL_music_update()` function is called
-// once half a second we are good. Since it's very unlikely we will run at less than 2 FPS... well, we can sleep well. :)
+// We are going to buffer 1 second of non-converted data. The buffer is refilled by the audio decoder thread, which
+// runs at a much higher pace than the game loop and independently of it. Even if the decoder thread is stalled
+// there's room for about half a second of data. :)
 // FIXME: greater value to reduce the I/O? Guess this would be required...
 #define _STREAMING_BUFFER_SIZE_IN_FRAMES   SL_FRAMES_PER_SECOND
 
 // That's the size of a single chunk read in each `produce()` call. Can't be larger than the buffer size.
 #define _STREAMING_BUFFER_CHUNK_IN_FRAMES  (_STREAMING_BUFFER_SIZE_IN_FRAMES / 4)
 
+// The decoder thread keeps the buffer filled at least up to this level, producing as many chunks as required.
+#define _STREAMING_BUFFER_WATERMARK_IN_FRAMES ((_STREAMING_BUFFER_SIZE_IN_FRAMES * 3) / 4)
+
 #define _MIXING_BUFFER_BYTES_PER_SAMPLE    SL_BYTES_PER_SAMPLE
 #define _MIXING_BUFFER_SAMPLES_PER_CHANNEL SL_SAMPLES_PER_CHANNEL
 #define _MIXING_BUFFER_CHANNELS_PER_FRAME  SL_CHANNELS_PER_FRAME
@@ -63,13 +67,15 @@ typedef struct Music_s { // FIXME: rename to `_Music_Source_s`.
 
     ma_pcm_rb buffer;
     size_t frames_completed;
+    bool end_of_data; // Set (atomically) by the decoder thread once the last frames are in the buffer.
 } Music_t;
 
 static bool _music_ctor(SL_Source_t *source, const SL_Context_t *context, SL_Callbacks_t callbacks);
 static void _music_dtor(SL_Source_t *source);
 static bool _music_reset(SL_Source_t *source);
 static bool _music_update(SL_Source_t *source, float delta_time);
-static bool _music_generate(SL_Source_t *source, void *output, size_t frames_requested);
+static bool _music_generate(SL_Source_t *source, float *bus, size_t frames_requested);
+static bool _music_advance(SL_Source_t *source, size_t frames_requested);
 
 static inline bool _rewind(Music_t *music)
 {
@@ -82,6 +88,7 @@ static inline bool _rewind(Music_t *music)
     }
 
     music->frames_completed = 0;
+    __atomic_store_n(&music->end_of_data, false, __ATOMIC_RELEASE);
 
     return true;
 }
@@ -99,8 +106,10 @@ static inline bool _reset(Music_t *music)
 static inline bool _produce(Music_t *music)
 {
     if (music->frames_completed == music->length_in_frames) { // End-of-data, early exit.
-        if (!music->props->looped || !_rewind(music)) {
-            LOG_D("end-of-data, early exit music %p", music);
+        if (!music->props->looped) {
+            return true; // Nothing more to produce, the source will be completed once the buffer is drained.
+        }
+        if (!_rewind(music)) {
             return false;
         }
     }
@@ -129,6 +138,9 @@ static inline bool _produce(Music_t *music)
     ma_pcm_rb_commit_write(buffer, frames_produced);
 
     music->frames_completed += frames_produced;
+    if (music->frames_completed == music->length_in_frames) { // Published after the frames, see `_music_generate()`.
+        __atomic_store_n(&music->end_of_data, true, __ATOMIC_RELEASE);
+    }
 
     if (frames_produced < frames_to_produce && music->frames_completed < music->length_in_frames) { // Check if an error occurred (no more data w/ no EOF)
         LOG_E("can't read %d bytes (%d read)", frames_to_produce, frames_produced);
@@ -192,10 +204,12 @@ static bool _music_ctor(SL_Source_t *source, const SL_Context_t *context, SL_Cal
                 .dtor = _music_dtor,
                 .reset = _music_reset,
                 .update = _music_update,
-                .generate = _music_generate
+                .generate = _music_generate,
+                .advance = _music_advance
             },
             .callbacks = callbacks,
-            .frames_completed = 0
+            .frames_completed = 0,
+            .end_of_data = false
         };
 
     music->decoder = drflac_open(_music_read, _music_seek, music, NULL);
@@ -279,14 +293,28 @@ static bool _music_reset(SL_Source_t *source)
     return true;
 }
 
+// Called by the decoder thread, tops the buffer up to the watermark so that it can survive longer stalls.
 static bool _music_update(SL_Source_t *source, float delta_time)
 {
     Music_t *music = (Music_t *)source;
 
-    return _produce(music);
+    ma_pcm_rb *buffer = &music->buffer;
+    for (ma_uint32 frames_available = ma_pcm_rb_available_read(buffer); frames_available < _STREAMING_BUFFER_WATERMARK_IN_FRAMES; ) {
+        if (!_produce(music)) {
+            return false;
+        }
+
+        ma_uint32 frames_buffered = ma_pcm_rb_available_read(buffer);
+        if (frames_buffered <= frames_available) { // Nothing produced (i.e. end-of-data), we are done for now.
+            break;
+        }
+        frames_available = frames_buffered;
+    }
+
+    return true;
 }
 
-static bool _music_generate(SL_Source_t *source, void *output, size_t frames_requested)
+static bool _music_generate(SL_Source_t *source, float *bus, size_t frames_requested)
 {
     Music_t *music = (Music_t *)source;
 
@@ -297,13 +325,16 @@ static bool _music_generate(SL_Source_t *source, void *output, size_t frames_req
 
     const SL_Mix_t mix = music->props->precomputed_mix;
 
-    uint8_t *cursor = (uint8_t *)output;
+    float *cursor = bus;
 
     size_t frames_remaining = frames_requested;
     while (frames_remaining > 0) {
+        // The flag is loaded before checking the buffer, when set the last frames are already there.
+        const bool end_of_data = __atomic_load_n(&music->end_of_data, __ATOMIC_ACQUIRE);
         ma_uint32 frames_available = ma_pcm_rb_available_read(buffer);
         if (frames_available == 0) {
-            if (music->frames_completed < music->length_in_frames) {
+            if (!end_of_data) {
+                music->props->underruns += 1;
                 LOG_W("buffer underrun for source %p - stalling (waiting for data)", source);
                 return true;
             } else {
@@ -334,9 +365,38 @@ static bool _music_generate(SL_Source_t *source, void *output, size_t frames_req
 #else
     #error "Mixing buffer has wrong number of channels"
 #endif
-        cursor += frames_generated * SL_BYTES_PER_FRAME;
+        cursor += frames_generated * SL_CHANNELS_PER_FRAME;
         frames_remaining -= frames_generated;
     }
 
     return true;
 }
+
+// The buffered frames are dropped w/o being converted and mixed, so that the decoder keeps producing them.
+static bool _music_advance(SL_Source_t *source, size_t frames_requested)
+{
+    Music_t *music = (Music_t *)source;
+
+    ma_data_converter *converter = &music->props->converter;
+    ma_pcm_rb *buffer = &music->buffer;
+
+    const bool end_of_data = __atomic_load_n(&music->end_of_data, __ATOMIC_ACQUIRE); // See `_music_generate()`.
+    ma_uint32 frames_available = ma_pcm_rb_available_read(buffer);
+    if (frames_available == 0) {
+        if (!end_of_data) {
+            music->props->underruns += 1;
+            LOG_W("buffer underrun for (virtual) source %p - stalling (waiting for data)", source);
+            return true;
+        } else {
+            LOG_D("end-of-data reached for (virtual) source %p", source);
+            return false;
+        }
+    }
+
+    ma_uint64 frames_to_skip;
+    ma_data_converter_get_required_input_frame_count(converter, frames_requested, &frames_to_skip);
+
+    ma_pcm_rb_seek_read(buffer, frames_to_skip > frames_available ? frames_available : (ma_uint32)frames_to_skip);
+
+    return true;
+}
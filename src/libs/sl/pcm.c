@@ -0,0 +1,181 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2024 Marco Lizza
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "pcm.h"
+
+#include "internal.h"
+
+#include <core/config.h>
+#include <libs/dr_libs.h>
+#define _LOG_TAG "sl-pcm"
+#include <libs/log.h>
+#include <libs/stb.h>
+
+// When defined this macro will pose a limit in maximum the length of a sample, as it is unpractical to have
+// too-long samples. However, we could also don't limit it and just leave it to the user.
+#define _PCM_MAX_LENGTH_IN_SECONDS 10.0f
+
+#define _PCM_BYTES_PER_FRAME       (SL_SAMPLES_PER_CHANNEL * SL_BYTES_PER_SAMPLE) // Monaural data.
+
+static size_t _pcm_read(void *user_data, void *buffer, size_t bytes_to_read)
+{
+    const SL_Callbacks_t *callbacks = (const SL_Callbacks_t *)user_data;
+
+    return callbacks->read(callbacks->user_data, buffer, bytes_to_read);
+}
+
+static drflac_bool32 _pcm_seek(void *user_data, int offset, drflac_seek_origin origin)
+{
+    const SL_Callbacks_t *callbacks = (const SL_Callbacks_t *)user_data;
+
+    bool sought = false;
+    if (origin == drflac_seek_origin_start) {
+        sought = callbacks->seek(callbacks->user_data, offset, SEEK_SET);
+    } else
+    if (origin == drflac_seek_origin_current) {
+        sought = callbacks->seek(callbacks->user_data, offset, SEEK_CUR);
+    }
+    return sought ? DRFLAC_TRUE : DRFLAC_FALSE;
+}
+
+static void *_malloc(size_t sz, void *pUserData) // FIXME: move to custom library.
+{
+    return malloc(sz);
+}
+
+static void *_realloc(void *ptr, size_t sz, void *pUserData)
+{
+    return realloc(ptr, sz);
+}
+
+static void  _free(void *ptr, void *pUserData)
+{
+    free(ptr);
+}
+
+// The decoder is needed only during the creation, as the whole data is decoded at once.
+SL_Pcm_t *SL_pcm_decode(SL_Callbacks_t callbacks)
+{
+    drflac *decoder = drflac_open(_pcm_read, _pcm_seek, &callbacks, &(drflac_allocation_callbacks){
+            .pUserData = NULL,
+            .onMalloc  = _malloc,
+            .onRealloc = _realloc,
+            .onFree    = _free
+        });
+    if (!decoder) {
+        LOG_E("can't create PCM decoder");
+        goto error_exit;
+    }
+
+    size_t length_in_frames = decoder->totalPCMFrameCount;
+    if (length_in_frames == 0) {
+        LOG_E("can't decode PCM data w/ zero length");
+        goto error_close_decoder;
+    }
+
+    size_t channels = decoder->channels;
+    size_t sample_rate = decoder->sampleRate;
+    size_t bits_per_sample = decoder->bitsPerSample;
+    LOG_D("PCM decoder %p initialized w/ %d frames, %d channels, %dHz, %d bits", decoder, length_in_frames, channels, sample_rate, bits_per_sample);
+
+    if (channels != 1) {
+        LOG_E("samples need to be monaural (i.e. w/ 1 channel)");
+        goto error_close_decoder;
+    }
+
+#if defined(_PCM_MAX_LENGTH_IN_SECONDS)
+    float duration = (float)length_in_frames / (float)sample_rate;
+    if (duration > _PCM_MAX_LENGTH_IN_SECONDS) {
+        LOG_E("sample is too long (%.2f seconds)", duration);
+        goto error_close_decoder;
+    }
+#endif
+
+    SL_Pcm_t *pcm = malloc(sizeof(SL_Pcm_t));
+    if (!pcm) {
+        LOG_E("can't allocate PCM structure");
+        goto error_close_decoder;
+    }
+
+    *pcm = (SL_Pcm_t){
+            .frames = malloc(length_in_frames * _PCM_BYTES_PER_FRAME),
+            .length_in_frames = length_in_frames,
+            .sample_rate = sample_rate,
+            .references = 1
+        };
+    if (!pcm->frames) {
+        LOG_E("can't allocate buffer for %d frames", length_in_frames);
+        goto error_free_pcm;
+    }
+
+#if SL_BYTES_PER_SAMPLE == 2
+    size_t frames_produced = drflac_read_pcm_frames_s16(decoder, length_in_frames, pcm->frames);
+#elif SL_BYTES_PER_SAMPLE == 4
+    size_t frames_produced = drflac_read_pcm_frames_f32(decoder, length_in_frames, pcm->frames);
+#endif
+    if (frames_produced != length_in_frames) {
+        LOG_E("can't read %d frames for sample", length_in_frames);
+        goto error_free_frames;
+    }
+
+    drflac_close(decoder);
+    LOG_D("PCM decoder closed");
+
+    LOG_D("PCM %p decoded w/ %d frames", pcm, length_in_frames);
+    return pcm;
+
+error_free_frames:
+    free(pcm->frames);
+error_free_pcm:
+    free(pcm);
+error_close_decoder:
+    drflac_close(decoder);
+error_exit:
+    return NULL;
+}
+
+SL_Pcm_t *SL_pcm_acquire(SL_Pcm_t *pcm)
+{
+    pcm->references += 1;
+    LOG_T("PCM %p acquired, %d references", pcm, pcm->references);
+    return pcm;
+}
+
+void SL_pcm_release(SL_Pcm_t *pcm)
+{
+    pcm->references -= 1;
+    LOG_T("PCM %p released, %d references", pcm, pcm->references);
+    if (pcm->references > 0) {
+        return;
+    }
+
+    LOG_D("PCM %p no longer referenced, freeing", pcm);
+
+    free(pcm->frames);
+    LOG_D("PCM frames freed");
+
+    free(pcm);
+    LOG_D("PCM freed");
+}
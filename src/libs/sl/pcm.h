@@ -0,0 +1,48 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2024 Marco Lizza
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef TOFU_LIBS_SL_PCM_H
+#define TOFU_LIBS_SL_PCM_H
+
+#include "common.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Immutable decoded (monaural) frames, in the internal format. They are shared among the samples created from the
+// same data, which are just play-heads over them. References are counted on the game thread only, while the device
+// thread just reads the frames (which are never modified once decoded).
+typedef struct SL_Pcm_s {
+    void *frames;
+    size_t length_in_frames;
+    size_t sample_rate;
+    size_t references;
+} SL_Pcm_t;
+
+extern SL_Pcm_t *SL_pcm_decode(SL_Callbacks_t callbacks); // Created w/ a single reference.
+extern SL_Pcm_t *SL_pcm_acquire(SL_Pcm_t *pcm);
+extern void SL_pcm_release(SL_Pcm_t *pcm); // Destroyed when no longer referenced.
+
+#endif  /* TOFU_LIBS_SL_PCM_H */
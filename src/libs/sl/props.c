@@ -75,7 +75,8 @@ SL_Props_t *SL_props_create(const SL_Context_t *context, ma_format format, ma_ui
             .looped = false,
             .mix = channels_in == 1 ? mix_pan(0.0f) : mix_balance(0.0f), // mono -> center panned, stereo -> separated
             .gain = 1.0f,
-            .speed = 1.0f
+            .speed = 1.0f,
+            .priority = SL_DEFAULT_PRIORITY
         };
 
     ma_data_converter_config config = ma_data_converter_config_init(format, INTERNAL_FORMAT, channels_in, channels_out, sample_rate, SL_FRAMES_PER_SECOND);
@@ -113,6 +114,22 @@ void SL_props_destroy(SL_Props_t *props)
     LOG_D("properties freed");
 }
 
+// Restores the defaults, as if the properties were just created, w/o reallocating the converter (the channels are
+// unchanged, so only the rate needs to be updated).
+void SL_props_reset(SL_Props_t *props, ma_uint32 sample_rate)
+{
+    props->group_id = SL_DEFAULT_GROUP;
+    props->looped = false;
+    props->mix = props->channels == 1 ? mix_pan(0.0f) : mix_balance(0.0f);
+    props->gain = 1.0f;
+    props->speed = 1.0f;
+    props->priority = SL_DEFAULT_PRIORITY;
+    props->underruns = 0;
+
+    ma_data_converter_set_rate(&props->converter, sample_rate, SL_FRAMES_PER_SECOND);
+    ma_data_converter_reset(&props->converter);
+}
+
 void SL_props_set_group(SL_Props_t *props, size_t group_id)
 {
     props->group_id = group_id;
@@ -193,6 +210,11 @@ void SL_props_set_speed(SL_Props_t *props, float speed)
     ma_data_converter_set_rate_ratio(&props->converter, props->speed); // The ratio is `in` over `out`, i.e. actual speed-up factor.
 }
 
+void SL_props_set_priority(SL_Props_t *props, size_t priority)
+{
+    props->priority = priority;
+}
+
 void SL_props_on_group_changed(SL_Props_t *props, size_t group_id)
 {
     if (props->group_id != group_id && group_id != SL_ANY_GROUP) {
@@ -42,16 +42,20 @@ typedef struct SL_Props_s {
     SL_Mix_t mix;
     float gain;
     float speed;
+    size_t priority;
 
     // TODO: Add M/S processing: https://github.com/dfilaretti/stereowidth-demo
     // TODO: Add reverb: https://medium.com/the-seekers-project/coding-a-basic-reverb-algorithm-an-introduction-to-audio-programming-d5d90ad58bde
     //                   https://github.com/fabiensanglard/chocolate_duke3D/blob/master/Game/src/audiolib/mvreverb.c
     ma_data_converter converter;
     SL_Mix_t precomputed_mix;
+
+    size_t underruns; // Times the source had no data to be mixed (written by the device thread only).
 } SL_Props_t;
 
 extern SL_Props_t *SL_props_create(const SL_Context_t *context, ma_format format, ma_uint32 sample_rate, ma_uint32 channels_in, ma_uint32 channels_out);
 extern void SL_props_destroy(SL_Props_t *props);
+extern void SL_props_reset(SL_Props_t *props, ma_uint32 sample_rate);
 
 extern void SL_props_set_group(SL_Props_t *props, size_t group_id);
 extern void SL_props_set_looped(SL_Props_t *props, bool looped);
@@ -61,6 +65,7 @@ extern void SL_props_set_twin_pan(SL_Props_t *props, float left_pan, float right
 extern void SL_props_set_balance(SL_Props_t *props, float pan);
 extern void SL_props_set_gain(SL_Props_t *props, float gain);
 extern void SL_props_set_speed(SL_Props_t *props, float speed);
+extern void SL_props_set_priority(SL_Props_t *props, size_t priority);
 
 extern void SL_props_on_group_changed(SL_Props_t *props, size_t group_id);
 
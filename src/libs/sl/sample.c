@@ -35,10 +35,6 @@
 
 #include <stdint.h>
 
-// When defined this macro will pose a limit in maximum the length of a sample, as it is unpractical to have
-// too-long samples. However, we could also don't limit it and just leave it to the user.
-#define _SAMPLE_MAX_LENGTH_IN_SECONDS      10.0f
-
 // Samples differs from musics and modules since they are *mono* in nature. We have just *one* channel per frame.
 // This means that we will be using the `mix_1on2_additive()` mixing function to duplicate the mono channel to stereo.
 #define _MIXING_BUFFER_BYTES_PER_SAMPLE    SL_BYTES_PER_SAMPLE
@@ -49,35 +45,30 @@
 #define _MIXING_BUFFER_BYTES_PER_FRAME     (_MIXING_BUFFER_CHANNELS_PER_FRAME * _MIXING_BUFFER_SAMPLES_PER_CHANNEL * _MIXING_BUFFER_BYTES_PER_SAMPLE)
 #define _MIXING_BUFFER_SIZE_IN_BYTES       (_MIXING_BUFFER_SIZE_IN_FRAMES * _MIXING_BUFFER_BYTES_PER_FRAME)
 
+// A sample is just a play-head over the (shared) decoded frames, which are never modified.
 typedef struct Sample_s {
     Source_VTable_t vtable;
 
     SL_Props_t *props;
 
-    SL_Callbacks_t callbacks;
-
-    drflac *decoder;
-    size_t length_in_frames;
+    SL_Pcm_t *pcm;
 
     uint8_t mixing_buffer[_MIXING_BUFFER_SIZE_IN_BYTES];
 
-    ma_audio_buffer buffer;
     size_t frames_completed;
 } Sample_t;
 
-static bool _sample_ctor(SL_Source_t *source, const SL_Context_t *context, SL_Callbacks_t callbacks);
+static bool _sample_ctor(SL_Source_t *source, const SL_Context_t *context, SL_Pcm_t *pcm);
 static void _sample_dtor(SL_Source_t *source);
 static bool _sample_reset(SL_Source_t *source);
 static bool _sample_update(SL_Source_t *source, float delta_time);
-static bool _sample_generate(SL_Source_t *source, void *output, size_t frames_requested);
+static bool _sample_generate(SL_Source_t *source, float *bus, size_t frames_requested);
+static bool _sample_advance(SL_Source_t *source, size_t frames_requested);
 
 static inline bool _rewind(Sample_t *sample)
 {
     LOG_T("rewinding sample %p", sample);
 
-    ma_audio_buffer *buffer = &sample->buffer;
-    ma_audio_buffer_seek_to_pcm_frame(buffer, 0); // Can't fail, we are rewinding into memory (frame-seeking is safe).
-
     sample->frames_completed = 0;
 
     return true;
@@ -90,28 +81,7 @@ static inline bool _reset(Sample_t *sample)
     return _rewind(sample);
 }
 
-static inline bool _produce(Sample_t *sample)
-{
-    ma_audio_buffer *buffer = &sample->buffer;
-
-    void *write_buffer;
-    ma_uint64 frames_available = sample->length_in_frames;
-    ma_audio_buffer_map(buffer, &write_buffer, &frames_available); // No need to check the result, can't fail.
-
-#if SL_BYTES_PER_SAMPLE == 2
-    size_t frames_produced = drflac_read_pcm_frames_s16(sample->decoder, frames_available, write_buffer);
-#elif SL_BYTES_PER_SAMPLE == 4
-    size_t frames_produced = drflac_read_pcm_frames_f32(sample->decoder, frames_available, write_buffer);
-#endif
-
-    ma_audio_buffer_unmap(buffer, frames_produced); // Ditto.
-
-    ma_audio_buffer_seek_to_pcm_frame(buffer, 0); // Ditto.
-
-    return frames_produced == sample->length_in_frames;
-}
-
-SL_Source_t *SL_sample_create(const SL_Context_t *context, SL_Callbacks_t callbacks)
+SL_Source_t *SL_sample_create(const SL_Context_t *context, SL_Pcm_t *pcm)
 {
     SL_Source_t *sample = malloc(sizeof(Sample_t));
     if (!sample) {
@@ -119,7 +89,7 @@ SL_Source_t *SL_sample_create(const SL_Context_t *context, SL_Callbacks_t callba
         goto error_exit;
     }
 
-    bool cted = _sample_ctor(sample, context, callbacks);
+    bool cted = _sample_ctor(sample, context, pcm);
     if (!cted) {
         goto error_free_sample;
     }
@@ -133,45 +103,42 @@ error_exit:
     return NULL;
 }
 
-static size_t _sample_read(void *user_data, void *buffer, size_t bytes_to_read)
+bool SL_source_is_sample(const SL_Source_t *source)
 {
-    const Sample_t *sample = (const Sample_t *)user_data;
-    const SL_Callbacks_t *callbacks = &sample->callbacks;
-
-    return callbacks->read(callbacks->user_data, buffer, bytes_to_read);
+    return source->vtable.dtor == _sample_dtor;
 }
 
-static drflac_bool32 _sample_seek(void *user_data, int offset, drflac_seek_origin origin)
+// Binding a sample to the data is the same as creating it anew, but w/o (re)allocating anything. The sample must
+// not be referenced by a context while doing it.
+void SL_sample_bind(SL_Source_t *source, SL_Pcm_t *pcm)
 {
-    const Sample_t *sample = (const Sample_t *)user_data;
-    const SL_Callbacks_t *callbacks = &sample->callbacks;
-
-    bool sought = false;
-    if (origin == drflac_seek_origin_start) {
-        sought = callbacks->seek(callbacks->user_data, offset, SEEK_SET);
-    } else
-    if (origin == drflac_seek_origin_current) {
-        sought = callbacks->seek(callbacks->user_data, offset, SEEK_CUR);
+    Sample_t *sample = (Sample_t *)source;
+
+    SL_Pcm_t *previous = sample->pcm;
+    sample->pcm = SL_pcm_acquire(pcm); // Acquire first, the data could be the same.
+    if (previous) {
+        SL_pcm_release(previous);
     }
-    return sought ? DRFLAC_TRUE : DRFLAC_FALSE;
-}
 
-static void *_malloc(size_t sz, void *pUserData) // FIXME: move to custom library.
-{
-    return malloc(sz);
-}
+    SL_props_reset(sample->props, (ma_uint32)pcm->sample_rate);
+    _rewind(sample);
 
-static void *_realloc(void *ptr, size_t sz, void *pUserData)
-{
-    return realloc(ptr, sz);
+    LOG_T("sample %p bound to PCM %p", source, pcm);
 }
 
-static void  _free(void *ptr, void *pUserData)
+void SL_sample_unbind(SL_Source_t *source)
 {
-    free(ptr);
+    Sample_t *sample = (Sample_t *)source;
+
+    if (sample->pcm) {
+        SL_pcm_release(sample->pcm);
+        sample->pcm = NULL;
+    }
+
+    LOG_T("sample %p unbound", source);
 }
 
-static bool _sample_ctor(SL_Source_t *source, const SL_Context_t *context, SL_Callbacks_t callbacks)
+static bool _sample_ctor(SL_Source_t *source, const SL_Context_t *context, SL_Pcm_t *pcm)
 {
     Sample_t *sample = (Sample_t *)source;
 
@@ -180,74 +147,22 @@ static bool _sample_ctor(SL_Source_t *source, const SL_Context_t *context, SL_Ca
                 .dtor = _sample_dtor,
                 .reset = _sample_reset,
                 .update = _sample_update,
-                .generate = _sample_generate
+                .generate = _sample_generate,
+                .advance = _sample_advance
             },
-            .callbacks = callbacks,
             .frames_completed = 0
         };
 
-    sample->decoder = drflac_open(_sample_read, _sample_seek, sample, &(drflac_allocation_callbacks){
-            .pUserData = NULL,
-            .onMalloc  = _malloc,
-            .onRealloc = _realloc,
-            .onFree    = _free
-        });
-    if (!sample->decoder) {
-        LOG_E("can't create sample decoder");
-        goto error_exit;
-    }
-
-    sample->length_in_frames = sample->decoder->totalPCMFrameCount;
-    if (sample->length_in_frames == 0) {
-        LOG_E("can't create sample w/ zero length");
-        goto error_close_decoder;
-    }
-
-    size_t channels = sample->decoder->channels;
-    size_t sample_rate = sample->decoder->sampleRate;
-    size_t bits_per_sample = sample->decoder->bitsPerSample;
-    LOG_D("sample decoder %p initialized w/ %d frames, %d channels, %dHz, %d bits", sample->decoder, sample->length_in_frames, channels, sample_rate, bits_per_sample);
-
-    if (channels != 1) {
-        LOG_E("samples need to be monaural (i.e. w/ 1 channel)");
-        goto error_close_decoder;
-    }
-
-#if defined(_SAMPLE_MAX_LENGTH_IN_SECONDS)
-    float duration = (float)sample->length_in_frames / (float)sample_rate;
-    if (duration > _SAMPLE_MAX_LENGTH_IN_SECONDS) {
-        LOG_E("sample is too long (%.2f seconds)", duration);
-        goto error_close_decoder;
-    }
-#endif
-
-    ma_audio_buffer_config config = ma_audio_buffer_config_init(INTERNAL_FORMAT, channels, sample->length_in_frames, NULL, NULL);
-    ma_result result = ma_audio_buffer_init_copy(&config, &sample->buffer); // NOTE: It will allocate but won't copy.
-    if (result != MA_SUCCESS) {
-        LOG_E("can't allocate buffer for %d frames", sample->length_in_frames);
-        goto error_close_decoder;
-    }
-
-    bool produced = _produce(sample);
-    if (!produced) {
-        LOG_E("can't read %d frames for sample", sample->length_in_frames);
-        goto error_deinitialize_audio_buffer;
-    }
-
-    sample->props = SL_props_create(context, INTERNAL_FORMAT, sample_rate, channels, _MIXING_BUFFER_CHANNELS_PER_FRAME);
+    const ma_uint32 sample_rate = pcm ? (ma_uint32)pcm->sample_rate : SL_FRAMES_PER_SECOND; // Fixed on binding, if unbound.
+    sample->props = SL_props_create(context, INTERNAL_FORMAT, sample_rate, 1, _MIXING_BUFFER_CHANNELS_PER_FRAME);
     if (!sample->props) {
         LOG_E("can't initialize sample properties");
-        goto error_deinitialize_audio_buffer;
+        return false;
     }
 
-    return true;
+    sample->pcm = pcm ? SL_pcm_acquire(pcm) : NULL;
 
-error_deinitialize_audio_buffer:
-    ma_audio_buffer_uninit(&sample->buffer);
-error_close_decoder:
-    drflac_close(sample->decoder);
-error_exit:
-    return false;
+    return true;
 }
 
 static void _sample_dtor(SL_Source_t *source)
@@ -257,11 +172,10 @@ static void _sample_dtor(SL_Source_t *source)
     SL_props_destroy(sample->props);
     LOG_D("sample properties destroyed");
 
-    ma_audio_buffer_uninit(&sample->buffer);
-    LOG_D("sample buffer uninitialized");
-
-    drflac_close(sample->decoder);
-    LOG_D("sample decoder closed");
+    if (sample->pcm) {
+        SL_pcm_release(sample->pcm);
+        LOG_D("sample PCM released");
+    }
 }
 
 static bool _sample_reset(SL_Source_t *source)
@@ -282,23 +196,24 @@ static bool _sample_update(SL_Source_t *source, float delta_time)
     return true; // NO-OP
 }
 
-static bool _sample_generate(SL_Source_t *source, void *output, size_t frames_requested)
+static bool _sample_generate(SL_Source_t *source, float *bus, size_t frames_requested)
 {
     Sample_t *sample = (Sample_t *)source;
 
     ma_data_converter *converter = &sample->props->converter;
-    ma_audio_buffer *buffer = &sample->buffer;
+    const SL_Pcm_t *pcm = sample->pcm;
     const bool looped = sample->props->looped;
 
+    const uint8_t *frames = (const uint8_t *)pcm->frames;
     uint8_t *converted_buffer = sample->mixing_buffer;
 
     const SL_Mix_t mix = sample->props->precomputed_mix;
 
-    uint8_t *cursor = (uint8_t *)output;
+    float *cursor = bus;
 
     size_t frames_remaining = frames_requested;
     while (frames_remaining > 0) {
-        if (sample->frames_completed == sample->length_in_frames) {
+        if (sample->frames_completed == pcm->length_in_frames) {
             if (!looped || !_rewind(sample)) {
                 LOG_D("end-of-data reached for source %p", source);
                 return false;
@@ -310,15 +225,17 @@ static bool _sample_generate(SL_Source_t *source, void *output, size_t frames_re
         ma_uint64 frames_to_consume;
         ma_data_converter_get_required_input_frame_count(converter, frames_to_generate, &frames_to_consume);
 
-        void *consumed_buffer;
-        ma_audio_buffer_map(buffer, &consumed_buffer, &frames_to_consume); // No need to check the result, can't fail.
+        size_t frames_available = pcm->length_in_frames - sample->frames_completed;
+        if (frames_to_consume > frames_available) {
+            frames_to_consume = frames_available;
+        }
+
+        const void *consumed_buffer = frames + sample->frames_completed * _MIXING_BUFFER_BYTES_PER_FRAME;
 
         ma_uint64 frames_consumed = frames_to_consume;
         ma_uint64 frames_generated = frames_to_generate;
         ma_data_converter_process_pcm_frames(converter, consumed_buffer, &frames_consumed, converted_buffer, &frames_generated);
 
-        ma_audio_buffer_unmap(buffer, frames_consumed); // Ditto.
-
         sample->frames_completed += frames_consumed;
 
 #if _MIXING_BUFFER_CHANNELS_PER_FRAME == 1
@@ -328,9 +245,40 @@ static bool _sample_generate(SL_Source_t *source, void *output, size_t frames_re
 #else
     #error "Mixing buffer has wrong number of channels"
 #endif
-        cursor += frames_generated * SL_BYTES_PER_FRAME;
+        cursor += frames_generated * SL_CHANNELS_PER_FRAME;
         frames_remaining -= frames_generated;
     }
 
     return true;
 }
+
+// The play-head is moved by the amount of frames that would have been consumed, w/o converting and mixing them.
+static bool _sample_advance(SL_Source_t *source, size_t frames_requested)
+{
+    Sample_t *sample = (Sample_t *)source;
+
+    ma_data_converter *converter = &sample->props->converter;
+    const SL_Pcm_t *pcm = sample->pcm;
+    const bool looped = sample->props->looped;
+
+    ma_uint64 frames_to_skip;
+    ma_data_converter_get_required_input_frame_count(converter, frames_requested, &frames_to_skip);
+
+    size_t frames_remaining = (size_t)frames_to_skip;
+    while (frames_remaining > 0) {
+        if (sample->frames_completed == pcm->length_in_frames) {
+            if (!looped || !_rewind(sample)) {
+                LOG_D("end-of-data reached for (virtual) source %p", source);
+                return false;
+            }
+        }
+
+        size_t frames_available = pcm->length_in_frames - sample->frames_completed;
+        size_t frames_skipped = frames_remaining > frames_available ? frames_available : frames_remaining;
+
+        sample->frames_completed += frames_skipped;
+        frames_remaining -= frames_skipped;
+    }
+
+    return true;
+}
@@ -27,8 +27,14 @@
 
 #include "common.h"
 #include "context.h"
+#include "pcm.h"
 #include "source.h"
 
-extern SL_Source_t *SL_sample_create(const SL_Context_t *context, SL_Callbacks_t callbacks);
+extern SL_Source_t *SL_sample_create(const SL_Context_t *context, SL_Pcm_t *pcm); // Acquires the PCM data, if any.
+
+// Unbound samples (i.e. w/o data) can be kept aside and recycled, binding them to the data when needed.
+extern bool SL_source_is_sample(const SL_Source_t *source);
+extern void SL_sample_bind(SL_Source_t *source, SL_Pcm_t *pcm); // Acquires the PCM data, releasing the previous one.
+extern void SL_sample_unbind(SL_Source_t *source);
 
 #endif  /* TOFU_LIBS_SL_SAMPLE_H */
@@ -29,6 +29,7 @@
 #include "context.h"
 #include "module.h"
 #include "music.h"
+#include "pcm.h"
 #include "sample.h"
 
 #endif  /* TOFU_LIBS_SL_H */
@@ -39,6 +39,11 @@ bool SL_source_reset(SL_Source_t *source)
     return source->vtable.reset(source);
 }
 
+bool SL_source_update(SL_Source_t *source, float delta_time)
+{
+    return source->vtable.update(source, delta_time);
+}
+
 void SL_source_set_group(SL_Source_t *source, size_t group_id)
 {
     SL_props_set_group(source->props, group_id);
@@ -79,6 +84,11 @@ void SL_source_set_speed(SL_Source_t *source, float speed)
     SL_props_set_speed(source->props, speed);
 }
 
+void SL_source_set_priority(SL_Source_t *source, size_t priority)
+{
+    SL_props_set_priority(source->props, priority);
+}
+
 size_t SL_source_get_group(const SL_Source_t *source)
 {
     return source->props->group_id;
@@ -104,6 +114,16 @@ float SL_source_get_speed(const SL_Source_t *source)
     return source->props->speed;
 }
 
+size_t SL_source_get_priority(const SL_Source_t *source)
+{
+    return source->props->priority;
+}
+
+size_t SL_source_get_underruns(const SL_Source_t *source)
+{
+    return source->props->underruns;
+}
+
 void SL_source_on_group_changed(SL_Source_t *source, size_t group_id)
 {
     SL_props_on_group_changed(source->props, group_id);
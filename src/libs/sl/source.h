@@ -42,14 +42,18 @@ extern void SL_source_set_twin_pan(SL_Source_t *source, float left_pan, float ri
 extern void SL_source_set_balance(SL_Source_t *source, float balance);
 extern void SL_source_set_gain(SL_Source_t *source, float gain);
 extern void SL_source_set_speed(SL_Source_t *source, float speed);
+extern void SL_source_set_priority(SL_Source_t *source, size_t priority);
 
 extern size_t SL_source_get_group(const SL_Source_t *source);
 extern bool SL_source_get_looped(const SL_Source_t *source);
 extern SL_Mix_t SL_source_get_mix(const SL_Source_t *source);
 extern float SL_source_get_gain(const SL_Source_t *source);
 extern float SL_source_get_speed(const SL_Source_t *source);
+extern size_t SL_source_get_priority(const SL_Source_t *source);
+extern size_t SL_source_get_underruns(const SL_Source_t *source);
 
 extern bool SL_source_reset(SL_Source_t *source);
+extern bool SL_source_update(SL_Source_t *source, float delta_time); // Not to be called concurrently w/ `SL_source_reset()`.
 
 extern void SL_source_on_group_changed(SL_Source_t *source, size_t group_id);
 
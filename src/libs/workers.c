@@ -0,0 +1,202 @@
+/*
+ *                 ___________________  _______________ ___
+ *                 \__    ___/\_____  \ \_   _____/    |   \
+ *                   |    |    /   |   \ |    __) |    |   /
+ *                   |    |   /    |    \|     \  |    |  /
+ *                   |____|   \_______  /\___  /  |______/
+ *                                    \/     \/
+ *         ___________ _______    ________.___ _______  ___________
+ *         \_   _____/ \      \  /  _____/|   |\      \ \_   _____/
+ *          |    __)_  /   |   \/   \  ___|   |/   |   \ |    __)_
+ *          |        \/    |    \    \_\  \   /    |    \|        \
+ *         /_______  /\____|__  /\______  /___\____|__  /_______  /
+ *                 \/         \/        \/            \/        \
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2019-2024 Marco Lizza
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "workers.h"
+
+#include <core/platform.h>
+#define _LOG_TAG "workers"
+#include <libs/log.h>
+
+#include <stdlib.h>
+
+#if PLATFORM_ID == PLATFORM_WINDOWS
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+static size_t _cores(void)
+{
+#if PLATFORM_ID == PLATFORM_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwNumberOfProcessors;
+#else
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (size_t)cores : 1;
+#endif
+}
+
+// Picks (and executes) the jobs of the current batch until they are exhausted.
+// The lock is to be held on entry, and it is held again on exit.
+static void _consume(Workers_t *workers)
+{
+    while (workers->batch.next < workers->batch.count) {
+        const size_t index = workers->batch.next++;
+        const Workers_Job_t job = workers->batch.job;
+        void *user_data = workers->batch.user_data;
+
+        pthread_mutex_unlock(&workers->lock);
+        job(user_data, index);
+        pthread_mutex_lock(&workers->lock);
+
+        workers->batch.pending -= 1;
+        if (workers->batch.pending == 0) {
+            pthread_cond_signal(&workers->done);
+        }
+    }
+}
+
+static void *_worker(void *arg)
+{
+    Workers_t *workers = (Workers_t *)arg;
+
+    pthread_mutex_lock(&workers->lock);
+    for (;;) {
+        while (!workers->quit && workers->batch.next >= workers->batch.count) {
+            pthread_cond_wait(&workers->wake, &workers->lock);
+        }
+        if (workers->quit) {
+            break;
+        }
+        _consume(workers);
+    }
+    pthread_mutex_unlock(&workers->lock);
+
+    return NULL;
+}
+
+Workers_t *Workers_create(size_t concurrency)
+{
+    Workers_t *workers = malloc(sizeof(Workers_t));
+    if (!workers) {
+        LOG_E("can't allocate workers");
+        goto error_exit;
+    }
+
+    const size_t count = (concurrency > 0 ? concurrency : _cores()) - 1;
+
+    pthread_t *threads = NULL;
+    if (count > 0) {
+        threads = malloc(sizeof(pthread_t) * count);
+        if (!threads) {
+            LOG_E("can't allocate %d threads", count);
+            goto error_free_workers;
+        }
+    }
+
+    *workers = (Workers_t){
+            .threads = threads,
+            .count = 0
+        };
+
+    pthread_mutex_init(&workers->lock, NULL);
+    pthread_cond_init(&workers->wake, NULL);
+    pthread_cond_init(&workers->done, NULL);
+
+    for (size_t i = 0; i < count; ++i) {
+        if (pthread_create(&workers->threads[i], NULL, _worker, workers) != 0) {
+            LOG_W("can't create worker thread #%d, continuing with %d threads", i, i);
+            break;
+        }
+        workers->count += 1;
+    }
+
+    LOG_D("workers %p created w/ %d threads", workers, workers->count);
+
+    return workers;
+
+error_free_workers:
+    free(workers);
+error_exit:
+    return NULL;
+}
+
+void Workers_destroy(Workers_t *workers)
+{
+    pthread_mutex_lock(&workers->lock);
+    workers->quit = true;
+    pthread_cond_broadcast(&workers->wake);
+    pthread_mutex_unlock(&workers->lock);
+
+    for (size_t i = 0; i < workers->count; ++i) {
+        pthread_join(workers->threads[i], NULL);
+    }
+    LOG_D("workers threads joined");
+
+    pthread_cond_destroy(&workers->done);
+    pthread_cond_destroy(&workers->wake);
+    pthread_mutex_destroy(&workers->lock);
+
+    free(workers->threads);
+    LOG_D("workers threads freed");
+
+    LOG_D("workers %p freed", workers);
+    free(workers);
+}
+
+size_t Workers_concurrency(const Workers_t *workers)
+{
+    return workers->count + 1;
+}
+
+void Workers_run(Workers_t *workers, Workers_Job_t job, void *user_data, size_t count)
+{
+    if (workers->count == 0 || count < 2) { // Not worth waking any thread up.
+        for (size_t i = 0; i < count; ++i) {
+            job(user_data, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&workers->lock);
+    workers->batch.job = job;
+    workers->batch.user_data = user_data;
+    workers->batch.count = count;
+    workers->batch.next = 0;
+    workers->batch.pending = count;
+    pthread_cond_broadcast(&workers->wake);
+
+    _consume(workers);
+
+    while (workers->batch.pending > 0) {
+        pthread_cond_wait(&workers->done, &workers->lock);
+    }
+    workers->batch.count = 0;
+    workers->batch.next = 0;
+    pthread_mutex_unlock(&workers->lock);
+}
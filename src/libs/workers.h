@@ -0,0 +1,77 @@
+/*
+ *                 ___________________  _______________ ___
+ *                 \__    ___/\_____  \ \_   _____/    |   \
+ *                   |    |    /   |   \ |    __) |    |   /
+ *                   |    |   /    |    \|     \  |    |  /
+ *                   |____|   \_______  /\___  /  |______/
+ *                                    \/     \/
+ *         ___________ _______    ________.___ _______  ___________
+ *         \_   _____/ \      \  /  _____/|   |\      \ \_   _____/
+ *          |    __)_  /   |   \/   \  ___|   |/   |   \ |    __)_
+ *          |        \/    |    \    \_\  \   /    |    \|        \
+ *         /_______  /\____|__  /\______  /___\____|__  /_______  /
+ *                 \/         \/        \/            \/        \
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2019-2024 Marco Lizza
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TOFU_LIBS_WORKERS_H
+#define TOFU_LIBS_WORKERS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// A job is identified by its index in the batch, in the range `[0, count)`.
+typedef void (*Workers_Job_t)(void *user_data, size_t index);
+
+typedef struct Workers_s {
+    pthread_t *threads;
+    size_t count; // Amount of spawned threads (the calling thread is not included).
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    struct {
+        Workers_Job_t job;
+        void *user_data;
+        size_t count;
+        size_t next; // Next job to be picked.
+        size_t pending; // Jobs not completed, yet.
+    } batch;
+    bool quit;
+} Workers_t;
+
+// Creates a pool of threads, for a total of `concurrency` threads including the
+// calling one. When `0` is passed the amount of online CPU cores is used.
+extern Workers_t *Workers_create(size_t concurrency);
+extern void Workers_destroy(Workers_t *workers);
+
+extern size_t Workers_concurrency(const Workers_t *workers);
+
+// Executes the `count` jobs of the batch, spreading them across the pool. The
+// calling thread joins the execution and the function returns only when every
+// job has been completed. Jobs of the same batch are required not to overlap
+// in the data they modify.
+extern void Workers_run(Workers_t *workers, Workers_Job_t job, void *user_data, size_t count);
+
+#endif  /* TOFU_LIBS_WORKERS_H */
@@ -37,23 +37,48 @@
 
 #include "xor.h"
 
+#include <string.h>
+
 void xor_schedule(xor_context_t *context, const uint8_t *key, size_t size)
 {
     *context = (xor_context_t){ 
             .n = size < XOR_MAX_KEY_LENGTH ? size : XOR_MAX_KEY_LENGTH
         };
 
-    for (size_t i = 0; i < context->n; ++i) {
-        context->K[i] = key[i];
+    for (size_t i = 0; i < context->n + sizeof(uint64_t); ++i) {
+        context->K[i] = key[i % context->n];
     }
 }
 
+// The data is processed a (64 bits) word at a time. As the key is extended past its length, the key word can be read
+// starting from any position of the key-stream. The remaining tail is processed a byte at a time.
 void xor_process(xor_context_t *context, uint8_t *out, const uint8_t *in, size_t size)
 {
-    for (size_t i = 0; i < size; ++i) {
-        out[i] = in[i] ^ context->K[context->i];
-        context->i = (context->i + 1) % context->n;
+    const size_t n = context->n;
+    size_t i = context->i;
+
+    size_t offset = 0;
+    for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+        uint64_t word, key;
+        memcpy(&word, in + offset, sizeof(uint64_t)); // Compiles to plain (unaligned) loads and stores.
+        memcpy(&key, context->K + i, sizeof(uint64_t));
+        word ^= key;
+        memcpy(out + offset, &word, sizeof(uint64_t));
+
+        i += sizeof(uint64_t);
+        while (i >= n) {
+            i -= n;
+        }
     }
+
+    for (; offset < size; ++offset) {
+        out[offset] = in[offset] ^ context->K[i];
+        if (++i == n) {
+            i = 0;
+        }
+    }
+
+    context->i = i;
 }
 
 void xor_seek(xor_context_t *context, size_t index)
@@ -44,7 +44,7 @@
 #define XOR_MAX_KEY_LENGTH  256
 
 typedef struct xor_context_s {
-    uint8_t K[XOR_MAX_KEY_LENGTH];
+    uint8_t K[XOR_MAX_KEY_LENGTH + sizeof(uint64_t)]; // The key is repeated past its length, to read whole words.
     size_t n, i;
 } xor_context_t;
 
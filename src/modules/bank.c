@@ -50,6 +50,7 @@
 static int bank_new_v_1o(lua_State *L);
 static int bank_gc_1o_0(lua_State *L);
 static int bank_size_4onNN_2n(lua_State *L);
+static int bank_compile_1o_0(lua_State *L);
 
 int bank_loader(lua_State *L)
 {
@@ -60,6 +61,8 @@ int bank_loader(lua_State *L)
             { "__gc", bank_gc_1o_0 },
             // -- accessors --
             { "size", bank_size_4onNN_2n },
+            // -- mutators --
+            { "compile", bank_compile_1o_0 },
             { NULL, NULL }
         },
         (const luaX_Const[]){
@@ -180,3 +183,18 @@ static int bank_size_4onNN_2n(lua_State *L)
 
     return 2;
 }
+
+static int bank_compile_1o_0(lua_State *L)
+{
+    LUAX_SIGNATURE_BEGIN(L)
+        LUAX_SIGNATURE_REQUIRED(LUA_TOBJECT)
+    LUAX_SIGNATURE_END
+    Bank_Object_t *self = (Bank_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_BANK);
+
+    bool compiled = GL_sheet_compile(self->sheet);
+    if (!compiled) {
+        return luaL_error(L, "can't compile bank %p", self);
+    }
+
+    return 0;
+}
@@ -46,6 +46,8 @@
 
 static int batch_new_2on_1o(lua_State *L);
 static int batch_gc_1o_0(lua_State *L);
+static int batch_layer_v_v(lua_State *L);
+static int batch_stats_1o_2nn(lua_State *L);
 static int batch_resize_2on_0(lua_State *L);
 static int batch_grow_2on_0(lua_State *L);
 static int batch_clear_1o_0(lua_State *L);
@@ -58,6 +60,10 @@ int batch_loader(lua_State *L)
             // -- constructors/destructors --
             { "new", batch_new_2on_1o },
             { "__gc", batch_gc_1o_0 },
+            // -- getters/setters --
+            { "layer", batch_layer_v_v },
+            // -- accessors --
+            { "stats", batch_stats_1o_2nn },
             // -- mutators --
             { "resize", batch_resize_2on_0 },
             { "grow", batch_grow_2on_0 },
@@ -90,7 +96,8 @@ static int batch_new_2on_1o(lua_State *L)
                 .instance = bank,
                 .reference = luaX_ref(L, 1)
             },
-            .queue = queue
+            .queue = queue,
+            .layer = 0
         }, OBJECT_TYPE_BATCH);
 
     LOG_D("batch %p created w/ bank %p", self, bank);
@@ -116,6 +123,54 @@ static int batch_gc_1o_0(lua_State *L)
     return 0;
 }
 
+static int batch_layer_1o_1n(lua_State *L)
+{
+    LUAX_SIGNATURE_BEGIN(L)
+        LUAX_SIGNATURE_REQUIRED(LUA_TOBJECT)
+    LUAX_SIGNATURE_END
+    const Batch_Object_t *self = (const Batch_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_BATCH);
+
+    lua_pushinteger(L, (lua_Integer)self->layer);
+
+    return 1;
+}
+
+static int batch_layer_2on_0(lua_State *L)
+{
+    LUAX_SIGNATURE_BEGIN(L)
+        LUAX_SIGNATURE_REQUIRED(LUA_TOBJECT)
+        LUAX_SIGNATURE_REQUIRED(LUA_TNUMBER)
+    LUAX_SIGNATURE_END
+    Batch_Object_t *self = (Batch_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_BATCH);
+    int layer = LUAX_INTEGER(L, 2);
+
+    self->layer = layer;
+
+    return 0;
+}
+
+static int batch_layer_v_v(lua_State *L)
+{
+    LUAX_OVERLOAD_BEGIN(L)
+        LUAX_OVERLOAD_BY_ARITY(batch_layer_1o_1n, 1)
+        LUAX_OVERLOAD_BY_ARITY(batch_layer_2on_0, 2)
+    LUAX_OVERLOAD_END
+}
+
+static int batch_stats_1o_2nn(lua_State *L)
+{
+    LUAX_SIGNATURE_BEGIN(L)
+        LUAX_SIGNATURE_REQUIRED(LUA_TOBJECT)
+    LUAX_SIGNATURE_END
+    const Batch_Object_t *self = (const Batch_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_BATCH);
+
+    const GL_Queue_Stats_t *stats = &self->queue->stats;
+    lua_pushinteger(L, (lua_Integer)stats->culled);
+    lua_pushinteger(L, (lua_Integer)stats->drawn);
+
+    return 2;
+}
+
 static int batch_resize_2on_0(lua_State *L)
 {
     LUAX_SIGNATURE_BEGIN(L)
@@ -180,7 +235,8 @@ static int batch_add_4onNN_0(lua_State *L)
             .position = (GL_Point_t){ .x = x, .y = y },
             .scale_x = 1.0f, .scale_y = 1.0f,
             .rotation = 0,
-            .anchor_x = 0.5f, .anchor_y = 0.5f
+            .anchor_x = 0.5f, .anchor_y = 0.5f,
+            .z = self->layer
         });
 
     return 0;
@@ -206,7 +262,8 @@ static int batch_add_5onnnn_0(lua_State *L)
             .position = (GL_Point_t){ .x = x, .y = y },
             .scale_x = 1.0f, .scale_y = 1.0f,
             .rotation = rotation,
-            .anchor_x = 0.5f, .anchor_y = 0.5f
+            .anchor_x = 0.5f, .anchor_y = 0.5f,
+            .z = self->layer
         });
 
     return 0;
@@ -234,7 +291,8 @@ static int batch_add_6onnnnn_0(lua_State *L)
             .position = (GL_Point_t){ .x = x, .y = y },
             .scale_x = scale_x, .scale_y = scale_y,
             .rotation = 0,
-            .anchor_x = 0.5f, .anchor_y = 0.5f
+            .anchor_x = 0.5f, .anchor_y = 0.5f,
+            .z = self->layer
         });
 
     return 0;
@@ -268,7 +326,8 @@ static int batch_add_9onnnnnNNN_0(lua_State *L)
             .position = (GL_Point_t){ .x = x, .y = y },
             .scale_x = scale_x, .scale_y = scale_y,
             .rotation = rotation,
-            .anchor_x = anchor_x, .anchor_y = anchor_y
+            .anchor_x = anchor_x, .anchor_y = anchor_y,
+            .z = self->layer
         });
 
     return 0;
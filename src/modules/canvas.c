@@ -75,7 +75,7 @@ static int canvas_stencil_v_0(lua_State *L);
 static int canvas_blend_v_0(lua_State *L);
 static int canvas_sprite_v_0(lua_State *L);
 static int canvas_tile_v_0(lua_State *L);
-static int canvas_flush_3ooS_0(lua_State *L);
+static int canvas_flush_4ooSB_0(lua_State *L);
 static int canvas_text_v_2nn(lua_State *L);
 
 // TODO: rename `Canvas` to `Context`?
@@ -116,7 +116,7 @@ int canvas_loader(lua_State *L)
             { "blend", canvas_blend_v_0 },
             { "sprite", canvas_sprite_v_0 }, // bank-to-canvas
             { "tile", canvas_tile_v_0 },
-            { "flush", canvas_flush_3ooS_0 }, // batch-to-canvas
+            { "flush", canvas_flush_4ooSB_0 }, // batch-to-canvas
             { "text", canvas_text_v_2nn }, // font-to-canvas
             { NULL, NULL }
         },
@@ -1355,31 +1355,47 @@ static int canvas_tile_v_0(lua_State *L)
 }
 
 // TODO: are sprite-batches useful? Profile it...
-static int canvas_flush_3ooS_0(lua_State *L)
+static int canvas_flush_4ooSB_0(lua_State *L)
 {
     LUAX_SIGNATURE_BEGIN(L)
         LUAX_SIGNATURE_REQUIRED(LUA_TOBJECT)
         LUAX_SIGNATURE_REQUIRED(LUA_TOBJECT)
         LUAX_SIGNATURE_OPTIONAL(LUA_TSTRING)
+        LUAX_SIGNATURE_OPTIONAL(LUA_TBOOLEAN)
     LUAX_SIGNATURE_END
     const Canvas_Object_t *self = (const Canvas_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_CANVAS);
     const Batch_Object_t *batch = (const Batch_Object_t *)LUAX_OBJECT(L, 2, OBJECT_TYPE_BATCH);
     const char *mode = LUAX_OPTIONAL_STRING(L, 3, "fast");
+    bool parallel = LUAX_OPTIONAL_BOOLEAN(L, 4, false);
 
-    const GL_Queue_t *queue = batch->queue;
-    const GL_Context_t *context = self->context;
+    GL_Queue_Modes_t queue_mode;
     if (mode[0] == 'f') { // FIXME: translate all these into map-lookups?
-        GL_queue_blit(queue, context);
+        queue_mode = GL_QUEUE_MODE_FAST;
     } else
     if (mode[0] == 's') {
-        GL_queue_blit_s(queue, context);
+        queue_mode = GL_QUEUE_MODE_SCALED;
     } else
     if (mode[0] == 'c') {
-        GL_queue_blit_sr(queue, context);
+        queue_mode = GL_QUEUE_MODE_COMPLETE;
     } else {
         return luaL_error(L, "unknown mode `%s`", mode);
     }
 
+    GL_Queue_t *queue = batch->queue;
+    const GL_Context_t *context = self->context;
+    if (parallel) {
+        const Display_t *display = (const Display_t *)udt_get_userdata(L, USERDATA_DISPLAY);
+        GL_queue_blit_parallel(queue, context, queue_mode, Display_get_workers(display));
+    } else
+    if (queue_mode == GL_QUEUE_MODE_FAST) {
+        GL_queue_blit(queue, context);
+    } else
+    if (queue_mode == GL_QUEUE_MODE_SCALED) {
+        GL_queue_blit_s(queue, context);
+    } else {
+        GL_queue_blit_sr(queue, context);
+    }
+
     return 0;
 }
 
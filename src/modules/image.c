@@ -41,6 +41,7 @@
 #include "internal/udt.h"
 
 #include <core/config.h>
+#include <libs/bytes.h>
 #define _LOG_TAG "image"
 #include <libs/log.h>
 #include <libs/stopwatch.h>
@@ -48,6 +49,33 @@
 #include <systems/display.h>
 #include <systems/storage.h>
 
+#include <string.h>
+
+// Indexed images are produced offline by the `idxgen` tool, that performs the color-matching against a given palette.
+// The file is a fixed-size header followed by `width * height` raw pixels, and is copied straight into the surface.
+// All the values are stored in little-endian format.
+#define INDEXED_IMAGE_EXTENSION_SZ ".idx"
+#define INDEXED_IMAGE_SIGNATURE    "TOFUIDX!"
+#define INDEXED_IMAGE_VERSION      0
+
+#define INDEXED_IMAGE_MAX_SIZE     16384 // Sanity limit for each dimension.
+
+#define INDEXED_IMAGE_FLAG_PALETTE_HASH       0x01
+#define INDEXED_IMAGE_FLAG_TRANSPARENT_INDEX  0x02
+
+#pragma pack(push, 1)
+typedef struct Indexed_Image_Header_s {
+    char signature[8];
+    uint8_t version;
+    uint8_t flags;
+    uint8_t transparent_index; // The one the transparent pixels have been baked with.
+    uint8_t reserved;
+    uint32_t width;
+    uint32_t height;
+    uint32_t palette_hash;
+} Indexed_Image_Header_t;
+#pragma pack(pop)
+
 static int image_new_v_1o(lua_State *L);
 static int image_gc_1o_0(lua_State *L);
 static int image_size_1o_2nn(lua_State *L);
@@ -123,6 +151,83 @@ static int image_new_2nn_1o(lua_State *L)
     return 1;
 }
 
+static bool _is_indexed(const char *name)
+{
+    size_t length = strlen(name);
+    size_t extension_length = strlen(INDEXED_IMAGE_EXTENSION_SZ);
+    return length > extension_length && strcmp(name + length - extension_length, INDEXED_IMAGE_EXTENSION_SZ) == 0;
+}
+
+// The transparent index has been baked in by the tool, we can only check it matches the requested one (if any).
+static GL_Surface_t *_load_indexed(const Storage_t *storage, const char *name, const GL_Color_t *palette, const GL_Pixel_t *transparent_index)
+{
+    FS_Handle_t *handle = Storage_open(storage, name);
+    if (!handle) {
+        LOG_E("can't open file `%s`", name);
+        return NULL;
+    }
+
+    Indexed_Image_Header_t header;
+    size_t bytes_read = FS_read(handle, &header, sizeof(Indexed_Image_Header_t));
+    if (bytes_read != sizeof(Indexed_Image_Header_t)) {
+        LOG_E("can't read header from file `%s`", name);
+        goto error_close;
+    }
+
+    if (strncmp(header.signature, INDEXED_IMAGE_SIGNATURE, sizeof(header.signature)) != 0) {
+        LOG_E("file `%s` is not an indexed image", name);
+        goto error_close;
+    }
+    if (header.version > INDEXED_IMAGE_VERSION) {
+        LOG_E("indexed image `%s` has unsupported version %d", name, header.version);
+        goto error_close;
+    }
+
+    size_t width = bytes_ui32le(header.width);
+    size_t height = bytes_ui32le(header.height);
+    if (width == 0 || height == 0 || width > INDEXED_IMAGE_MAX_SIZE || height > INDEXED_IMAGE_MAX_SIZE) {
+        LOG_E("indexed image `%s` has invalid size %dx%d", name, width, height);
+        goto error_close;
+    }
+
+    if ((header.flags & INDEXED_IMAGE_FLAG_PALETTE_HASH) && bytes_ui32le(header.palette_hash) != GL_palette_hash(palette)) {
+        LOG_W("indexed image `%s` was matched against a different palette", name);
+    }
+
+    if (transparent_index) {
+        if (!(header.flags & INDEXED_IMAGE_FLAG_TRANSPARENT_INDEX)) {
+            LOG_E("indexed image `%s` has no transparent index information, can't use index %d", name, *transparent_index);
+            goto error_close;
+        }
+        if (header.transparent_index != *transparent_index) {
+            LOG_E("indexed image `%s` was generated w/ transparent index %d, not %d", name, header.transparent_index, *transparent_index);
+            goto error_close;
+        }
+    }
+
+    GL_Surface_t *surface = GL_surface_create(width, height);
+    if (!surface) {
+        LOG_E("can't create %dx%d surface for file `%s`", width, height, name);
+        goto error_close;
+    }
+
+    size_t bytes_requested = surface->data_size * sizeof(GL_Pixel_t);
+    bytes_read = FS_read(handle, surface->data, bytes_requested);
+    if (bytes_read != bytes_requested) {
+        LOG_E("can't read %d byte(s) of pixel data from file `%s`", bytes_requested, name);
+        GL_surface_destroy(surface);
+        goto error_close;
+    }
+
+    FS_close(handle);
+
+    return surface;
+
+error_close:
+    FS_close(handle);
+    return NULL;
+}
+
 static int image_new_3sNO_1o(lua_State *L)
 {
     LUAX_SIGNATURE_BEGIN(L)
@@ -132,28 +237,46 @@ static int image_new_3sNO_1o(lua_State *L)
     LUAX_SIGNATURE_END
     const char *name = LUAX_STRING(L, 1);
     GL_Pixel_t transparent_index = (GL_Pixel_t)LUAX_OPTIONAL_UNSIGNED(L, 2, 0);
-    const Palette_Object_t *palette = (const Palette_Object_t *)LUAX_OPTIONAL_OBJECT(L, 3, OBJECT_TYPE_PALETTE, NULL);
+    Palette_Object_t *palette = (Palette_Object_t *)LUAX_OPTIONAL_OBJECT(L, 3, OBJECT_TYPE_PALETTE, NULL);
 
     Storage_t *storage = (Storage_t *)udt_get_userdata(L, USERDATA_STORAGE);
-    const Display_t *display = (const Display_t *)udt_get_userdata(L, USERDATA_DISPLAY);
+    Display_t *display = (Display_t *)udt_get_userdata(L, USERDATA_DISPLAY);
 
-    Callback_Palette_Closure_t closure = (Callback_Palette_Closure_t){
-            .palette = palette ? palette->palette : Display_get_palette(display), // Use current display's if not passed.
-            .transparent = transparent_index,
-            .threshold = 0
-        };
+    const GL_Color_t *colors = palette ? palette->palette : Display_get_palette(display); // Use current display's if not passed.
 
 #if defined(TOFU_CORE_PROFILING_ENABLED)
     StopWatch_t stopwatch = stopwatch_init();
     LOG_I("profiling loading and decoding for image `%s`", name);
 #endif
-    const Storage_Resource_t *image = Storage_load(storage, name, STORAGE_RESOURCE_IMAGE);
-    if (!image) {
-        return luaL_error(L, "can't load file `%s`", name);
-    }
-    GL_Surface_t *surface = GL_surface_decode(SR_IWIDTH(image), SR_IHEIGHT(image), SR_IPIXELS(image), surface_callback_palette, (void *)&closure);
-    if (!surface) {
-        return luaL_error(L, "can't decode file `%s`", name);
+    GL_Surface_t *surface;
+    if (_is_indexed(name)) { // Already color-matched, the transparent index has been baked in, too.
+        surface = _load_indexed(storage, name, colors, lua_isnoneornil(L, 2) ? NULL : &transparent_index);
+        if (!surface) {
+            return luaL_error(L, "can't load file `%s`", name);
+        }
+    } else {
+        const Storage_Resource_t *image = Storage_load(storage, name, STORAGE_RESOURCE_IMAGE);
+        if (!image) {
+            return luaL_error(L, "can't load file `%s`", name);
+        }
+        // Both the palette object and the display own a (lazily created) matcher, so that it's shared among loads.
+        if (palette && !palette->matcher) {
+            palette->matcher = GL_matcher_create(palette->palette);
+            LOG_IF_D(palette->matcher, "matcher %p created for palette %p", palette->matcher, palette);
+        }
+        const GL_Matcher_t *matcher = palette ? palette->matcher : Display_get_matcher(display);
+        if (!matcher) {
+            return luaL_error(L, "can't create matcher for file `%s`", name);
+        }
+        Callback_Palette_Closure_t closure = (Callback_Palette_Closure_t){
+                .matcher = matcher,
+                .transparent = transparent_index,
+                .threshold = 0
+            };
+        surface = GL_surface_decode(SR_IWIDTH(image), SR_IHEIGHT(image), SR_IPIXELS(image), surface_callback_palette, (void *)&closure);
+        if (!surface) {
+            return luaL_error(L, "can't decode file `%s`", name);
+        }
     }
 #if defined(TOFU_CORE_PROFILING_ENABLED)
     LOG_I("loading and decoding image `%s` took %.3fs", name, stopwatch_elapsed(&stopwatch));
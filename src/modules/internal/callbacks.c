@@ -48,7 +48,8 @@ typedef struct rgba_s {
 
 // Given an `MxN` RGBA8888 image, the naive conversion to the color-indexed format requires `MxN` scans to find the
 // nearest-matching color in the palette. This is a computationally demanding operation, since it computes the Euclidean
-// distance for each palette-entry. Even for small images the load-and-convert times are non negligible.
+// distance for each palette-entry. Even for small images the load-and-convert times are non negligible (the matcher
+// scans the palette with vector instructions, but that's not enough).
 //
 // We can get a huge performance boost by adopting a "memoization" technique. Each nearest match is dynamically stored
 // into a hash-map during the conversion: a color is first checked if has been already encountered and converted; if not
@@ -85,7 +86,7 @@ void surface_callback_palette(void *user_data, GL_Surface_t *surface, const void
             }
 #endif  /* TOFU_GRAPHICS_PALETTE_MATCH_MEMOIZATION */
 
-            const GL_Pixel_t index = GL_palette_find_nearest_color(closure->palette, color);
+            const GL_Pixel_t index = GL_matcher_match(closure->matcher, color);
             *(dst++) = index;
 #if defined(TOFU_GRAPHICS_PALETTE_MATCH_MEMOIZATION)
             hmput(cache, color, index);
@@ -41,7 +41,7 @@
 #include <libs/gl/gl.h>
 
 typedef struct Callback_Palette_Closure_s {
-    const GL_Color_t *palette;
+    const GL_Matcher_t *matcher;
     GL_Pixel_t transparent;
     uint8_t threshold;
 } Callback_Palette_Closure_t;
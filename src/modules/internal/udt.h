@@ -132,6 +132,7 @@ typedef struct Batch_Object_s {
         luaX_Reference reference;
     } bank;
     GL_Queue_t *queue;
+    int layer; // Assigned to the sprites as they are added.
 } Batch_Object_t;
 
 typedef struct XForm_Object_s {
@@ -141,6 +142,7 @@ typedef struct XForm_Object_s {
 typedef struct Palette_Object_s {
     GL_Color_t palette[GL_MAX_PALETTE_COLORS];
     size_t size;
+    GL_Matcher_t *matcher; // Lazily created on first match, and dropped when the palette changes.
 } Palette_Object_t;
 
 typedef struct Program_Object_s {
@@ -51,7 +51,7 @@ static int palette_peek_2on_3nnn(lua_State *L);
 static int palette_poke_5onnnn_0(lua_State *L);
 static int palette_lerp_5onnnN_0(lua_State *L);
 static int palette_merge_6ononnB_0(lua_State *L);
-static int palette_match_4onnn_1n(lua_State *L);
+static int palette_match_5onnnB_1n(lua_State *L);
 static int palette_mix_7nnnnnnN_3nnn(lua_State *L);
 
 int palette_loader(lua_State *L)
@@ -70,7 +70,7 @@ int palette_loader(lua_State *L)
             { "lerp", palette_lerp_5onnnN_0 },
             { "merge", palette_merge_6ononnB_0 },
             // -- operations --
-            { "match", palette_match_4onnn_1n },
+            { "match", palette_match_5onnnB_1n },
             { "mix", palette_mix_7nnnnnnN_3nnn },
             { NULL, NULL }
         },
@@ -236,6 +236,14 @@ static int palette_new_v_1o(lua_State *L)
     LUAX_OVERLOAD_END
 }
 
+static void _invalidate(Palette_Object_t *self)
+{
+    if (self->matcher) {
+        GL_matcher_destroy(self->matcher);
+        self->matcher = NULL;
+    }
+}
+
 static int palette_gc_1o_0(lua_State *L)
 {
     LUAX_SIGNATURE_BEGIN(L)
@@ -243,6 +251,8 @@ static int palette_gc_1o_0(lua_State *L)
     LUAX_SIGNATURE_END
     Palette_Object_t *self = (Palette_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_PALETTE);
 
+    _invalidate(self);
+
     LOG_D("palette %p finalized", self);
 
     return 0;
@@ -325,6 +335,8 @@ int palette_poke_5onnnn_0(lua_State *L)
     const GL_Color_t color = (GL_Color_t){ .r = r, .g = g, .b = b, .a = 255 };
     palette[index] = color;
 
+    _invalidate(self);
+
     return 0;
 }
 
@@ -348,6 +360,8 @@ static int palette_lerp_5onnnN_0(lua_State *L)
     GL_Color_t *palette = self->palette;
     GL_palette_lerp(palette, color, ratio);
 
+    _invalidate(self);
+
     return 0;
 }
 
@@ -374,26 +388,40 @@ static int palette_merge_6ononnB_0(lua_State *L)
     self->size = size;
     LOG_D("palette %p has now %d color(s)", self, size);
 
+    _invalidate(self);
+
     return 0;
 }
 
-static int palette_match_4onnn_1n(lua_State *L)
+static int palette_match_5onnnB_1n(lua_State *L)
 {
     LUAX_SIGNATURE_BEGIN(L)
         LUAX_SIGNATURE_REQUIRED(LUA_TOBJECT)
         LUAX_SIGNATURE_REQUIRED(LUA_TNUMBER)
         LUAX_SIGNATURE_REQUIRED(LUA_TNUMBER)
         LUAX_SIGNATURE_REQUIRED(LUA_TNUMBER)
+        LUAX_SIGNATURE_OPTIONAL(LUA_TBOOLEAN)
     LUAX_SIGNATURE_END
-    const Palette_Object_t *self = (const Palette_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_PALETTE);
+    Palette_Object_t *self = (Palette_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_PALETTE);
     uint8_t r = (uint8_t)LUAX_INTEGER(L, 2);
     uint8_t g = (uint8_t)LUAX_INTEGER(L, 3);
     uint8_t b = (uint8_t)LUAX_INTEGER(L, 4);
+    bool approximate = LUAX_OPTIONAL_BOOLEAN(L, 5, false);
+
+    if (!self->matcher) {
+        self->matcher = GL_matcher_create(self->palette);
+        if (!self->matcher) {
+            return luaL_error(L, "can't create matcher for palette %p", self);
+        }
+        LOG_D("matcher %p created for palette %p", self->matcher, self);
+    }
 
     const GL_Color_t color = (GL_Color_t){ .r = r, .g = g, .b = b, .a = 255 };
 
-    const GL_Color_t *palette = self->palette;
-    const GL_Pixel_t index = GL_palette_find_nearest_color(palette, color);
+    // The approximate match uses the (lazily filled) lookup cube, and it's the way to go for runtime recoloring.
+    const GL_Pixel_t index = approximate
+        ? GL_matcher_match_cached(self->matcher, color)
+        : GL_matcher_match(self->matcher, color);
 
     lua_pushinteger(L, (lua_Integer)index);
 
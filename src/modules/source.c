@@ -63,7 +63,9 @@ static int source_pan_v_0(lua_State *L);
 static int source_balance_2on_0(lua_State *L);
 static int source_gain_v_v(lua_State *L);
 static int source_speed_v_v(lua_State *L);
+static int source_priority_v_v(lua_State *L);
 static int source_is_playing_1o_1b(lua_State *L);
+static int source_underruns_1o_1n(lua_State *L);
 static int source_play_1o_0(lua_State *L);
 static int source_resume_1o_0(lua_State *L);
 static int source_stop_1o_0(lua_State *L);
@@ -83,8 +85,10 @@ int source_loader(lua_State *L)
             { "balance", source_balance_2on_0 },
             { "gain", source_gain_v_v },
             { "speed", source_speed_v_v },
+            { "priority", source_priority_v_v },
             // -- accessors --
             { "is_playing", source_is_playing_1o_1b },
+            { "underruns", source_underruns_1o_1n },
             // -- operations --
             { "play", source_play_1o_0 },
             { "resume", source_resume_1o_0 },
@@ -129,10 +133,44 @@ static const char *_types[Source_Type_t_CountOf + 1] = {
 
 static const Source_Create_Function_t _create_functions[Source_Type_t_CountOf] = {
     SL_music_create,
-    SL_sample_create,
+    NULL, // Samples are created from the (cached) decoded data, see `_create_sample()`.
     SL_module_create
 };
 
+static inline SL_Callbacks_t _callbacks(FS_Handle_t *handle)
+{
+    return (SL_Callbacks_t){
+            .read = _handle_read,
+            .seek = _handle_seek,
+            .tell = _handle_tell,
+            .eof = _handle_eof,
+            .user_data = (void *)handle
+        };
+}
+
+// Samples are just play-heads over the shared decoded data, which is decoded only on the first request. The file
+// handle is no longer needed once the data is decoded.
+static SL_Source_t *_create_sample(Audio_t *audio, const Storage_t *storage, const char *name)
+{
+    SL_Pcm_t *pcm = Audio_get_pcm(audio, name);
+    if (!pcm) {
+        FS_Handle_t *handle = Storage_open(storage, name);
+        if (!handle) {
+            LOG_E("can't access file `%s`", name);
+            return NULL;
+        }
+        pcm = SL_pcm_decode(_callbacks(handle));
+        FS_close(handle);
+        if (!pcm) {
+            LOG_E("can't decode file `%s`", name);
+            return NULL;
+        }
+        Audio_cache_pcm(audio, name, pcm);
+    }
+
+    return Audio_create_sample(audio, pcm);
+}
+
 static int source_new_2sE_1o(lua_State *L)
 {
     LUAX_SIGNATURE_BEGIN(L)
@@ -145,22 +183,25 @@ static int source_new_2sE_1o(lua_State *L)
     const Storage_t *storage = (const Storage_t *)udt_get_userdata(L, USERDATA_STORAGE);
     Audio_t *audio = (Audio_t *)udt_get_userdata(L, USERDATA_AUDIO);
 
-    FS_Handle_t *handle = Storage_open(storage, name); // The handle is kept open, the source could require it.
-    if (!handle) {
-        return luaL_error(L, "can't access file `%s`", name);
-    }
-    LOG_D("handle %p opened for file `%s`", handle, name);
-
-    SL_Source_t *source = _create_functions[type](audio->context, (SL_Callbacks_t){
-            .read = _handle_read,
-            .seek = _handle_seek,
-            .tell = _handle_tell,
-            .eof = _handle_eof,
-            .user_data = (void *)handle
-        });
-    if (!source) {
-        FS_close(handle);
-        return luaL_error(L, "can't create source");
+    FS_Handle_t *handle = NULL;
+    SL_Source_t *source = NULL;
+    if (type == SOURCE_TYPE_SAMPLE) {
+        source = _create_sample(audio, storage, name);
+        if (!source) {
+            return luaL_error(L, "can't create source for file `%s`", name);
+        }
+    } else {
+        handle = Storage_open(storage, name); // The handle is kept open, streamed sources require it.
+        if (!handle) {
+            return luaL_error(L, "can't access file `%s`", name);
+        }
+        LOG_D("handle %p opened for file `%s`", handle, name);
+
+        source = _create_functions[type](audio->context, _callbacks(handle));
+        if (!source) {
+            FS_close(handle);
+            return luaL_error(L, "can't create source");
+        }
     }
     LOG_D("source %p created, type #%d", source, type);
 
@@ -183,13 +224,15 @@ static int source_gc_1o_0(lua_State *L)
 
     Audio_t *audio = (Audio_t *)udt_get_userdata(L, USERDATA_AUDIO);
 
-    Audio_untrack(audio, self->source); // Make sure we aren't leaving dangling pointers...
-
-    SL_source_destroy(self->source);
-    LOG_D("source %p destroyed", self->source);
+    // The device could still be mixing the source, it will be destroyed once released. The handle can be closed
+    // right away, as the source is no longer updated (i.e. no more data is read).
+    Audio_discard(audio, self->source);
+    LOG_D("source %p discarded", self->source);
 
-    FS_close(self->handle);
-    LOG_D("handle %p closed", self->handle);
+    if (self->handle) { // Samples don't keep the handle.
+        FS_close(self->handle);
+        LOG_D("handle %p closed", self->handle);
+    }
 
     LOG_D("source %p finalized", self);
 
@@ -434,6 +477,40 @@ static int source_speed_v_v(lua_State *L)
     LUAX_OVERLOAD_END
 }
 
+static int source_priority_1o_1n(lua_State *L)
+{
+    LUAX_SIGNATURE_BEGIN(L)
+        LUAX_SIGNATURE_REQUIRED(LUA_TOBJECT)
+    LUAX_SIGNATURE_END
+    const Source_Object_t *self = (const Source_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_SOURCE);
+
+    lua_pushinteger(L, (lua_Integer)SL_source_get_priority(self->source));
+
+    return 1;
+}
+
+static int source_priority_2on_0(lua_State *L)
+{
+    LUAX_SIGNATURE_BEGIN(L)
+        LUAX_SIGNATURE_REQUIRED(LUA_TOBJECT)
+        LUAX_SIGNATURE_REQUIRED(LUA_TNUMBER)
+    LUAX_SIGNATURE_END
+    Source_Object_t *self = (Source_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_SOURCE);
+    size_t priority = LUAX_UNSIGNED(L, 2);
+
+    SL_source_set_priority(self->source, priority);
+
+    return 0;
+}
+
+static int source_priority_v_v(lua_State *L)
+{
+    LUAX_OVERLOAD_BEGIN(L)
+        LUAX_OVERLOAD_BY_ARITY(source_priority_1o_1n, 1)
+        LUAX_OVERLOAD_BY_ARITY(source_priority_2on_0, 2)
+    LUAX_OVERLOAD_END
+}
+
 static int source_is_playing_1o_1b(lua_State *L)
 {
     LUAX_SIGNATURE_BEGIN(L)
@@ -448,6 +525,18 @@ static int source_is_playing_1o_1b(lua_State *L)
     return 1;
 }
 
+static int source_underruns_1o_1n(lua_State *L)
+{
+    LUAX_SIGNATURE_BEGIN(L)
+        LUAX_SIGNATURE_REQUIRED(LUA_TOBJECT)
+    LUAX_SIGNATURE_END
+    const Source_Object_t *self = (const Source_Object_t *)LUAX_OBJECT(L, 1, OBJECT_TYPE_SOURCE);
+
+    lua_pushinteger(L, (lua_Integer)SL_source_get_underruns(self->source));
+
+    return 1;
+}
+
 static int source_play_1o_0(lua_State *L)
 {
     LUAX_SIGNATURE_BEGIN(L)
@@ -40,10 +40,13 @@
 #include "internal/udt.h"
 
 #include <core/config.h>
+#include <libs/stb.h>
 #include <systems/interpreter.h>
 #include <systems/storage.h>
 
 static int storage_inject_3ssS_0(lua_State *L);
+static int storage_preload_1t_0(lua_State *L);
+static int storage_progress_0_2nn(lua_State *L);
 #if !defined(TOFU_STORAGE_AUTO_COLLECT)
 static int storage_flush_0_0(lua_State *L);
 #endif  /* TOFU_STORAGE_AUTO_COLLECT */
@@ -55,6 +58,8 @@ int storage_loader(lua_State *L)
         (const struct luaL_Reg[]){
             // -- operations --
             { "inject", storage_inject_3ssS_0 },
+            { "preload", storage_preload_1t_0 },
+            { "progress", storage_progress_0_2nn },
 #if !defined(TOFU_STORAGE_AUTO_COLLECT)
             { "flush", storage_flush_0_0 },
 #endif  /* TOFU_STORAGE_AUTO_COLLECT */
@@ -105,6 +110,73 @@ static int storage_inject_3ssS_0(lua_State *L)
     return 0;
 }
 
+// Accepts a table in the form `{ ["name"] = "type", ... }`, where the type is one of `string`, `blob`, or `image`.
+static int storage_preload_1t_0(lua_State *L)
+{
+    LUAX_SIGNATURE_BEGIN(L)
+        LUAX_SIGNATURE_REQUIRED(LUA_TTABLE)
+    LUAX_SIGNATURE_END
+    // idx #1: LUA_TTABLE
+
+    Storage_t *storage = (Storage_t *)udt_get_userdata(L, USERDATA_STORAGE);
+
+    const char **names = NULL;
+    Storage_Resource_Types_t *types = NULL;
+
+    lua_pushnil(L);
+    while (lua_next(L, 1)) {
+        const char *name = LUAX_STRING(L, -2); // The table keeps the strings alive, no need to copy them.
+        const char *type = LUAX_STRING(L, -1);
+
+        Storage_Resource_Types_t resource_type;
+        if (type[0] == 's') {
+            resource_type = STORAGE_RESOURCE_STRING;
+        } else
+        if (type[0] == 'b') {
+            resource_type = STORAGE_RESOURCE_BLOB;
+        } else
+        if (type[0] == 'i') {
+            resource_type = STORAGE_RESOURCE_IMAGE;
+        } else {
+            arrfree(names);
+            arrfree(types);
+            return luaL_error(L, "unknown type `%s` for resource `%s`", type, name);
+        }
+
+        arrpush(names, name);
+        arrpush(types, resource_type);
+
+        lua_pop(L, 1);
+    }
+
+    bool preloaded = Storage_preload(storage, names, types, arrlenu(names));
+
+    arrfree(names);
+    arrfree(types);
+
+    if (!preloaded) {
+        return luaL_error(L, "can't preload resources");
+    }
+
+    return 0;
+}
+
+static int storage_progress_0_2nn(lua_State *L)
+{
+    LUAX_SIGNATURE_BEGIN(L)
+    LUAX_SIGNATURE_END
+
+    const Storage_t *storage = (const Storage_t *)udt_get_userdata(L, USERDATA_STORAGE);
+
+    size_t completed, total;
+    Storage_preload_progress(storage, &completed, &total);
+
+    lua_pushinteger(L, (lua_Integer)completed);
+    lua_pushinteger(L, (lua_Integer)total);
+
+    return 2;
+}
+
 #if !defined(TOFU_STORAGE_AUTO_COLLECT)
 static int storage_flush_0_0(lua_State *L)
 {
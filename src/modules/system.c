@@ -31,6 +31,7 @@
 #include <libs/stb.h>
 #include <libs/sysinfo.h>
 #include <systems/environment.h>
+#include <systems/storage.h>
 
 #include <time.h>
 
@@ -43,7 +44,7 @@ static int system_time_0_1n(lua_State *L);
 static int system_date_2SS_1s(lua_State *L);
 static int system_fps_0_1n(lua_State *L);
 #if defined(TOFU_ENGINE_PERFORMANCE_STATISTICS)
-static int system_stats_0_4nnnn(lua_State *L);
+static int system_stats_0_9nnnnnnnnn(lua_State *L);
 #endif  /* TOFU_ENGINE_PERFORMANCE_STATISTICS */
 #if defined(TOFU_ENGINE_HEAP_STATISTICS)
 static int system_heap_1S_1n(lua_State *L);
@@ -63,7 +64,7 @@ int system_loader(lua_State *L)
             { "date", system_date_2SS_1s },
             { "fps", system_fps_0_1n },
 #if defined(TOFU_ENGINE_PERFORMANCE_STATISTICS)
-            { "stats", system_stats_0_4nnnn },
+            { "stats", system_stats_0_9nnnnnnnnn },
 #endif  /* TOFU_ENGINE_PERFORMANCE_STATISTICS */
 #if defined(TOFU_ENGINE_HEAP_STATISTICS)
             { "heap", system_heap_1S_1n },
@@ -172,7 +173,7 @@ static int system_fps_0_1n(lua_State *L)
 }
 
 #if defined(TOFU_ENGINE_PERFORMANCE_STATISTICS)
-static int system_stats_0_4nnnn(lua_State *L)
+static int system_stats_0_9nnnnnnnnn(lua_State *L)
 {
     LUAX_SIGNATURE_BEGIN(L)
     LUAX_SIGNATURE_END
@@ -186,8 +187,16 @@ static int system_stats_0_4nnnn(lua_State *L)
     lua_pushnumber(L, (lua_Number)stats->times[2]);
     lua_pushnumber(L, (lua_Number)stats->times[3]);
     lua_pushnumber(L, (lua_Number)stats->times[4]);
+    lua_pushnumber(L, (lua_Number)stats->times[5]);
 
-    return 5;
+    const Storage_t *storage = (const Storage_t *)udt_get_userdata(L, USERDATA_STORAGE);
+
+    const Storage_Stats_t *storage_stats = Storage_get_stats(storage);
+    lua_pushinteger(L, (lua_Integer)storage_stats->hits);
+    lua_pushinteger(L, (lua_Integer)storage_stats->misses);
+    lua_pushinteger(L, (lua_Integer)storage_stats->evictions);
+
+    return 9;
 }
 #endif  /* TOFU_ENGINE_PERFORMANCE_STATISTICS */
 
@@ -27,8 +27,21 @@
 #include <core/config.h>
 #define _LOG_TAG "audio"
 #include <libs/log.h>
+#include <libs/sl/mix.h>
 #include <libs/stb.h>
 
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+// Every pending reference could turn into an event at once (e.g. on halt), so the game thread refuses to play a
+// source when the events queue would be unable to hold them all. It is sized after the context capacity (tracked
+// sources) plus the commands one (sources yet to be tracked), which is more than the game normally needs.
+#define _EVENTS_CAPACITY(a) ((a)->context->capacity + TOFU_AUDIO_COMMANDS_CAPACITY)
+
+// Time the game thread sleeps while waiting for the device to free some room in the commands queue.
+#define _POST_WAIT_NANOSECONDS  1000000L
+
 static void _log_callback(void *user_data, ma_uint32 level, const char *message)
 {
     static int _levels[] = {
@@ -69,16 +82,117 @@ static ma_bool32 _enum_callback(ma_context *context, ma_device_type device_type,
     return MA_TRUE;
 }
 
+typedef enum Audio_Command_Types_e {
+    AUDIO_COMMAND_TRACK,
+    AUDIO_COMMAND_UNTRACK,
+    AUDIO_COMMAND_HALT,
+    AUDIO_COMMAND_SET_MIX,
+    AUDIO_COMMAND_SET_GAIN
+} Audio_Command_Types_t;
+
+typedef struct Audio_Command_s {
+    Audio_Command_Types_t type;
+    union {
+        SL_Source_t *source;
+        struct {
+            size_t group_id;
+            SL_Mix_t mix;
+        } mix;
+        struct {
+            size_t group_id;
+            float gain;
+        } gain;
+    } args;
+} Audio_Command_t;
+
+// Both the queues hold fixed-size records, and their capacity is a multiple of the record size. This means that a
+// record never wraps around the end of the buffer and can be accessed in a single (contiguous) chunk.
+static bool _push(ma_rb *queue, const void *record, size_t size)
+{
+    size_t bytes = size;
+    void *buffer;
+    ma_rb_acquire_write(queue, &bytes, &buffer);
+    if (bytes < size) { // Full!
+        return false;
+    }
+    memcpy(buffer, record, size);
+    ma_rb_commit_write(queue, size);
+    return true;
+}
+
+static bool _pop(ma_rb *queue, void *record, size_t size)
+{
+    size_t bytes = size;
+    void *buffer;
+    ma_rb_acquire_read(queue, &bytes, &buffer);
+    if (bytes < size) { // Empty!
+        return false;
+    }
+    memcpy(record, buffer, size);
+    ma_rb_commit_read(queue, size);
+    return true;
+}
+
+// Notifies the game thread that the source is no longer referenced by the context. Each event matches a previous
+// `AUDIO_COMMAND_TRACK` command, and the game thread never has more tracking commands pending (i.e. not yet released)
+// than the queue can hold, so it can't overflow.
+static void _release(void *user_data, SL_Source_t *source)
+{
+    Audio_t *audio = (Audio_t *)user_data;
+
+    bool pushed = _push(&audio->queues.events, &source, sizeof(SL_Source_t *));
+    LOG_IF_E(!pushed, "can't notify release of source %p", source);
+}
+
+// Applies the pending commands to the context. This is normally performed by the device thread, at the beginning of
+// each callback, but the game thread does it on its own when the device is stopped.
+static void _consume(Audio_t *audio)
+{
+    SL_Context_t *context = audio->context;
+
+    Audio_Command_t command;
+    while (_pop(&audio->queues.commands, &command, sizeof(Audio_Command_t))) {
+        switch (command.type) {
+            case AUDIO_COMMAND_TRACK:
+                if (SL_context_is_tracked(context, command.args.source)) {
+                    _release(audio, command.args.source); // Already referenced, balance the reference count.
+                } else {
+                    SL_Source_t *dropped = SL_context_track(context, command.args.source);
+                    if (dropped) {
+                        _release(audio, dropped); // Either rejected or stolen, when the context is full.
+                    }
+                }
+                break;
+            case AUDIO_COMMAND_UNTRACK:
+                if (SL_context_is_tracked(context, command.args.source)) {
+                    SL_context_untrack(context, command.args.source);
+                    _release(audio, command.args.source);
+                }
+                break;
+            case AUDIO_COMMAND_HALT:
+                for (size_t i = 0; i < arrlenu(context->sources); ++i) {
+                    _release(audio, context->sources[i]);
+                }
+                SL_context_halt(context);
+                break;
+            case AUDIO_COMMAND_SET_MIX:
+                SL_context_set_mix(context, command.args.mix.group_id, command.args.mix.mix);
+                break;
+            case AUDIO_COMMAND_SET_GAIN:
+                SL_context_set_gain(context, command.args.gain.group_id, command.args.gain.gain);
+                break;
+        }
+    }
+}
+
 // Note that output buffer is already pre-silenced upon call.
 static void _data_callback(ma_device *device, void *output, const void *input, ma_uint32 frame_count)
 {
     Audio_t *audio = (Audio_t *)device->pUserData;
 
-    ma_mutex_lock(&audio->driver.lock);
-//    ma_silence_pcm_frames(output, frame_count, ma_format_s16, SL_CHANNELS_PER_FRAME);
+    _consume(audio); // No lock is taken, the game thread never waits on the device one (and vice versa).
 //    LOG_T("%d frames requested for device %p", frame_count, device);
-    SL_context_generate(audio->context, output, frame_count);
-    ma_mutex_unlock(&audio->driver.lock);
+    SL_context_generate(audio->context, output, frame_count, _release, audio);
 }
 
 static void _notification_callback(const ma_device_notification *notification)
@@ -109,6 +223,77 @@ static void  _free(void *ptr, void *pUserData)
     free(ptr);
 }
 
+static inline ptrdiff_t _find(SL_Source_t **sources, const SL_Source_t *source)
+{
+    for (size_t i = 0; i < arrlenu(sources); ++i) {
+        if (sources[i] == source) {
+            return (ptrdiff_t)i;
+        }
+    }
+    return -1;
+}
+
+static inline void _forget(SL_Source_t **sources, const SL_Source_t *source)
+{
+    ptrdiff_t index = _find(sources, source);
+    if (index != -1) {
+        arrdelswap(sources, index);
+    }
+}
+
+// The decoder thread owns the production of the sources data, decoupling it from the game-loop pace. The active
+// sources are copied while holding the lock, and decoded w/o it so that the game thread never waits for a decoding
+// pass. The one being decoded is marked as `current`, the game thread waits only when resetting or destroying it.
+static void *_decoder(void *arg)
+{
+    Audio_t *audio = (Audio_t *)arg;
+
+    const long period = (long)(TOFU_AUDIO_DECODER_PERIOD * 1000000000.0);
+
+    SL_Source_t **batch = NULL;
+
+    pthread_mutex_lock(&audio->decoder.lock);
+    while (!audio->decoder.quit) {
+        size_t count = arrlenu(audio->sources);
+        arrsetlen(batch, count);
+        if (count > 0) {
+            memcpy(batch, audio->sources, sizeof(SL_Source_t *) * count);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            SL_Source_t *source = batch[i];
+            if (_find(audio->sources, source) == -1 || _find(audio->decoder.failures, source) != -1) {
+                continue; // Untracked in the meanwhile, or already failed.
+            }
+
+            audio->decoder.current = source;
+            pthread_mutex_unlock(&audio->decoder.lock);
+            bool updated = SL_source_update(source, (float)TOFU_AUDIO_DECODER_PERIOD);
+            pthread_mutex_lock(&audio->decoder.lock);
+            audio->decoder.current = NULL;
+            pthread_cond_broadcast(&audio->decoder.idle);
+
+            if (!updated) {
+                arrpush(audio->decoder.failures, source);
+            }
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += period;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&audio->decoder.wake, &audio->decoder.lock, &deadline); // Releases the lock while waiting.
+    }
+    pthread_mutex_unlock(&audio->decoder.lock);
+
+    arrfree(batch);
+
+    return NULL;
+}
+
 Audio_t *Audio_create(const Audio_Configuration_t *configuration)
 {
     Audio_t *audio = malloc(sizeof(Audio_t));
@@ -121,19 +306,49 @@ Audio_t *Audio_create(const Audio_Configuration_t *configuration)
             .configuration = *configuration
         };
 
-    audio->context = SL_context_create();
+    sh_new_strdup(audio->pcms); // Names are transient, the map needs to own a copy of them.
+
+    audio->context = SL_context_create(configuration->voices, configuration->sources);
     if (!audio->context) {
         LOG_F("can't create the sound context");
         goto error_free_audio;
     }
     LOG_D("sound context created at %p", audio->context);
 
-    ma_result result = ma_mutex_init(&audio->driver.lock);
+    memcpy(audio->groups, audio->context->groups, sizeof(SL_Group_t) * SL_GROUPS_AMOUNT); // Start in sync w/ the context.
+
+    arrsetcap(audio->samples, TOFU_AUDIO_SAMPLES_POOL_SIZE); // Never grows past this, no reallocation when recycling.
+    for (size_t i = 0; i < TOFU_AUDIO_SAMPLES_POOL_SIZE; ++i) {
+        SL_Source_t *sample = SL_sample_create(audio->context, NULL);
+        if (!sample) {
+            LOG_F("can't create the samples pool");
+            goto error_destroy_samples;
+        }
+        arrpush(audio->samples, sample);
+    }
+    LOG_D("samples pool created w/ %d entries", TOFU_AUDIO_SAMPLES_POOL_SIZE);
+
+    ma_result result = ma_rb_init(TOFU_AUDIO_COMMANDS_CAPACITY * sizeof(Audio_Command_t), NULL, &(ma_allocation_callbacks){
+            .pUserData = NULL,
+            .onMalloc = _malloc,
+            .onRealloc = _realloc,
+            .onFree = _free
+        }, &audio->queues.commands);
+    if (result != MA_SUCCESS) {
+        LOG_F("can't create the commands queue");
+        goto error_destroy_samples;
+    }
+    result = ma_rb_init(_EVENTS_CAPACITY(audio) * sizeof(SL_Source_t *), NULL, &(ma_allocation_callbacks){
+            .pUserData = NULL,
+            .onMalloc = _malloc,
+            .onRealloc = _realloc,
+            .onFree = _free
+        }, &audio->queues.events);
     if (result != MA_SUCCESS) {
-        LOG_F("can't create the synchronization object");
-        goto error_destroy_context;
+        LOG_F("can't create the events queue");
+        goto error_deinitialize_commands;
     }
-    LOG_D("audio device mutex initialized");
+    LOG_D("audio queues initialized w/ %d commands and %d events capacity", TOFU_AUDIO_COMMANDS_CAPACITY, _EVENTS_CAPACITY(audio));
 
     ma_log_init(&(ma_allocation_callbacks){
             .pUserData = NULL,
@@ -145,7 +360,7 @@ Audio_t *Audio_create(const Audio_Configuration_t *configuration)
     result = ma_log_register_callback(&audio->driver.log, log_callback);
     if (result != MA_SUCCESS) {
         LOG_F("can't initialize logging");
-        goto error_deinitialize_mutex;
+        goto error_deinitialize_events;
     }
 
     ma_context_config context_config = ma_context_config_init();
@@ -191,7 +406,7 @@ Audio_t *Audio_create(const Audio_Configuration_t *configuration)
     device_config.dataCallback              = _data_callback;
     device_config.notificationCallback      = _notification_callback;
     device_config.pUserData                 = (void *)audio;
-    device_config.noPreSilencedOutputBuffer = MA_FALSE; // We require pre-silenced buffers as we mix incrementally.
+    device_config.noPreSilencedOutputBuffer = MA_TRUE; // We mix into our own bus, the output is entirely overwritten.
 
     result = ma_device_init(&audio->driver.context, &device_config, &audio->driver.device);
     if (result != MA_SUCCESS) {
@@ -219,15 +434,36 @@ Audio_t *Audio_create(const Audio_Configuration_t *configuration)
     LOG_I("sample-rate: %d / %d", audio->driver.device.sampleRate, audio->driver.device.playback.internalSampleRate);
     LOG_I("period-in-frames: %d", audio->driver.device.playback.internalPeriodSizeInFrames);
 
+    pthread_mutex_init(&audio->decoder.lock, NULL);
+    pthread_cond_init(&audio->decoder.wake, NULL);
+    pthread_cond_init(&audio->decoder.idle, NULL);
+
+    if (pthread_create(&audio->decoder.thread, NULL, _decoder, audio) != 0) {
+        LOG_F("can't create the decoder thread");
+        goto error_destroy_decoder;
+    }
+    LOG_D("decoder thread created w/ a %.3fs period", TOFU_AUDIO_DECODER_PERIOD);
+
     return audio;
 
+error_destroy_decoder:
+    pthread_cond_destroy(&audio->decoder.idle);
+    pthread_cond_destroy(&audio->decoder.wake);
+    pthread_mutex_destroy(&audio->decoder.lock);
+    ma_device_uninit(&audio->driver.device);
 error_deinitialize_context:
     ma_context_uninit(&audio->driver.context);
 error_deinitialize_log:
     ma_log_uninit(&audio->driver.log);
-error_deinitialize_mutex:
-    ma_mutex_uninit(&audio->driver.lock);
-error_destroy_context:
+error_deinitialize_events:
+    ma_rb_uninit(&audio->queues.events);
+error_deinitialize_commands:
+    ma_rb_uninit(&audio->queues.commands);
+error_destroy_samples:
+    for (size_t i = 0; i < arrlenu(audio->samples); ++i) {
+        SL_source_destroy(audio->samples[i]);
+    }
+    arrfree(audio->samples);
     SL_context_destroy(audio->context);
 error_free_audio:
     free(audio);
@@ -243,12 +479,49 @@ error_exit:
 
 void Audio_destroy(Audio_t *audio)
 {
+    pthread_mutex_lock(&audio->decoder.lock);
+    audio->decoder.quit = true;
+    pthread_cond_signal(&audio->decoder.wake);
+    pthread_mutex_unlock(&audio->decoder.lock);
+    pthread_join(audio->decoder.thread, NULL);
+    pthread_cond_destroy(&audio->decoder.idle);
+    pthread_cond_destroy(&audio->decoder.wake);
+    pthread_mutex_destroy(&audio->decoder.lock);
+    arrfree(audio->decoder.failures);
+    LOG_D("decoder thread stopped");
+
     ma_device_uninit(&audio->driver.device); // Device is automatically stopped on deinitialization.
     ma_context_uninit(&audio->driver.context);
     ma_log_uninit(&audio->driver.log);
-    ma_mutex_uninit(&audio->driver.lock);
     LOG_D("audio uninitialized");
 
+    // The device thread is gone, so the sources still pending their release can be safely destroyed.
+    SL_Source_t **current = audio->discarded;
+    for (size_t count = arrlenu(audio->discarded); count; --count) {
+        SL_source_destroy(*(current++));
+    }
+    arrfree(audio->discarded);
+    current = audio->samples;
+    for (size_t count = arrlenu(audio->samples); count; --count) {
+        SL_source_destroy(*(current++));
+    }
+    arrfree(audio->samples);
+    arrfree(audio->restarts);
+    arrfree(audio->sources);
+    hmfree(audio->references);
+    LOG_D("audio sources freed");
+
+    Audio_Pcm_Entry_t *entry = audio->pcms;
+    for (size_t count = shlenu(audio->pcms); count; --count) {
+        SL_pcm_release((entry++)->value);
+    }
+    shfree(audio->pcms);
+    LOG_D("audio samples cache freed");
+
+    ma_rb_uninit(&audio->queues.events);
+    ma_rb_uninit(&audio->queues.commands);
+    LOG_D("audio queues uninitialized");
+
     SL_context_destroy(audio->context);
     LOG_D("sound context destroyed");
 
@@ -256,122 +529,332 @@ void Audio_destroy(Audio_t *audio)
     LOG_D("audio freed");
 }
 
+// The game thread waits for the device one only when the queue is full, which means the device is lagging way behind.
+static void _post(Audio_t *audio, Audio_Command_t command)
+{
+    if (_push(&audio->queues.commands, &command, sizeof(Audio_Command_t))) {
+        return;
+    }
+
+    LOG_W("commands queue is full, waiting for the device");
+    while (!_push(&audio->queues.commands, &command, sizeof(Audio_Command_t))) {
+        if (!ma_device_is_started(&audio->driver.device)) { // No one to wait for, apply them on our own.
+            _consume(audio);
+        } else {
+            nanosleep(&(struct timespec){ .tv_sec = 0, .tv_nsec = _POST_WAIT_NANOSECONDS }, NULL); // Don't hog the CPU.
+        }
+    }
+}
+
+// Waits for the decoder thread to be done w/ the source, should it be decoding it right now. The source must be no
+// longer active, so that the decoder won't pick it again.
+static void _settle(Audio_t *audio, const SL_Source_t *source)
+{
+    pthread_mutex_lock(&audio->decoder.lock);
+    while (audio->decoder.current == source) {
+        pthread_cond_wait(&audio->decoder.idle, &audio->decoder.lock);
+    }
+    pthread_mutex_unlock(&audio->decoder.lock);
+}
+
+// Samples are put back into the pool (releasing their data), while there's room for them.
+static void _dispose(Audio_t *audio, SL_Source_t *source)
+{
+    _settle(audio, source);
+
+    if (SL_source_is_sample(source) && arrlenu(audio->samples) < TOFU_AUDIO_SAMPLES_POOL_SIZE) {
+        SL_sample_unbind(source);
+        arrpush(audio->samples, source);
+        LOG_D("sample %p recycled", source);
+        return;
+    }
+
+    SL_source_destroy(source);
+    LOG_D("source %p destroyed", source);
+}
+
+static inline size_t _references(Audio_t *audio, SL_Source_t *source)
+{
+    return hmget(audio->references, source); // Defaults to zero when missing.
+}
+
+static inline void _reference(Audio_t *audio, SL_Source_t *source)
+{
+    size_t references = _references(audio, source) + 1; // Can't be inlined in `hmput()`, it would corrupt the map.
+    hmput(audio->references, source, references);
+    audio->pending += 1;
+}
+
+// Resetting implies decoding, and it's done on the game thread only when the device isn't referencing the source.
+static void _play(Audio_t *audio, SL_Source_t *source, bool reset)
+{
+    if (audio->pending == _EVENTS_CAPACITY(audio)) { // The device could release them all at once, refuse to overflow.
+        LOG_W("too many sources pending release, can't play source %p", source);
+        return;
+    }
+
+    if (reset) { // Not active, but the decoder could be still finishing a pass on it.
+        _settle(audio, source);
+        bool success = SL_source_reset(source);
+        LOG_IF_W(!success, "can't reset source %p", source);
+    }
+
+    pthread_mutex_lock(&audio->decoder.lock);
+    arrpush(audio->sources, source);
+    pthread_cond_signal(&audio->decoder.wake); // Fill the buffers as soon as possible.
+    pthread_mutex_unlock(&audio->decoder.lock);
+
+    _reference(audio, source);
+    _post(audio, (Audio_Command_t){ .type = AUDIO_COMMAND_TRACK, .args.source = source });
+}
+
+static void _collect(Audio_t *audio)
+{
+    SL_Source_t *source;
+    while (_pop(&audio->queues.events, &source, sizeof(SL_Source_t *))) {
+        audio->pending -= 1;
+
+        size_t references = _references(audio, source) - 1;
+        if (references > 0) {
+            hmput(audio->references, source, references);
+            continue;
+        }
+        (void)hmdel(audio->references, source);
+
+        pthread_mutex_lock(&audio->decoder.lock);
+        _forget(audio->sources, source); // Completed (if not already untracked).
+        pthread_mutex_unlock(&audio->decoder.lock);
+
+        ptrdiff_t index = _find(audio->restarts, source);
+        if (index != -1) {
+            arrdelswap(audio->restarts, index);
+            _play(audio, source, true);
+            continue;
+        }
+
+        index = _find(audio->discarded, source);
+        if (index != -1) {
+            arrdelswap(audio->discarded, index);
+            _dispose(audio, source);
+        }
+    }
+}
+
 void Audio_halt(Audio_t *audio)
 {
-    ma_mutex_lock(&audio->driver.lock);
-    SL_context_halt(audio->context);
+    static const size_t zero = 0;
+    pthread_mutex_lock(&audio->decoder.lock);
+    arrsetlen(audio->sources, zero);
+    pthread_mutex_unlock(&audio->decoder.lock);
+    arrsetlen(audio->restarts, zero);
+    _post(audio, (Audio_Command_t){ .type = AUDIO_COMMAND_HALT });
     LOG_D("halted, no more sources active");
-    ma_mutex_unlock(&audio->driver.lock);
 }
 
 void Audio_set_volume(Audio_t *audio, float volume)
 {
-//    ma_mutex_lock(&audio->driver.lock);
     ma_device_set_master_volume(&audio->driver.device, volume);
-//    ma_mutex_unlock(&audio->driver.lock);
 }
 
 void Audio_set_mix(Audio_t *audio, size_t group_id, SL_Mix_t mix)
 {
-    ma_mutex_lock(&audio->driver.lock);
-    SL_context_set_mix(audio->context, group_id, mix);
-    ma_mutex_unlock(&audio->driver.lock);
+    audio->groups[group_id].mix = mix;
+    _post(audio, (Audio_Command_t){ .type = AUDIO_COMMAND_SET_MIX, .args.mix = { .group_id = group_id, .mix = mix } });
 }
 
 void Audio_set_pan(Audio_t *audio, size_t group_id, float pan)
 {
-    ma_mutex_lock(&audio->driver.lock);
-    SL_context_set_pan(audio->context, group_id, pan);
-    ma_mutex_unlock(&audio->driver.lock);
+    Audio_set_mix(audio, group_id, mix_pan(fmaxf(-1.0f, fminf(pan, 1.0f))));
 }
 
 void Audio_set_balance(Audio_t *audio, size_t group_id, float balance)
 {
-    ma_mutex_lock(&audio->driver.lock);
-    SL_context_set_balance(audio->context, group_id, balance);
-    ma_mutex_unlock(&audio->driver.lock);
+    Audio_set_mix(audio, group_id, mix_balance(fmaxf(-1.0f, fminf(balance, 1.0f))));
 }
 
 void Audio_set_gain(Audio_t *audio, size_t group_id, float gain)
 {
-    ma_mutex_lock(&audio->driver.lock);
-    SL_context_set_gain(audio->context, group_id, gain);
-    ma_mutex_unlock(&audio->driver.lock);
+    audio->groups[group_id].gain = fmaxf(0.0f, gain);
+    _post(audio, (Audio_Command_t){ .type = AUDIO_COMMAND_SET_GAIN, .args.gain = { .group_id = group_id, .gain = audio->groups[group_id].gain } });
 }
 
 float Audio_get_volume(const Audio_t *audio)
 {
-//    ma_mutex_lock(&audio->driver.lock);
     float volume;
     ma_result result = ma_device_get_master_volume((ma_device *)&audio->driver.device, &volume);
     if (result != MA_SUCCESS) {
         return 0.0f;
     }
     return volume;
-//    ma_mutex_unlock(&audio->driver.lock);
 }
 
 SL_Mix_t Audio_get_mix(const Audio_t *audio, size_t group_id)
 {
-    ma_mutex_lock((ma_mutex *)&audio->driver.lock);
-    SL_Mix_t mix = SL_context_get_group(audio->context, group_id)->mix;
-    ma_mutex_unlock((ma_mutex *)&audio->driver.lock);
-    return mix;
+    return audio->groups[group_id].mix;
 }
 
 float Audio_get_gain(const Audio_t *audio, size_t group_id)
 {
-    ma_mutex_lock((ma_mutex *)&audio->driver.lock);
-    float gain = SL_context_get_group(audio->context, group_id)->gain;
-    ma_mutex_unlock((ma_mutex *)&audio->driver.lock);
-    return gain;
+    return audio->groups[group_id].gain;
 }
 
 void Audio_track(Audio_t *audio, SL_Source_t *source, bool reset)
 {
-    ma_mutex_lock(&audio->driver.lock);
-    if (reset) {
-        bool success = SL_source_reset(source);
-        LOG_IF_W(!success, "can't reset source %p", source);
+    if (_find(audio->restarts, source) != -1) { // Already restarting, nothing to do.
+        return;
+    }
+
+    const bool is_tracked = _find(audio->sources, source) != -1;
+    if (is_tracked && !reset) {
+        return;
+    }
+
+    if (_references(audio, source) == 0) {
+        _play(audio, source, reset);
+        return;
+    }
+
+    // The device could be still mixing the source, so we need to wait for it to be released before resetting it.
+    if (is_tracked) {
+        pthread_mutex_lock(&audio->decoder.lock);
+        _forget(audio->sources, source);
+        pthread_mutex_unlock(&audio->decoder.lock);
+        _post(audio, (Audio_Command_t){ .type = AUDIO_COMMAND_UNTRACK, .args.source = source });
     }
-    if (!SL_context_is_tracked(audio->context, source)) {
-        SL_context_track(audio->context, source);
+    if (reset) {
+        arrpush(audio->restarts, source);
+    } else {
+        _play(audio, source, false);
     }
-    ma_mutex_unlock(&audio->driver.lock);
 }
 
 void Audio_untrack(Audio_t *audio, SL_Source_t *source)
 {
-    ma_mutex_lock(&audio->driver.lock);
-    if (SL_context_is_tracked(audio->context, source)) {
-        SL_context_untrack(audio->context, source);
+    _forget(audio->restarts, source);
+
+    if (_find(audio->sources, source) == -1) {
+        return;
     }
-    ma_mutex_unlock(&audio->driver.lock);
+    pthread_mutex_lock(&audio->decoder.lock);
+    _forget(audio->sources, source);
+    pthread_mutex_unlock(&audio->decoder.lock);
+    _post(audio, (Audio_Command_t){ .type = AUDIO_COMMAND_UNTRACK, .args.source = source });
 }
 
 bool Audio_is_tracked(const Audio_t *audio, SL_Source_t *source)
 {
-    ma_mutex_lock((ma_mutex *)&audio->driver.lock);
-    bool is_tracked = SL_context_is_tracked(audio->context, source);
-    ma_mutex_unlock((ma_mutex *)&audio->driver.lock);
-    return is_tracked;
+    return _find(audio->sources, source) != -1 || _find(audio->restarts, source) != -1;
+}
+
+void Audio_discard(Audio_t *audio, SL_Source_t *source)
+{
+    Audio_untrack(audio, source);
+
+    if (_references(audio, source) > 0) {
+        arrpush(audio->discarded, source);
+        LOG_D("source %p discarded, waiting for release", source);
+        return;
+    }
+
+    _dispose(audio, source);
+}
+
+SL_Pcm_t *Audio_get_pcm(Audio_t *audio, const char *name)
+{
+    ptrdiff_t index = shgeti(audio->pcms, name);
+    if (index == -1) {
+        return NULL;
+    }
+    Audio_Pcm_Entry_t *entry = &audio->pcms[index];
+    entry->idle = 0.0f;
+    LOG_T("PCM %p found in cache for `%s`", entry->value, name);
+    return entry->value;
+}
+
+void Audio_cache_pcm(Audio_t *audio, const char *name, SL_Pcm_t *pcm)
+{
+    Audio_forget_pcm(audio, name); // Replace the previous data, if any (samples still using it keep it alive).
+    shputs(audio->pcms, ((Audio_Pcm_Entry_t){ .key = (char *)name, .value = pcm, .idle = 0.0f }));
+    LOG_D("PCM %p cached for `%s`", pcm, name);
+}
+
+void Audio_forget_pcm(Audio_t *audio, const char *name)
+{
+    if (!name) {
+        for (ptrdiff_t index = shlen(audio->pcms) - 1; index >= 0; --index) {
+            Audio_forget_pcm(audio, audio->pcms[index].key);
+        }
+        return;
+    }
+
+    ptrdiff_t index = shgeti(audio->pcms, name);
+    if (index == -1) {
+        return;
+    }
+    SL_pcm_release(audio->pcms[index].value);
+    (void)shdel(audio->pcms, name);
+    LOG_D("PCM for `%s` removed from cache", name);
+}
+
+SL_Source_t *Audio_create_sample(Audio_t *audio, SL_Pcm_t *pcm)
+{
+    if (arrlenu(audio->samples) == 0) {
+        LOG_W("samples pool depleted, allocating a new sample");
+        return SL_sample_create(audio->context, pcm);
+    }
+
+    SL_Source_t *sample = arrpop(audio->samples);
+    SL_sample_bind(sample, pcm);
+    LOG_D("sample %p recycled from pool (%d left)", sample, arrlenu(audio->samples));
+    return sample;
+}
+
+// Releases the cached data that no sample has been using for a while.
+static void _age(Audio_t *audio, float delta_time)
+{
+    // Backward scan, as deleting an entry moves the last one in its place.
+    for (ptrdiff_t index = shlen(audio->pcms) - 1; index >= 0; --index) {
+        Audio_Pcm_Entry_t *entry = &audio->pcms[index];
+        if (entry->value->references > 1) { // Still shared w/ some sample.
+            entry->idle = 0.0f;
+            continue;
+        }
+        entry->idle += delta_time;
+        if (entry->idle < TOFU_AUDIO_SAMPLES_CACHE_TIMEOUT) {
+            continue;
+        }
+        LOG_D("PCM for `%s` unused for %.2fs, releasing", entry->key, entry->idle);
+        SL_pcm_release(entry->value);
+        (void)shdel(audio->pcms, entry->key);
+    }
 }
 
 bool Audio_update(Audio_t *audio, float delta_time)
 {
-    ma_mutex_lock(&audio->driver.lock);
-    bool updated = SL_context_update(audio->context, delta_time);
 #if defined(TOFU_AUDIO_AUTOSTART)
-    size_t count = SL_context_count_tracked(audio->context);
-#endif
-    ma_mutex_unlock(&audio->driver.lock);
-
-    if (!updated) {
-        LOG_E("can't update context");
-        return false;
+    if (!ma_device_is_started(&audio->driver.device)) { // The callback isn't running, we can safely act as the device.
+        _consume(audio);
     }
+#endif  /* TOFU_AUDIO_AUTOSTART */
+    _collect(audio);
+
+    // Decoding is performed by the decoder thread, we only need to dismiss the sources it failed to update.
+    pthread_mutex_lock(&audio->decoder.lock);
+    SL_Source_t **current = audio->decoder.failures;
+    for (size_t count = arrlenu(audio->decoder.failures); count; --count) {
+        SL_Source_t *source = *(current++);
+        LOG_E("can't update source %p, untracking", source);
+        _forget(audio->sources, source);
+        _post(audio, (Audio_Command_t){ .type = AUDIO_COMMAND_UNTRACK, .args.source = source });
+    }
+    static const size_t zero = 0;
+    arrsetlen(audio->decoder.failures, zero);
+    pthread_mutex_unlock(&audio->decoder.lock);
+
+    _age(audio, delta_time);
 
 #if defined(TOFU_AUDIO_AUTOSTART)
+    size_t count = arrlenu(audio->sources) + arrlenu(audio->restarts);
     const bool is_started = ma_device_is_started(&audio->driver.device);
     if (count == 0 && is_started) {
         audio->grace -= delta_time;
@@ -42,13 +42,27 @@
 #include <libs/sl/sl.h>
 #include <libs/dr_libs.h>
 
+#include <pthread.h>
 #include <stdbool.h>
 
 typedef struct Audio_Configuration_s {
     int device_index;
     float master_volume;
+    size_t voices;
+    size_t sources;
 } Audio_Configuration_t;
 
+typedef struct Audio_Reference_s {
+    SL_Source_t *key;
+    size_t value; // Pending references, i.e. the device could be still mixing the source until it drops to zero.
+} Audio_Reference_t;
+
+typedef struct Audio_Pcm_Entry_s {
+    char *key;
+    SL_Pcm_t *value; // The cache holds a reference to the data.
+    float idle; // Time elapsed since the data is no longer referenced by any sample.
+} Audio_Pcm_Entry_t;
+
 typedef struct Audio_s {
     Audio_Configuration_t configuration;
 
@@ -56,12 +70,35 @@ typedef struct Audio_s {
         ma_log log;
         ma_context context;
         ma_device device;
-        ma_mutex lock;
     } driver;
 
-    // TODO: should the audio voices be limited?
+    SL_Context_t *context; // Owned by the device thread, once created.
+
+    struct {
+        ma_rb commands; // From the game to the device thread...
+        ma_rb events; // ... and back, to notify when a source is no longer referenced.
+    } queues;
 
-    SL_Context_t *context;
+    struct {
+        pthread_t thread;
+        pthread_mutex_t lock; // Guards the `sources` array and the `current` source (not the decoding itself).
+        pthread_cond_t wake;
+        pthread_cond_t idle; // Signalled when the decoder is done w/ the current source.
+        bool quit;
+        const SL_Source_t *current; // Being decoded right now, w/o holding the lock.
+        SL_Source_t **failures; // Sources that can't be updated, untracked on the next (game-thread) update.
+    } decoder;
+
+    // Game-thread side state, mirroring (w/ a short delay) the one of the context.
+    SL_Group_t groups[SL_GROUPS_AMOUNT];
+    SL_Source_t **sources; // Active sources, updated (i.e. decoded) by the decoder thread.
+    Audio_Reference_t *references;
+    size_t pending; // Total of the references, bounded so that the events queue can't overflow.
+    SL_Source_t **restarts; // To be reset and tracked again, as soon as the device releases them.
+    SL_Source_t **discarded; // To be destroyed, as soon as the device releases them.
+
+    Audio_Pcm_Entry_t *pcms; // Decoded samples data, by resource name.
+    SL_Source_t **samples; // Unbound samples, ready to be recycled.
 
 #if defined(TOFU_AUDIO_AUTOSTART)
     double grace;
@@ -87,6 +124,13 @@ extern float Audio_get_gain(const Audio_t *audio, size_t group_id);
 extern void Audio_track(Audio_t *audio, SL_Source_t *source, bool reset);
 extern void Audio_untrack(Audio_t *audio, SL_Source_t *source);
 extern bool Audio_is_tracked(const Audio_t *audio, SL_Source_t *source);
+extern void Audio_discard(Audio_t *audio, SL_Source_t *source); // Untracks and (eventually) destroys the source.
+
+// The decoded samples data are cached by resource name, so that they are decoded once and shared.
+extern SL_Pcm_t *Audio_get_pcm(Audio_t *audio, const char *name); // The returned data is not acquired.
+extern void Audio_cache_pcm(Audio_t *audio, const char *name, SL_Pcm_t *pcm); // Takes over the data reference.
+extern void Audio_forget_pcm(Audio_t *audio, const char *name); // A `NULL` name forgets all of them.
+extern SL_Source_t *Audio_create_sample(Audio_t *audio, SL_Pcm_t *pcm); // Recycled from the pool, when available.
 
 extern bool Audio_update(Audio_t *audio, float delta_time);
 
@@ -30,6 +30,7 @@
 #include <libs/log.h>
 #include <libs/imath.h>
 #include <libs/stb.h>
+#include <libs/stopwatch.h>
 
 #include <time.h>
 
@@ -516,6 +517,83 @@ error_exit:
     return false;
 }
 
+// The pixel-buffers are used in a round-robin fashion, so that the driver can still be transferring the previous
+// frame(s) when we are writing the current one. OpenGL ES 2.0 doesn't support them, so the upload is synchronous.
+static bool _initialize_buffers(Display_t *display, size_t count)
+{
+#if defined(TOFU_ENGINE_OPENGL_ES)
+    if (count > 0) {
+        LOG_W("pixel-buffers are not supported, using synchronous upload");
+    }
+    return true;
+#else
+    if (count == 0) {
+        return true;
+    }
+    if (count > DISPLAY_MAX_PIXEL_BUFFERS) {
+        LOG_W("too many pixel-buffers, clamping to %d", DISPLAY_MAX_PIXEL_BUFFERS);
+        count = DISPLAY_MAX_PIXEL_BUFFERS;
+    }
+
+    GLuint *ids = display->vram.buffers.ids;
+    glGenBuffers((GLsizei)count, ids);
+    for (size_t i = 0; i < count; ++i) {
+        if (ids[i] == 0) {
+            glDeleteBuffers((GLsizei)count, ids);
+            return false;
+        }
+    }
+
+    const GLsizeiptr size = (GLsizeiptr)(sizeof(GL_Color_t) * display->canvas.size.width * display->canvas.size.height);
+    for (size_t i = 0; i < count; ++i) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ids[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW); // Create the storage.
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    display->vram.buffers.count = count;
+    display->vram.buffers.index = 0;
+
+    return true;
+#endif  /* TOFU_ENGINE_OPENGL_ES */
+}
+
+static void _deinitialize_buffers(Display_t *display)
+{
+#if !defined(TOFU_ENGINE_OPENGL_ES)
+    if (display->vram.buffers.count > 0) {
+        glDeleteBuffers((GLsizei)display->vram.buffers.count, display->vram.buffers.ids);
+    }
+#endif  /* TOFU_ENGINE_OPENGL_ES */
+    display->vram.buffers.count = 0;
+}
+
+// Maps the next pixel-buffer of the ring, which is left bound. The previous content is invalidated so that the driver
+// doesn't need to synchronize with a pending transfer. Returns `NULL` when no pixel-buffers are in use.
+static GL_Color_t *_map_buffer(Display_t *display)
+{
+#if defined(TOFU_ENGINE_OPENGL_ES)
+    (void)display;
+    return NULL;
+#else
+    if (display->vram.buffers.count == 0) {
+        return NULL;
+    }
+
+    const GLuint id = display->vram.buffers.ids[display->vram.buffers.index];
+    display->vram.buffers.index = (display->vram.buffers.index + 1) % display->vram.buffers.count;
+
+    const GLsizeiptr size = (GLsizeiptr)(sizeof(GL_Color_t) * display->canvas.size.width * display->canvas.size.height);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, id);
+    GL_Color_t *pixels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!pixels) {
+        LOG_W("can't map pixel-buffer #%d", id);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    return pixels;
+#endif  /* TOFU_ENGINE_OPENGL_ES */
+}
+
 Display_t *Display_create(const Display_Configuration_t *configuration)
 {
     Display_t *display = malloc(sizeof(Display_t));
@@ -581,18 +659,34 @@ Display_t *Display_create(const Display_Configuration_t *configuration)
     GL_surface_clear(display->canvas.surface, 0);
     LOG_D("graphics surface %p cleared", display->canvas.surface);
 
-    display->canvas.processor = GL_processor_create();
+#if defined(TOFU_GRAPHICS_DIRTY_TRACKING)
+    bool tracked = GL_surface_track(display->canvas.surface);
+    if (!tracked) {
+        LOG_F("can't track graphics surface");
+        goto error_destroy_surface;
+    }
+    LOG_D("graphics surface %p tracked", display->canvas.surface);
+#endif  /* TOFU_GRAPHICS_DIRTY_TRACKING */
+
+    display->canvas.processor = GL_processor_create(display->canvas.size.width, display->canvas.size.height);
     if (!display->canvas.processor) {
         LOG_F("can't create processor");
         goto error_destroy_surface;
     }
     LOG_D("processor %p created", display->canvas.processor);
 
+    display->workers = Workers_create(configuration->workers);
+    if (!display->workers) {
+        LOG_F("can't create workers");
+        goto error_destroy_processor;
+    }
+    LOG_D("workers %p created", display->workers);
+
     size_t size = sizeof(GL_Color_t) * display->canvas.size.width * display->canvas.size.height;
     display->vram.pixels = malloc(size);
     if (!display->vram.pixels) {
         LOG_F("can't allocate VRAM buffer");
-        goto error_destroy_processor;
+        goto error_destroy_workers;
     }
     LOG_D("%d bytes VRAM allocated at %p (%dx%d)", size, display->vram.pixels, display->canvas.size.width, display->canvas.size.height);
 
@@ -625,6 +719,14 @@ Display_t *Display_create(const Display_Configuration_t *configuration)
         goto error_destroy_shader;
     }
 
+    bool buffers = _initialize_buffers(display, configuration->pixel_buffers);
+    if (!buffers) {
+        LOG_W("can't initialize pixel-buffers, using synchronous upload");
+    } else
+    if (display->vram.buffers.count > 0) {
+        LOG_D("%d pixel-buffer(s) created", display->vram.buffers.count);
+    }
+
     LOG_I("GLFW: %s", glfwGetVersionString());
     LOG_I("GLFW platform: %d", glfwGetPlatform());
 #if !defined(GLAD_OPTION_GL_ON_DEMAND)
@@ -647,6 +749,8 @@ error_delete_buffers:
     glDeleteBuffers(1, &display->vram.texture);
 error_free_vram:
     free(display->vram.pixels);
+error_destroy_workers:
+    Workers_destroy(display->workers);
 error_destroy_processor:
     GL_processor_destroy(display->canvas.processor);
 error_destroy_surface:
@@ -670,12 +774,26 @@ void Display_destroy(Display_t *display)
     shader_destroy(display->shader);
     LOG_D("shader %p destroyed", display->shader);
 
+    _deinitialize_buffers(display);
+    LOG_D("pixel-buffers deleted");
+
     glDeleteBuffers(1, &display->vram.texture);
     LOG_D("texture w/ id #%d deleted", display->vram.texture);
 
     free(display->vram.pixels);
     LOG_D("VRAM buffer %p freed", display->vram.pixels);
 
+    arrfree(display->vram.areas);
+    LOG_D("VRAM areas freed");
+
+    Workers_destroy(display->workers);
+    LOG_D("workers %p destroyed", display->workers);
+
+    if (display->canvas.matcher) {
+        GL_matcher_destroy(display->canvas.matcher);
+        LOG_D("matcher %p destroyed", display->canvas.matcher);
+    }
+
     GL_processor_destroy(display->canvas.processor);
     LOG_D("processor %p destroyed", display->canvas.processor);
 
@@ -725,17 +843,76 @@ bool Display_update(Display_t *display, float delta_time)
     return true;
 }
 
-void Display_present(const Display_t *display)
+// Collects the dirty areas of the canvas as horizontal runs of touched tiles, one tiles-row at a time.
+//
+// OpenGL ES 2.0 lacks `GL_UNPACK_ROW_LENGTH`, so sub-rectangles can't be uploaded from the VRAM buffer. In that case
+// the run spans the whole tiles-row, which is contiguous in memory.
+static void _collect_areas(Display_t *display)
+{
+    const GL_Surface_t *surface = display->canvas.surface;
+
+    static const size_t zero = 0;
+    arrsetlen(display->vram.areas, zero);
+
+    const size_t columns = surface->dirty.columns;
+    const size_t rows = surface->dirty.rows;
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t c = 0; c < columns; ++c) {
+            if (!GL_surface_is_touched(surface, c, r)) {
+                continue;
+            }
+#if defined(TOFU_ENGINE_OPENGL_ES)
+            const size_t c0 = 0;
+            c = columns - 1;
+#else
+            const size_t c0 = c;
+            while (c + 1 < columns && GL_surface_is_touched(surface, c + 1, r)) {
+                ++c;
+            }
+#endif  /* TOFU_ENGINE_OPENGL_ES */
+            const GL_Quad_t area = (GL_Quad_t){
+                    .x0 = (int)(c0 * GL_SURFACE_DIRTY_TILE_SIZE),
+                    .y0 = (int)(r * GL_SURFACE_DIRTY_TILE_SIZE),
+                    .x1 = imin((int)((c + 1) * GL_SURFACE_DIRTY_TILE_SIZE), (int)surface->width),
+                    .y1 = imin((int)((r + 1) * GL_SURFACE_DIRTY_TILE_SIZE), (int)surface->height)
+                };
+            arrpush(display->vram.areas, area);
+        }
+    }
+}
+
+void Display_present(Display_t *display)
 {
     // It is advisable to clear the colour buffer even if the framebuffer will be
     // fully written (see `glTexSubImage2D()` below)
     glClear(GL_COLOR_BUFFER_BIT);
 
     // Convert the offscreen surface to a texture. The actual function changes when a processor is defined.
+    GL_Processor_t *processor = display->canvas.processor;
     const GL_Surface_t *surface = display->canvas.surface;
     GL_Color_t *pixels = display->vram.pixels;
 
-    GL_processor_surface_to_rgba(display->canvas.processor, surface, pixels);
+    // When the surface is tracked we can convert (and upload) only the modified areas. This is not possible when the
+    // processor state changed, or a program is active (it could change the output even if the surface is unchanged).
+    const bool partial = surface->dirty.tiles && !display->canvas.refresh && !GL_processor_has_program(processor);
+    GL_Color_t *mapped = NULL;
+
+#if defined(TOFU_ENGINE_PERFORMANCE_STATISTICS)
+    StopWatch_t conversion_marker = stopwatch_init();
+#endif  /* TOFU_ENGINE_PERFORMANCE_STATISTICS */
+    if (partial) {
+        _collect_areas(display);
+        const GL_Quad_t *area = display->vram.areas;
+        for (size_t count = arrlenu(display->vram.areas); count; --count) {
+            GL_processor_surface_to_rgba_area(processor, surface, pixels, *(area++));
+        }
+    } else {
+        mapped = _map_buffer(display); // When available, convert straight into the pixel-buffer.
+        GL_processor_surface_to_rgba(processor, surface, mapped ? mapped : pixels, display->workers);
+    }
+#if defined(TOFU_ENGINE_PERFORMANCE_STATISTICS)
+    display->conversion_time = stopwatch_elapsed(&conversion_marker);
+#endif  /* TOFU_ENGINE_PERFORMANCE_STATISTICS */
 
     // We need to restore the drawing state, which includes (1) the shader program, (2) the vertices attributes, and (3)
     // the texture to be drawn.
@@ -743,7 +920,35 @@ void Display_present(const Display_t *display)
     glBindVertexArray(display->vao);
     glBindTexture(GL_TEXTURE_2D, display->vram.texture);
 
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)display->canvas.size.width, (GLsizei)display->canvas.size.height, _PIXEL_FORMAT, GL_UNSIGNED_BYTE, pixels);
+    if (partial) {
+        const size_t width = display->canvas.size.width;
+#if !defined(TOFU_ENGINE_OPENGL_ES)
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)width); // Areas are sub-rectangles of the VRAM buffer.
+#endif  /* TOFU_ENGINE_OPENGL_ES */
+        const GL_Quad_t *area = display->vram.areas;
+        for (size_t count = arrlenu(display->vram.areas); count; --count) {
+            const GL_Quad_t *current = area++;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, current->x0, current->y0, current->x1 - current->x0, current->y1 - current->y0, _PIXEL_FORMAT, GL_UNSIGNED_BYTE, pixels + (size_t)current->y0 * width + (size_t)current->x0);
+        }
+#if !defined(TOFU_ENGINE_OPENGL_ES)
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif  /* TOFU_ENGINE_OPENGL_ES */
+    } else
+#if !defined(TOFU_ENGINE_OPENGL_ES)
+    if (mapped) {
+        // The pixel-buffer is still bound, the transfer is queued and will be performed asynchronously by the driver
+        // (the data pointer is an offset into the buffer).
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)display->canvas.size.width, (GLsizei)display->canvas.size.height, _PIXEL_FORMAT, GL_UNSIGNED_BYTE, NULL);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    } else
+#endif  /* TOFU_ENGINE_OPENGL_ES */
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)display->canvas.size.width, (GLsizei)display->canvas.size.height, _PIXEL_FORMAT, GL_UNSIGNED_BYTE, pixels);
+    }
+
+    GL_surface_untouch(surface);
+    display->canvas.refresh = false;
 
     // glEnable(GL_SCISSOR_TEST);
     // glScissor(0, 0, 800, 600); // Coordinates are relative to the left-bottom corner of the window.
@@ -762,6 +967,7 @@ void Display_reset(Display_t *display)
     Display_set_offset(display, (GL_Point_t){ 0, 0 });
 
     GL_processor_reset(display->canvas.processor);
+    display->canvas.refresh = true;
 }
 
 void Display_set_offset(Display_t *display, GL_Point_t offset)
@@ -783,16 +989,23 @@ void Display_set_offset(Display_t *display, GL_Point_t offset)
 void Display_set_palette(Display_t *display, const GL_Color_t *palette)
 {
     GL_processor_set_palette(display->canvas.processor, palette);
+    display->canvas.refresh = true;
+
+    if (display->canvas.matcher) {
+        GL_matcher_update(display->canvas.matcher, palette);
+    }
 }
 
 void Display_set_shifting(Display_t *display, const GL_Pixel_t *from, const GL_Pixel_t *to, size_t count)
 {
     GL_processor_set_shifting(display->canvas.processor, from, to, count);
+    display->canvas.refresh = true;
 }
 
 void Display_set_program(Display_t *display, const GL_Program_t *program)
 {
     GL_processor_set_program(display->canvas.processor, program);
+    display->canvas.refresh = true;
 }
 
 GLFWwindow *Display_get_window(const Display_t *display)
@@ -820,7 +1033,21 @@ const GL_Color_t *Display_get_palette(const Display_t *display)
     return GL_processor_get_palette(display->canvas.processor);
 }
 
+const GL_Matcher_t *Display_get_matcher(Display_t *display)
+{
+    if (!display->canvas.matcher) {
+        display->canvas.matcher = GL_matcher_create(GL_processor_get_palette(display->canvas.processor));
+        LOG_IF_E(!display->canvas.matcher, "can't create matcher for display palette");
+    }
+    return display->canvas.matcher;
+}
+
 GL_Point_t Display_get_offset(const Display_t *display)
 {
     return display->vram.offset;
 }
+
+Workers_t *Display_get_workers(const Display_t *display)
+{
+    return display->workers;
+}
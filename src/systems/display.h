@@ -43,6 +43,7 @@
 #include <core/config.h>
 #include <libs/gl/gl.h>
 #include <libs/shader.h>
+#include <libs/workers.h>
 
 #include <cglm/cglm.h>
 #include <glad/gl.h>
@@ -51,6 +52,8 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#define DISPLAY_MAX_PIXEL_BUFFERS   3
+
 typedef struct Display_Configuration_s {
     GLFWimage icon;
     struct {
@@ -61,6 +64,8 @@ typedef struct Display_Configuration_s {
     bool vertical_sync;
     bool quit_on_close;
     const char *effect;
+    size_t pixel_buffers; // Zero means synchronous upload, otherwise the size of the pixel-buffers ring.
+    size_t workers;
 } Display_Configuration_t;
 
 typedef struct Display_s {
@@ -79,6 +84,8 @@ typedef struct Display_s {
         GL_Size_t size;
         GL_Surface_t *surface;
         GL_Processor_t *processor; // The processor holds the display-wise palette and shifting logic.
+        GL_Matcher_t *matcher; // Lazily created on first match, and kept in sync w/ the palette.
+        bool refresh; // Forces a full conversion (and upload) on the next present, e.g. when the palette changes.
     } canvas;
 
     struct {
@@ -87,8 +94,20 @@ typedef struct Display_s {
         GL_Point_t position; // Destination position, normalized to the final screen size.
         GL_Size_t size; // Duplicates rectangle, for faster return of size.
         GL_Point_t offset;
+        GL_Quad_t *areas; // Dirty areas to be uploaded, collected on present.
+        struct { // Pixel-unpack buffers ring, used to upload the VRAM asynchronously.
+            GLuint ids[DISPLAY_MAX_PIXEL_BUFFERS];
+            size_t count;
+            size_t index;
+        } buffers;
     } vram;
 
+    Workers_t *workers; // Used to spread the (software) rendering across the CPU cores.
+
+#if defined(TOFU_ENGINE_PERFORMANCE_STATISTICS)
+    float conversion_time; // Time (in seconds) spent converting the canvas to RGBA in the last present.
+#endif  /* TOFU_ENGINE_PERFORMANCE_STATISTICS */
+
     double time;
 } Display_t;
 
@@ -100,7 +119,7 @@ extern bool Display_should_close(const Display_t *display);
 
 extern bool Display_update(Display_t *display, float delta_time);
 
-extern void Display_present(const Display_t *display);
+extern void Display_present(Display_t *display);
 
 extern void Display_reset(Display_t *display); // FIXME: remove these six, and access the `processor` field directly?
 
@@ -114,6 +133,8 @@ extern GL_Size_t Display_get_virtual_size(const Display_t *display);
 extern GL_Size_t Display_get_physical_size(const Display_t *display);
 extern GL_Surface_t *Display_get_surface(const Display_t *display);
 extern const GL_Color_t *Display_get_palette(const Display_t *display);
+extern const GL_Matcher_t *Display_get_matcher(Display_t *display);
 extern GL_Point_t Display_get_offset(const Display_t *display);
+extern Workers_t *Display_get_workers(const Display_t *display);
 
 #endif  /* TOFU_SYSTEMS_DISPLAY_H */
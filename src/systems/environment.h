@@ -46,7 +46,7 @@
 typedef struct Environment_Stats_s {
     size_t fps;
 #if defined(TOFU_ENGINE_PERFORMANCE_STATISTICS)
-    float times[5];
+    float times[6]; // Process, update, render, wait, frame, and (display) conversion times.
 #endif  /* TOFU_ENGINE_PERFORMANCE_STATISTICS */
 #if defined(TOFU_ENGINE_HEAP_STATISTICS)
     size_t memory_usage;
@@ -70,7 +70,7 @@ extern void Environment_destroy(Environment_t *environment);
 extern const Environment_State_t *Environment_get_state(const Environment_t *environment);
 
 #if defined(TOFU_ENGINE_PERFORMANCE_STATISTICS)
-extern void Environment_accumulate(Environment_t *environment, float frame_time, const float deltas[5]);
+extern void Environment_accumulate(Environment_t *environment, float frame_time, const float deltas[6]);
 #else
 extern void Environment_accumulate(Environment_t *environment, float frame_time);
 #endif  /* TOFU_ENGINE_PERFORMANCE_STATISTICS */
@@ -40,6 +40,8 @@ https://nachtimwald.com/2014/07/26/calling-lua-from-c/
 #include <modules/modules.h>
 
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #if defined(TOFU_INTERPRETER_GC_REPORTING)
     #include <time.h>
 #endif
@@ -53,12 +55,6 @@ https://nachtimwald.com/2014/07/26/calling-lua-from-c/
     #define _METHOD_STACK_INDEX(m) _OBJECT_STACK_INDEX + 1 + (m)
 #endif  /* TOFU_INTERPRETER_PROTECTED_CALLS */
 
-#if defined(TOFU_INTERPRETER_READER_BUFFER_SIZE)
-    #define _READER_CONTEXT_BUFFER_SIZE TOFU_INTERPRETER_READER_BUFFER_SIZE
-#else   /* TOFU_INTERPRETER_READER_BUFFER_SIZE */
-    #define _READER_CONTEXT_BUFFER_SIZE 1024
-#endif  /* TOFU_INTERPRETER_READER_BUFFER_SIZE */
-
 #if defined(DEBUG)
     #define _BOOT_SCRIPT "boot-debug"
 #else   /* DEBUG */
@@ -70,6 +66,9 @@ typedef enum Entry_Point_Methods_e {
     ENTRY_POINT_METHOD_INIT,
     ENTRY_POINT_METHOD_UPDATE,
     ENTRY_POINT_METHOD_RENDER,
+#if defined(TOFU_FILE_HOT_RELOAD)
+    ENTRY_POINT_METHOD_RELOAD,
+#endif  /* TOFU_FILE_HOT_RELOAD */
     Entry_Point_Methods_t_CountOf
 } Entry_Point_Methods_t;
 
@@ -77,6 +76,9 @@ static const char *_methods[] = { // We don't use a compound-literal on purpose
     "init",
     "update",
     "render",
+#if defined(TOFU_FILE_HOT_RELOAD)
+    "reload",
+#endif  /* TOFU_FILE_HOT_RELOAD */
     NULL
 };
 
@@ -145,28 +147,72 @@ static int _error_handler(lua_State *L)
 }
 #endif
 
-// [...] Every time lua_load needs another piece of the chunk, it calls the reader, passing along its data parameter.
-// The reader must return a pointer to a block of memory with a new piece of the chunk and set size to the block size.
-// The block must exist until the reader function is called again. To signal the end of the chunk, the reader must
-// return NULL or set size to zero. The reader function may return pieces of any size greater than zero. [...]
-typedef struct lua_Reader_Context_s {
-    FS_Handle_t *handle;
-    uint8_t buffer[_READER_CONTEXT_BUFFER_SIZE];
-} lua_Reader_Context_t;
+// The whole chunk is handed to Lua in a single block. When the handle content is directly accessible (i.e. a plain
+// entry of a memory-mapped archive) no copy is made at all, otherwise the file is read in one go.
+static int _load(lua_State *L, FS_Handle_t *handle, const char *name, const char *mode)
+{
+    const size_t size = FS_size(handle);
 
-static const char *_reader(lua_State *L, void *data, size_t *size)
+    const void *data = FS_map(handle);
+    if (data) {
+        return luaL_loadbufferx(L, (const char *)data, size, name, mode);
+    }
+
+    char *buffer = malloc(sizeof(char) * (size + 1)); // Always allocate at least a byte, even for empty files.
+    if (!buffer) {
+        lua_pushfstring(L, "can't allocate %d byte(s) buffer", (int)size);
+        return LUA_ERRMEM;
+    }
+
+    size_t bytes_read = FS_read(handle, buffer, size);
+    int result = luaL_loadbufferx(L, buffer, bytes_read, name, mode);
+
+    free(buffer);
+
+    return result;
+}
+
+#if defined(TOFU_INTERPRETER_PRECOMPILED_MODULES)
+// Precompiled modules are stored alongside the sources, with the `.luac` extension. If the bytecode can't be loaded
+// (e.g. it has been generated by a different VM version, which Lua detects from the chunk header) we silently fall
+// back to the source.
+//
+// Only the archives are trusted to ship matching chunks. Elsewhere (i.e. while developing) the precompiled file could
+// be stale, so the source wins when it exists and it's newer (or its age can't be compared).
+static bool _load_precompiled(lua_State *L, const Storage_t *storage, const char *file, const char *name)
 {
-    lua_Reader_Context_t *context = (lua_Reader_Context_t *)data;
+    char path[PLATFORM_PATH_MAX] = { 0 };
+    snprintf(path, PLATFORM_PATH_MAX, "%sc", file);
 
-    const size_t bytes_read = FS_read(context->handle, context->buffer, _READER_CONTEXT_BUFFER_SIZE);
-    if (bytes_read == 0) {
-        *size = 0;
-        return NULL;
+    time_t precompiled_stamp;
+    if (!Storage_stamp(storage, path, &precompiled_stamp)) {
+        return false;
+    }
+    time_t source_stamp;
+    if (precompiled_stamp != 0 && Storage_stamp(storage, file, &source_stamp)
+        && (source_stamp == 0 || source_stamp > precompiled_stamp)) {
+        LOG_D("precompiled file `%s` is outdated w.r.t. its source, ignoring it", path);
+        return false;
     }
 
-    *size = bytes_read;
-    return (const char *)context->buffer;
+    FS_Handle_t *handle = Storage_open(storage, path);
+    if (!handle) {
+        return false;
+    }
+
+    int result = _load(L, handle, name, "b");
+
+    FS_close(handle);
+
+    if (result != LUA_OK) {
+        LOG_W("can't load precompiled file `%s` (%s), using source", path, lua_tostring(L, -1));
+        lua_pop(L, 1);
+        return false;
+    }
+
+    return true;
 }
+#endif  /* TOFU_INTERPRETER_PRECOMPILED_MODULES */
 
 static int _searcher(lua_State *L)
 {
@@ -177,13 +223,20 @@ static int _searcher(lua_State *L)
     char name[PLATFORM_PATH_MAX] = { 0 };
     const char *file = path_lua_to_fs(name, module_name);
 
+#if defined(TOFU_INTERPRETER_PRECOMPILED_MODULES)
+    if (_load_precompiled(L, storage, file, name)) {
+        lua_pushstring(L, name); // Return the path of the loaded file as second return value.
+        return 2;
+    }
+#endif  /* TOFU_INTERPRETER_PRECOMPILED_MODULES */
+
     FS_Handle_t *handle = Storage_open(storage, file); // Don't waste storage cache! The module will be cached by Lua!
     if (!handle) {
         lua_pushfstring(L, "file `%s` can't be found into the storage", file);
         return 1;
     }
 
-    int result = lua_load(L, _reader, &(lua_Reader_Context_t){ .handle = handle }, name, NULL); // Set `mode` to `NULL`. Autodetect format to support both `text` and `binary` sources.
+    int result = _load(L, handle, name, NULL); // Set `mode` to `NULL`. Autodetect format to support both `text` and `binary` sources.
 
     FS_close(handle);
 
@@ -407,6 +460,20 @@ bool Interpreter_render(const Interpreter_t *interpreter, float ratio)
     return _method_call(interpreter->state, ENTRY_POINT_METHOD_RENDER, 1, 0) == LUA_OK;
 }
 
+#if defined(TOFU_FILE_HOT_RELOAD)
+// When `lost` is `true` some changes couldn't be tracked, and the names are not to be trusted as complete.
+bool Interpreter_reload(const Interpreter_t *interpreter, const char **names, size_t count, bool lost)
+{
+    lua_createtable(interpreter->state, (int)count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        lua_pushstring(interpreter->state, names[i]);
+        lua_rawseti(interpreter->state, -2, (lua_Integer)(i + 1));
+    }
+    lua_pushboolean(interpreter->state, lost);
+    return _method_call(interpreter->state, ENTRY_POINT_METHOD_RELOAD, 2, 0) == LUA_OK;
+}
+#endif  /* TOFU_FILE_HOT_RELOAD */
+
 bool Interpreter_call(const Interpreter_t *interpreter, int nargs, int nresults)
 {
     return _raw_call(interpreter->state, nargs, nresults) == LUA_OK;
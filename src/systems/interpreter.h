@@ -68,6 +68,9 @@ extern void Interpreter_destroy(Interpreter_t *interpreter);
 extern bool Interpreter_boot(Interpreter_t *interpreter, const void *userdatas[]);
 extern bool Interpreter_update(Interpreter_t *interpreter, float delta_time);
 extern bool Interpreter_render(const Interpreter_t *interpreter, float ratio);
+#if defined(TOFU_FILE_HOT_RELOAD)
+extern bool Interpreter_reload(const Interpreter_t *interpreter, const char **names, size_t count, bool lost);
+#endif  /* TOFU_FILE_HOT_RELOAD */
 extern bool Interpreter_call(const Interpreter_t *interpreter, int nargs, int nresults);
 
 #endif  /* __ TOFU_SYSTEMS_INTERPRETER_H__ */
@@ -60,6 +60,9 @@ Storage_t *Storage_create(const Storage_Configuration_t *configuration)
             .path = {
                 .user = { 0 },
                 .local = { 0 }
+            },
+            .resources = {
+                .budget = TOFU_STORAGE_CACHE_BUDGET
             }
         };
 
@@ -149,16 +152,56 @@ static void _release(Storage_Resource_t *resource)
     LOG_D("resource %p freed", resource);
 }
 
+#if defined(TOFU_FILE_HOT_RELOAD)
+static void _forget_changes(Storage_t *storage)
+{
+    char **current = storage->changes;
+    for (size_t count = arrlenu(storage->changes); count; --count) {
+        free(*(current++));
+    }
+    static const size_t zero = 0;
+    arrsetlen(storage->changes, zero);
+    storage->changes_lost = false;
+}
+
+#endif  /* TOFU_FILE_HOT_RELOAD */
+
 void Storage_destroy(Storage_t *storage)
 {
-    Storage_Resource_t **current = storage->resources;
-    for (size_t count = arrlenu(storage->resources); count; --count) {
-        Storage_Resource_t *resource = *(current++);
+    if (storage->loader) {
+        Storage_Loader_stop(storage->loader); // Wait for the in-progress requests, and release them.
+        Storage_Loader_collect(storage->loader, &storage->requests);
+        for (size_t i = 0; i < arrlenu(storage->requests); ++i) {
+            Storage_Resource_t *resource = (Storage_Resource_t *)storage->requests[i].data;
+            if (resource) {
+                _release(resource);
+            }
+        }
+        Storage_Loader_destroy(storage->loader);
+        LOG_D("storage loader destroyed");
+    }
+    arrfree(storage->requests);
+
+    for (Storage_Resource_t *resource = storage->resources.head; resource; ) {
+        Storage_Resource_t *next = resource->next;
         _release(resource);
+        resource = next;
     }
-    arrfree(storage->resources);
+    hmfree(storage->resources.index);
     LOG_D("storage cache emptied");
 
+    Storage_Resource_t **current = storage->evicted;
+    for (size_t count = arrlenu(storage->evicted); count; --count) {
+        _release(*(current++));
+    }
+    arrfree(storage->evicted);
+    LOG_D("storage evicted resources released");
+
+#if defined(TOFU_FILE_HOT_RELOAD)
+    _forget_changes(storage);
+    arrfree(storage->changes);
+#endif  /* TOFU_FILE_HOT_RELOAD */
+
     Storage_Cache_destroy(storage->cache);
     LOG_D("storage cache destroyed");
 
@@ -171,17 +214,29 @@ void Storage_destroy(Storage_t *storage)
 
 bool Storage_inject_base64(Storage_t *storage, const char *name, const char *encoded_data, size_t length)
 {
-    return Storage_Cache_inject_base64(storage->cache, name, encoded_data, length);
+    if (!Storage_Cache_inject_base64(storage->cache, name, encoded_data, length)) {
+        return false;
+    }
+    FS_invalidate(storage->context, name);
+    return true;
 }
 
 bool Storage_inject_ascii85(Storage_t *storage, const char *name, const char *encoded_data, size_t length)
 {
-    return Storage_Cache_inject_ascii85(storage->cache, name, encoded_data, length);
+    if (!Storage_Cache_inject_ascii85(storage->cache, name, encoded_data, length)) {
+        return false;
+    }
+    FS_invalidate(storage->context, name);
+    return true;
 }
 
 bool Storage_inject_raw(Storage_t *storage, const char *name, const void *raw_data, size_t size)
 {
-    return Storage_Cache_inject_raw(storage->cache, name, raw_data, size);
+    if (!Storage_Cache_inject_raw(storage->cache, name, raw_data, size)) {
+        return false;
+    }
+    FS_invalidate(storage->context, name);
+    return true;
 }
 
 bool Storage_set_identity(Storage_t *storage, const char *identity)
@@ -199,7 +254,7 @@ bool Storage_set_identity(Storage_t *storage, const char *identity)
         return false;
     }
 
-    bool attached = FS_attach_folder(storage->context, storage->path.local);
+    bool attached = FS_attach_folder(storage->context, storage->path.local, false); // Our own writes aren't to be reloaded.
     if (!attached) {
         LOG_E("can't attach user-dependent path path `%s`", storage->path.local);
         return false;
@@ -253,9 +308,7 @@ static bool _load_as_string(Storage_Resource_t *resource, FS_Handle_t *handle)
                     .length = length
                 }
             },
-#if defined(TOFU_STORAGE_AUTO_COLLECT)
-            .age = 0.0
-#endif  /* TOFU_STORAGE_AUTO_COLLECT */
+            .size = length + 1
         };
 
     return true;
@@ -278,9 +331,7 @@ static bool _load_as_blob(Storage_Resource_t *resource, FS_Handle_t *handle)
                     .size = size
                 }
             },
-#if defined(TOFU_STORAGE_AUTO_COLLECT)
-            .age = 0.0
-#endif  /* TOFU_STORAGE_AUTO_COLLECT */
+            .size = size
         };
 
     return true;
@@ -329,9 +380,7 @@ static bool _load_as_image(Storage_Resource_t *resource, FS_Handle_t *handle)
                     .pixels = pixels
                 }
             },
-#if defined(TOFU_STORAGE_AUTO_COLLECT)
-            .age = 0.0
-#endif  /* TOFU_STORAGE_AUTO_COLLECT */
+            .size = (size_t)width * (size_t)height * 4
         };
 
     return true;
@@ -343,7 +392,7 @@ static const Storage_Load_Function_t _load_functions[Storage_Resource_Types_t_Co
     _load_as_image
 };
 
-static bool _resource_load(Storage_Resource_t *resource, const char *name, Storage_Resource_Types_t type, const FS_Context_t *context)
+static bool _resource_load(Storage_Resource_t *resource, const char *name, Storage_Resource_Types_t type, FS_Context_t *context)
 {
     FS_Handle_t *handle = FS_open(context, name);
     if (!handle) {
@@ -355,79 +404,169 @@ static bool _resource_load(Storage_Resource_t *resource, const char *name, Stora
     return loaded;
 }
 
-// We are using a linear search instead for `bsearch()` since the resource cache is limited in size (won't
-// exceed hundred of entries, typically). Also, since we were (occasionally) keeping the array sorted by "age",
-// binary-searching by name would be impossible! (unless we are re-sorting the array twice just for sake of it)
-//
-// We single-handedly got rid of both of them. The array is never sorted which means a faster and more cache-friendly
-// code. Also, we are removing the entries with the SWAP-AND-POP idiom, which is as fast as possible.
-//
-// Note: we are receiving and passing a *non* `const` pointer to the resources array as the returned value
-//       is usually manipulated and modified in a *non* `const` manner.
-static inline Storage_Resource_t *_lookup(Storage_Resource_t **resources, const uint8_t id[STORAGE_RESOURCE_ID_LENGTH])
-{
-    size_t length = arrlenu(resources);
-    for (size_t i = 0; i < length; ++i) {
-        Storage_Resource_t *resource = resources[i];
-        if (memcmp(resource->id, id, STORAGE_RESOURCE_ID_LENGTH) == 0) {
-            return resource;
-        }
+// The cached resources are indexed by id in a hash-map, and kept in a list sorted by last access. The head of the
+// list is the most recently used resource, and the tail the one to be evicted first.
+static inline Storage_Resource_t *_lookup(Storage_t *storage, const uint8_t id[STORAGE_RESOURCE_ID_LENGTH])
+{
+    Storage_Resource_Id_t key;
+    memcpy(key.bytes, id, STORAGE_RESOURCE_ID_LENGTH);
+    ptrdiff_t index = hmgeti(storage->resources.index, key);
+    return index == -1 ? NULL : storage->resources.index[index].value;
+}
+
+static inline void _unlink(Storage_t *storage, Storage_Resource_t *resource)
+{
+    if (resource->prev) {
+        resource->prev->next = resource->next;
+    } else {
+        storage->resources.head = resource->next;
     }
-    return NULL;
+    if (resource->next) {
+        resource->next->prev = resource->prev;
+    } else {
+        storage->resources.tail = resource->prev;
+    }
+    resource->prev = resource->next = NULL;
+}
+
+static inline void _link(Storage_t *storage, Storage_Resource_t *resource)
+{
+    resource->prev = NULL;
+    resource->next = storage->resources.head;
+    if (storage->resources.head) {
+        storage->resources.head->prev = resource;
+    } else {
+        storage->resources.tail = resource;
+    }
+    storage->resources.head = resource;
 }
 
-#if defined(TOFU_STORAGE_CACHE_ENTRIES_LIMIT)
-static inline size_t _used_cache_slots(Storage_Resource_t **resources)
+static inline void _touch(Storage_t *storage, Storage_Resource_t *resource)
 {
-    const size_t length = arrlenu(resources);
+    if (storage->resources.head != resource) {
+        _unlink(storage, resource);
+        _link(storage, resource);
+    }
 #if defined(TOFU_STORAGE_AUTO_COLLECT)
-    // Returns the amount of cache slots occupied by *not "aged" resources, as the one already "aged" will
-    // be automatically free on the next update call and are not really going to stay in the cache.
-    size_t count = 0;
-    for (size_t i = 1; i < length; ++i) {
-        const Storage_Resource_t *resource = resources[i];
-        if (resource->age >= TOFU_STORAGE_RESOURCE_MAX_AGE) {
+    resource->used_at = storage->resources.time;
+#endif  /* TOFU_STORAGE_AUTO_COLLECT */
+}
+
+static inline void _remove(Storage_t *storage, Storage_Resource_t *resource)
+{
+    Storage_Resource_Id_t key;
+    memcpy(key.bytes, resource->id, STORAGE_RESOURCE_ID_LENGTH);
+    (void)hmdel(storage->resources.index, key);
+
+    _unlink(storage, resource);
+
+    storage->stats.used -= resource->size;
+}
+
+// Evicts the least recently used resources until the budget is met again, sparing the (just inserted) head of the
+// list and the pinned ones. Evicted resources are parked and released on the next update, as the caller could be
+// still referencing some of them (e.g. a couple of resources loaded in a row).
+static void _evict(Storage_t *storage)
+{
+    const size_t budget = storage->resources.budget;
+    if (budget == 0) {
+        return;
+    }
+
+    for (Storage_Resource_t *resource = storage->resources.tail; resource && resource != storage->resources.head; ) {
+        if (storage->stats.used <= budget) {
+            break;
+        }
+
+        Storage_Resource_t *prev = resource->prev;
+        if (resource->pinned) {
+            resource = prev;
             continue;
         }
-        count += 1;
+
+        _remove(storage, resource);
+        arrpush(storage->evicted, resource);
+        storage->stats.evictions += 1;
+        LOG_D("resource %p evicted (%d bytes), cache is using %d bytes out of %d", resource, resource->size, storage->stats.used, budget);
+
+        resource = prev;
     }
-#else   /* TOFU_STORAGE_AUTO_COLLECT */
-    size_t count = length;
-#endif  /* TOFU_STORAGE_AUTO_COLLECT */
-    LOG_D("cache is currently holding %d resources", count);
-    return count;
 }
 
-static inline void _free_cache_slot(Storage_Resource_t **resources)
+static void _insert(Storage_t *storage, Storage_Resource_t *resource)
 {
+    Storage_Resource_Id_t key;
+    memcpy(key.bytes, resource->id, STORAGE_RESOURCE_ID_LENGTH);
+    hmput(storage->resources.index, key, resource);
+
+    resource->prev = resource->next = NULL;
+    _link(storage, resource);
 #if defined(TOFU_STORAGE_AUTO_COLLECT)
-    // Finds the oldest entry among the resources, we skip already "aged" ones.
-    const size_t length = arrlenu(resources);
-    Storage_Resource_t *oldest = NULL; // We can't pick the first one, as it might be already "aged".
-    for (size_t i = 0; i < length; ++i) {
-        Storage_Resource_t *resource = resources[i];
-        if (resource->age >= TOFU_STORAGE_RESOURCE_MAX_AGE) {
-            continue;
-        }
-        if (!oldest || oldest->age < resource->age) {
-            oldest = resource;
-        }
+    resource->used_at = storage->resources.time;
+#endif  /* TOFU_STORAGE_AUTO_COLLECT */
+
+    storage->stats.used += resource->size;
+
+    _evict(storage);
+}
+
+static void _release_evicted(Storage_t *storage)
+{
+    Storage_Resource_t **current = storage->evicted;
+    for (size_t count = arrlenu(storage->evicted); count; --count) {
+        _release(*(current++));
     }
+    static const size_t zero = 0; // Note: we don't pass the immediate `0` to avoid a "type-limit" warning from the compiler.
+    arrsetlen(storage->evicted, zero);
+}
 
-    if (!oldest) { // This is mostly an assertion, as it is IMPOSSIBLE that a resource is not found as to-be-released!
-        LOG_W("Great Scott! No resources marked for release!");
+#if defined(TOFU_FILE_HOT_RELOAD)
+// Only the resource bound to the changed file is discarded, the next load will fetch the updated content.
+static void _on_change(void *user_data, const char *name)
+{
+    Storage_t *storage = (Storage_t *)user_data;
+
+    if (!name) { // Changes have been lost, we can't tell which resources are still valid.
+        for (Storage_Resource_t *resource = storage->resources.tail; resource; resource = storage->resources.tail) {
+            _remove(storage, resource);
+            _release(resource);
+        }
+        storage->changes_lost = true; // Notify, so that everything can be reloaded.
+        LOG_W("cache emptied, changes have been lost");
         return;
     }
 
-    oldest->age = TOFU_STORAGE_RESOURCE_MAX_AGE; // Mark the oldest for release in the next cycle.
-    LOG_D("resource %p marked for release", oldest);
-#else   /* TOFU_STORAGE_AUTO_COLLECT */
-    Storage_Resource_t *oldest = resources[0];
-    arrdel(resources, 0); // FIFO removal.
-    LOG_D("resource %p released", oldest);
-#endif  /* TOFU_STORAGE_AUTO_COLLECT */
+    uint8_t id[STORAGE_RESOURCE_ID_LENGTH];
+    md5_hash_sz(id, name, false);
+
+    Storage_Resource_t *resource = _lookup(storage, id);
+    if (resource) {
+        _remove(storage, resource);
+        _release(resource);
+        LOG_D("resource `%s` changed, discarded from cache", name);
+    }
+
+    for (size_t i = 0; i < arrlenu(storage->changes); ++i) { // The same file is often reported more than once.
+        if (strcmp(storage->changes[i], name) == 0) {
+            return;
+        }
+    }
+    arrpush(storage->changes, stb_memdup(name, strlen(name) + 1));
+}
+#endif  /* TOFU_FILE_HOT_RELOAD */
+
+void Storage_set_cache_budget(Storage_t *storage, size_t budget)
+{
+    storage->resources.budget = budget;
+    LOG_D("cache budget set to %d bytes", budget);
+
+    _evict(storage);
+}
+
+const Storage_Stats_t *Storage_get_stats(const Storage_t *storage)
+{
+    return &storage->stats;
 }
-#endif
 
 bool Storage_exists(Storage_t *storage, const char *name)
 {
@@ -444,14 +583,15 @@ Storage_Resource_t *Storage_load(Storage_t *storage, const char *name, Storage_R
     uint8_t id[STORAGE_RESOURCE_ID_LENGTH];
     md5_hash_sz(id, name, false);
 
-    Storage_Resource_t *entry = _lookup(storage->resources, id);
+    Storage_Resource_t *entry = _lookup(storage, id);
     if (entry) {
         LOG_D("cache-hit for resource `%s`, resetting age and returning", name);
-#if defined(TOFU_STORAGE_AUTO_COLLECT)
-        entry->age = 0.0f; // Reset age on cache-hit.
-#endif  /* TOFU_STORAGE_AUTO_COLLECT) */
+        entry->pinned = false; // From now on, a preloaded resource is cached as any other one.
+        _touch(storage, entry); // Also resets the age.
+        storage->stats.hits += 1;
         return entry;
     }
+    storage->stats.misses += 1;
 
     Storage_Resource_t *resource = malloc(sizeof(Storage_Resource_t));
     if (!resource) {
@@ -467,14 +607,7 @@ Storage_Resource_t *Storage_load(Storage_t *storage, const char *name, Storage_R
     }
     md5_hash_sz(resource->id, name, false);
 
-    arrpush(storage->resources, resource);
-
-#if defined(TOFU_STORAGE_CACHE_ENTRIES_LIMIT)
-    if (_used_cache_slots(storage->resources) > TOFU_STORAGE_CACHE_ENTRIES_LIMIT) {
-        LOG_D("cache is full, picking a resource to release");
-        _free_cache_slot(storage->resources);
-    }
-#endif
+    _insert(storage, resource);
 
     LOG_D("resource `%s` stored as %p", name, resource);
 
@@ -539,6 +672,8 @@ bool Storage_store(Storage_t *storage, const char *name, const Storage_Resource_
         LOG_E("can't write resource `%s` w/ type %d to file `%s`", name, resource->type, path);
     }
 
+    FS_invalidate(storage->context, name); // The file could have been created, or it now overrides another one.
+
     return result;
 }
 
@@ -547,37 +682,169 @@ FS_Handle_t *Storage_open(const Storage_t *storage, const char *name)
     return FS_open(storage->context, name);
 }
 
-#if defined(TOFU_STORAGE_AUTO_COLLECT)
+bool Storage_stamp(const Storage_t *storage, const char *name, time_t *stamp)
+{
+    return FS_stamp(storage->context, name, stamp);
+}
+
+// Called from the loader threads, it is thread-safe as long as the mounts are not modified in the meanwhile.
+static void *_preload(void *user_data, const char *name, int kind)
+{
+    FS_Context_t *context = (FS_Context_t *)user_data;
+
+    Storage_Resource_t *resource = malloc(sizeof(Storage_Resource_t));
+    if (!resource) {
+        LOG_E("can't allocate resource");
+        return NULL;
+    }
+
+    if (!_resource_load(resource, name, (Storage_Resource_Types_t)kind, context)) {
+        LOG_E("can't preload resource `%s`", name);
+        free(resource);
+        return NULL;
+    }
+    md5_hash_sz(resource->id, name, false);
+
+    LOG_D("resource `%s` preloaded as %p", name, resource);
+
+    return resource;
+}
+
+bool Storage_preload(Storage_t *storage, const char **names, const Storage_Resource_Types_t *types, size_t count)
+{
+    if (!storage->loader) {
+        storage->loader = Storage_Loader_create(TOFU_STORAGE_PRELOAD_THREADS, _preload, storage->context);
+        if (!storage->loader) {
+            LOG_E("can't create storage loader");
+            return false;
+        }
+        LOG_D("storage loader %p created", storage->loader);
+    }
+
+    if (storage->preload.completed == storage->preload.total) { // Idle, restart counting.
+        storage->preload.completed = 0;
+        storage->preload.total = 0;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const char *name = names[i];
+        if (path_is_absolute(name) || !path_is_normalized(name)) {
+            LOG_E("path `%s` is not allowed (only relative non-parent paths in sandbox mode)", name);
+            return false;
+        }
+
+        uint8_t id[STORAGE_RESOURCE_ID_LENGTH];
+        md5_hash_sz(id, name, false);
+        if (_lookup(storage, id)) {
+            LOG_D("resource `%s` already in cache, skipping preload", name);
+            continue;
+        }
+
+        bool enqueued = Storage_Loader_enqueue(storage->loader, name, (int)types[i]);
+        if (!enqueued) {
+            LOG_E("can't enqueue resource `%s` for preload", name);
+            return false;
+        }
+        storage->preload.total += 1;
+    }
+
+    return true;
+}
+
+void Storage_preload_progress(const Storage_t *storage, size_t *completed, size_t *total)
+{
+    *completed = storage->preload.completed;
+    *total = storage->preload.total;
+}
+
+// Moves the preloaded resources into the cache. It's done on the main thread, so that the resources array is never
+// accessed concurrently.
+static void _harvest(Storage_t *storage)
+{
+    size_t count = Storage_Loader_collect(storage->loader, &storage->requests);
+    for (size_t i = 0; i < count; ++i) {
+        Storage_Resource_t *resource = (Storage_Resource_t *)storage->requests[i].data;
+        storage->preload.completed += 1;
+        if (!resource) {
+            continue;
+        }
+
+        if (_lookup(storage, resource->id)) { // Already loaded in the meanwhile, discard.
+            _release(resource);
+            continue;
+        }
+
+        resource->pinned = true; // Preloading would be pointless if the resource expired before being used.
+        _insert(storage, resource);
+
+        LOG_D("preloaded resource `%s` stored as %p", storage->requests[i].name, resource);
+    }
+}
+
 bool Storage_update(Storage_t *storage, float delta_time)
 {
-    // Backward scan, to properly implement the SWAP-AND-POP(tm) idiom along the whole array
-    // when removing the to-be-released resources.
-    for (int index = arrlen(storage->resources) - 1; index >= 0; --index) {
-        Storage_Resource_t *resource = storage->resources[index];
-        resource->age += delta_time;
-        if (resource->age < TOFU_STORAGE_RESOURCE_MAX_AGE) {
+    _release_evicted(storage);
+
+#if defined(TOFU_FILE_HOT_RELOAD)
+    _forget_changes(storage);
+    FS_poll(storage->context, _on_change, storage);
+#endif  /* TOFU_FILE_HOT_RELOAD */
+
+    if (storage->loader) {
+        _harvest(storage);
+    }
+
+#if defined(TOFU_STORAGE_AUTO_COLLECT)
+    storage->resources.time += delta_time;
+
+    // The list is sorted by last access, so the aged resources are all at the tail (pinned ones aside).
+    const double time = storage->resources.time;
+    for (Storage_Resource_t *resource = storage->resources.tail; resource; ) {
+        Storage_Resource_t *prev = resource->prev;
+        if (resource->pinned) {
+            resource = prev;
             continue;
         }
+        if (time - resource->used_at < TOFU_STORAGE_RESOURCE_MAX_AGE) {
+            break;
+        }
 
+        _remove(storage, resource);
         _release(resource); // Release the way-too-old resource...
 
-        arrdelswap(storage->resources, index); // ... shrink the array!
+        resource = prev;
     }
+#else   /* TOFU_STORAGE_AUTO_COLLECT */
+    (void)delta_time;
+#endif  /* TOFU_STORAGE_AUTO_COLLECT */
 
     return true;
 }
-#else   /* TOFU_STORAGE_AUTO_COLLECT */
+
+#if defined(TOFU_FILE_HOT_RELOAD)
+const char **Storage_get_changes(const Storage_t *storage, size_t *count, bool *lost)
+{
+    *lost = storage->changes_lost;
+    *count = arrlenu(storage->changes);
+    return (const char **)storage->changes;
+}
+#endif  /* TOFU_FILE_HOT_RELOAD */
+
+#if !defined(TOFU_STORAGE_AUTO_COLLECT)
 size_t Storage_flush(Storage_t *storage)
 {
-    size_t count = arrlenu(storage->resources);
+    _release_evicted(storage);
 
-    Storage_Resource_t **current = storage->resources;
-    for (size_t i = count; i; --i) {
-        Storage_Resource_t *resource = *(current++);
+    size_t count = 0;
+    for (Storage_Resource_t *resource = storage->resources.head; resource; ++count) {
+        Storage_Resource_t *next = resource->next;
         _release(resource);
+        resource = next;
     }
 
-    arrfree(storage->resources);
+    hmfree(storage->resources.index);
+    storage->resources.head = storage->resources.tail = NULL;
+    storage->stats.used = 0;
 
     return count;
 }
@@ -39,6 +39,7 @@
 #define TOFU_SYSTEMS_STORAGE_H
 
 #include "storage/cache.h"
+#include "storage/loader.h"
 
 #include <core/config.h>
 #include <core/platform.h>
@@ -76,11 +77,30 @@ typedef struct Storage_Resource_s {
             void *pixels;
         } image;
     } var;
+    size_t size; // Memory footprint of the data, accounted against the cache budget.
+    struct Storage_Resource_s *prev, *next; // Links of the cache LRU list (most recently used first).
+    bool pinned; // Preloaded and not yet loaded, it's spared from aging and eviction until then.
 #if defined(TOFU_STORAGE_AUTO_COLLECT)
-    double age;
+    double used_at; // Storage time of the last access, used to age the resource.
 #endif  /* TOFU_STORAGE_AUTO_COLLECT */
 } Storage_Resource_t;
 
+typedef struct Storage_Resource_Id_s {
+    uint8_t bytes[STORAGE_RESOURCE_ID_LENGTH];
+} Storage_Resource_Id_t;
+
+typedef struct Storage_Resource_Entry_s {
+    Storage_Resource_Id_t key;
+    Storage_Resource_t *value;
+} Storage_Resource_Entry_t;
+
+typedef struct Storage_Stats_s {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t used; // Bytes currently held by the cache.
+} Storage_Stats_t;
+
 typedef struct Storage_Configuration_s {
     const char *kernal_path;
     const char *data_path;
@@ -100,7 +120,28 @@ typedef struct Storage_s {
 
     Storage_Cache_t *cache;
 
-    Storage_Resource_t **resources;
+    Storage_Loader_t *loader; // Lazily created on the first preload request.
+    Storage_Loader_Request_t *requests; // Buffer to collect the completed preload requests into.
+    struct {
+        size_t completed;
+        size_t total;
+    } preload;
+
+    struct {
+        Storage_Resource_Entry_t *index; // Hash-map of the cached resources, by id.
+        Storage_Resource_t *head, *tail; // LRU list, eviction starts from the tail.
+        size_t budget; // In bytes, `0` means unlimited.
+#if defined(TOFU_STORAGE_AUTO_COLLECT)
+        double time;
+#endif  /* TOFU_STORAGE_AUTO_COLLECT */
+    } resources;
+    Storage_Resource_t **evicted; // Released on the next update, as they could still be referenced in the meanwhile.
+#if defined(TOFU_FILE_HOT_RELOAD)
+    char **changes; // Names of the files changed on disk, detected during the last update.
+    bool changes_lost; // Some changes couldn't be tracked, anything could have changed.
+#endif  /* TOFU_FILE_HOT_RELOAD */
+
+    Storage_Stats_t stats;
 } Storage_t;
 
 // Faster accessors for a storage (S) resource (R) attributes.
@@ -121,16 +162,27 @@ extern bool Storage_inject_ascii85(Storage_t *storage, const char *name, const c
 extern bool Storage_inject_raw(Storage_t *storage, const char *name, const void *data, size_t size);
 
 extern bool Storage_set_identity(Storage_t *storage, const char *identity);
+extern void Storage_set_cache_budget(Storage_t *storage, size_t budget);
+
+extern const Storage_Stats_t *Storage_get_stats(const Storage_t *storage);
 
 extern bool Storage_exists(Storage_t *storage, const char *name);
 extern Storage_Resource_t *Storage_load(Storage_t *storage, const char *name, Storage_Resource_Types_t type);
 extern bool Storage_store(Storage_t *storage, const char *name, const Storage_Resource_t *resource);
 
 extern FS_Handle_t *Storage_open(const Storage_t *storage, const char *name); // Use `FS` API to control and close it.
+extern bool Storage_stamp(const Storage_t *storage, const char *name, time_t *stamp); // `0` for immutable content (i.e. archives).
+
+// Loads and decodes the resources in background, adding them to the cache on the following updates. Resources
+// already in cache are skipped. The progress counts the completed requests since the storage was last idle.
+extern bool Storage_preload(Storage_t *storage, const char **names, const Storage_Resource_Types_t *types, size_t count);
+extern void Storage_preload_progress(const Storage_t *storage, size_t *completed, size_t *total);
 
-#if defined(TOFU_STORAGE_AUTO_COLLECT)
 extern bool Storage_update(Storage_t *storage, float delta_time);
-#else   /* TOFU_STORAGE_AUTO_COLLECT */
+#if defined(TOFU_FILE_HOT_RELOAD)
+extern const char **Storage_get_changes(const Storage_t *storage, size_t *count, bool *lost);
+#endif  /* TOFU_FILE_HOT_RELOAD */
+#if !defined(TOFU_STORAGE_AUTO_COLLECT)
 extern size_t Storage_flush(Storage_t *storage);
 #endif  /* TOFU_STORAGE_AUTO_COLLECT */
 
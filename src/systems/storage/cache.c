@@ -47,12 +47,24 @@
 
 #include <stdbool.h>
 
+// Look-ups are performed from the storage loader threads, too, so we can't use `shgeti()` as it writes into the map
+// header. The thread-safe variant isn't wrapped by a macro for string-keyed maps, we need to call it directly.
+static inline ptrdiff_t _find(Storage_Cache_Entry_t *entries, const char *name)
+{
+    if (!entries) {
+        return -1;
+    }
+    ptrdiff_t index;
+    stbds_hmget_key_ts(entries, sizeof(Storage_Cache_Entry_t), (void *)name, sizeof(char *), &index, STBDS_HM_STRING);
+    return index;
+}
+
 static bool _cache_contains(void *user_data, const char *name)
 {
     Storage_Cache_t *cache = (Storage_Cache_t *)user_data;
     Storage_Cache_Entry_t *entries = cache->entries;
 
-    return shgeti(entries, name) != -1;
+    return _find(entries, name) != -1;
 }
 
 static void *_cache_open(void *user_data, const char *name)
@@ -60,7 +72,7 @@ static void *_cache_open(void *user_data, const char *name)
     Storage_Cache_t *cache = (Storage_Cache_t *)user_data;
     Storage_Cache_Entry_t *entries = cache->entries;
 
-    int index = shgeti(entries, name);
+    ptrdiff_t index = _find(entries, name);
     if (index == -1) {
         return NULL;
     }
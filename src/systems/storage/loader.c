@@ -0,0 +1,203 @@
+/*
+ *                 ___________________  _______________ ___
+ *                 \__    ___/\_____  \ \_   _____/    |   \
+ *                   |    |    /   |   \ |    __) |    |   /
+ *                   |    |   /    |    \|     \  |    |  /
+ *                   |____|   \_______  /\___  /  |______/
+ *                                    \/     \/
+ *         ___________ _______    ________.___ _______  ___________
+ *         \_   _____/ \      \  /  _____/|   |\      \ \_   _____/
+ *          |    __)_  /   |   \/   \  ___|   |/   |   \ |    __)_
+ *          |        \/    |    \    \_\  \   /    |    \|        \
+ *         /_______  /\____|__  /\______  /___\____|__  /_______  /
+ *                 \/         \/        \/            \/        \
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2019-2024 Marco Lizza
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "loader.h"
+
+#include <core/config.h>
+#define _LOG_TAG "storage-loader"
+#include <libs/log.h>
+#include <libs/stb.h>
+
+#include <string.h>
+
+static void *_loader(void *arg)
+{
+    Storage_Loader_t *loader = (Storage_Loader_t *)arg;
+
+    pthread_mutex_lock(&loader->lock);
+    for (;;) {
+        while (!loader->quit && loader->next >= arrlenu(loader->pending)) {
+            pthread_cond_wait(&loader->wake, &loader->lock);
+        }
+        if (loader->quit) {
+            break;
+        }
+
+        Storage_Loader_Request_t request = loader->pending[loader->next++];
+        if (loader->next == arrlenu(loader->pending)) { // Every request has been picked, recycle the array.
+            static const size_t zero = 0; // Note: we don't pass the immediate `0` to avoid a "type-limit" warning from the compiler.
+            arrsetlen(loader->pending, zero);
+            loader->next = 0;
+        }
+
+        pthread_mutex_unlock(&loader->lock);
+        request.data = loader->function(loader->user_data, request.name, request.kind);
+        pthread_mutex_lock(&loader->lock);
+
+        arrpush(loader->completed, request);
+    }
+    pthread_mutex_unlock(&loader->lock);
+
+    return NULL;
+}
+
+Storage_Loader_t *Storage_Loader_create(size_t threads, Storage_Loader_Function_t function, void *user_data)
+{
+    Storage_Loader_t *loader = malloc(sizeof(Storage_Loader_t));
+    if (!loader) {
+        LOG_E("can't allocate loader");
+        goto error_exit;
+    }
+
+    pthread_t *handles = malloc(sizeof(pthread_t) * threads);
+    if (!handles) {
+        LOG_E("can't allocate %zu threads", threads);
+        goto error_free_loader;
+    }
+
+    *loader = (Storage_Loader_t){
+            .function = function,
+            .user_data = user_data,
+            .threads = handles,
+            .count = 0,
+            .quit = false,
+            .pending = NULL,
+            .next = 0,
+            .completed = NULL
+        };
+
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_cond_init(&loader->wake, NULL);
+
+    for (size_t i = 0; i < threads; ++i) {
+        if (pthread_create(&loader->threads[i], NULL, _loader, loader) != 0) {
+            LOG_W("can't create loader thread #%d, continuing with %d threads", i, i);
+            break;
+        }
+        loader->count += 1;
+    }
+
+    if (loader->count == 0) {
+        LOG_E("can't create any loader thread");
+        goto error_free_threads;
+    }
+
+    LOG_D("loader %p created w/ %d threads", loader, loader->count);
+
+    return loader;
+
+error_free_threads:
+    pthread_cond_destroy(&loader->wake);
+    pthread_mutex_destroy(&loader->lock);
+    free(handles);
+error_free_loader:
+    free(loader);
+error_exit:
+    return NULL;
+}
+
+void Storage_Loader_stop(Storage_Loader_t *loader)
+{
+    pthread_mutex_lock(&loader->lock);
+    loader->quit = true;
+    pthread_cond_broadcast(&loader->wake);
+    pthread_mutex_unlock(&loader->lock);
+
+    for (size_t i = 0; i < loader->count; ++i) {
+        pthread_join(loader->threads[i], NULL);
+    }
+    loader->count = 0;
+    LOG_D("loader threads joined");
+
+    LOG_IF_D(loader->next < arrlenu(loader->pending), "%d pending requests discarded", arrlenu(loader->pending) - loader->next);
+}
+
+void Storage_Loader_destroy(Storage_Loader_t *loader)
+{
+    if (loader->count > 0) {
+        Storage_Loader_stop(loader);
+    }
+
+    pthread_cond_destroy(&loader->wake);
+    pthread_mutex_destroy(&loader->lock);
+
+    arrfree(loader->completed);
+    arrfree(loader->pending);
+    LOG_D("loader requests freed");
+
+    free(loader->threads);
+    LOG_D("loader threads freed");
+
+    free(loader);
+    LOG_D("loader %p freed", loader);
+}
+
+bool Storage_Loader_enqueue(Storage_Loader_t *loader, const char *name, int kind)
+{
+    if (strlen(name) >= PLATFORM_PATH_MAX) {
+        LOG_E("name `%s` is too long", name);
+        return false;
+    }
+
+    Storage_Loader_Request_t request = (Storage_Loader_Request_t){
+            .name = { 0 },
+            .kind = kind,
+            .data = NULL
+        };
+    strcpy(request.name, name);
+
+    pthread_mutex_lock(&loader->lock);
+    arrpush(loader->pending, request);
+    pthread_cond_signal(&loader->wake);
+    pthread_mutex_unlock(&loader->lock);
+
+    return true;
+}
+
+size_t Storage_Loader_collect(Storage_Loader_t *loader, Storage_Loader_Request_t **requests)
+{
+    static const size_t zero = 0; // Note: we don't pass the immediate `0` to avoid a "type-limit" warning from the compiler.
+    arrsetlen(*requests, zero);
+
+    pthread_mutex_lock(&loader->lock);
+    Storage_Loader_Request_t *completed = loader->completed;
+    loader->completed = *requests; // Swap the arrays, so that no copy (nor allocation) is required.
+    *requests = completed;
+    pthread_mutex_unlock(&loader->lock);
+
+    return arrlenu(*requests);
+}
@@ -0,0 +1,82 @@
+/*
+ *                 ___________________  _______________ ___
+ *                 \__    ___/\_____  \ \_   _____/    |   \
+ *                   |    |    /   |   \ |    __) |    |   /
+ *                   |    |   /    |    \|     \  |    |  /
+ *                   |____|   \_______  /\___  /  |______/
+ *                                    \/     \/
+ *         ___________ _______    ________.___ _______  ___________
+ *         \_   _____/ \      \  /  _____/|   |\      \ \_   _____/
+ *          |    __)_  /   |   \/   \  ___|   |/   |   \ |    __)_
+ *          |        \/    |    \    \_\  \   /    |    \|        \
+ *         /_______  /\____|__  /\______  /___\____|__  /_______  /
+ *                 \/         \/        \/            \/        \
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2019-2024 Marco Lizza
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TOFU_SYSTEMS_STORAGE_LOADER_H
+#define TOFU_SYSTEMS_STORAGE_LOADER_H
+
+#include <core/platform.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Loads (and decodes) the named resource of the given kind, returning `NULL` on failure. Called from the loader
+// threads, so it is required to be thread-safe.
+typedef void *(*Storage_Loader_Function_t)(void *user_data, const char *name, int kind);
+
+typedef struct Storage_Loader_Request_s {
+    char name[PLATFORM_PATH_MAX];
+    int kind;
+    void *data; // Outcome of the load function, `NULL` on failure.
+} Storage_Loader_Request_t;
+
+typedef struct Storage_Loader_s {
+    Storage_Loader_Function_t function;
+    void *user_data;
+
+    pthread_t *threads;
+    size_t count;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool quit;
+
+    Storage_Loader_Request_t *pending;
+    size_t next; // Next pending request to be picked.
+    Storage_Loader_Request_t *completed;
+} Storage_Loader_t;
+
+extern Storage_Loader_t *Storage_Loader_create(size_t threads, Storage_Loader_Function_t function, void *user_data);
+// Requests not yet picked are discarded, while the ones being processed are waited for. The completed requests are
+// to be collected (and their data released) *before* destroying the loader.
+extern void Storage_Loader_stop(Storage_Loader_t *loader);
+extern void Storage_Loader_destroy(Storage_Loader_t *loader);
+
+extern bool Storage_Loader_enqueue(Storage_Loader_t *loader, const char *name, int kind);
+// Moves the completed requests into the `requests` array (which is emptied first), returning their amount.
+extern size_t Storage_Loader_collect(Storage_Loader_t *loader, Storage_Loader_Request_t **requests);
+
+#endif  /* TOFU_SYSTEMS_STORAGE_LOADER_H */